@@ -103,6 +103,26 @@ check_cxx_source_compiles("
   }
 " HAVE_ISO_STRDUP)
 
+# Determine whether the system can move file contents inside the kernel.
+
+check_cxx_source_compiles("
+  #include <unistd.h>
+  int main() {
+    off_t in = 0, out = 0;
+    copy_file_range(0, &in, 0, &out, 0, 0);
+    return 0;
+  }
+" HAVE_COPY_FILE_RANGE)
+
+check_cxx_source_compiles("
+  #include <fcntl.h>
+  int main() {
+    fallocate(0, FALLOC_FL_INSERT_RANGE, 0, 0);
+    fallocate(0, FALLOC_FL_COLLAPSE_RANGE, 0, 0);
+    return 0;
+  }
+" HAVE_FALLOCATE_RANGE)
+
 # Detect WinRT mode
 if(CMAKE_SYSTEM_NAME STREQUAL "WindowsStore")
   set(PLATFORM_WINRT 1)
@@ -0,0 +1,143 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+// Compares the vectorized kernels in tsimd.cpp with their scalar versions.
+// The kernels are not exported from the library, so tsimd.cpp is compiled
+// into this program.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tsimd.h"
+
+using namespace TagLib;
+
+namespace
+{
+  // Prevents the compiler from dropping the results of the measured calls.
+  volatile size_t sink;
+
+  // Returns the time of one call in nanoseconds, the best of a few runs.
+  double measure(const std::function<size_t()> &function, size_t bytes)
+  {
+    // About 64 MiB are processed per run.
+    const size_t iterations = std::max<size_t>(1000, (size_t(64) << 20) / bytes);
+
+    double best = 0;
+    for(int run = 0; run < 5; ++run) {
+      const auto start = std::chrono::steady_clock::now();
+      size_t result = 0;
+      for(size_t i = 0; i < iterations; ++i)
+        result += function();
+      const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+      sink = result;
+
+      const double time = elapsed.count() / static_cast<double>(iterations);
+      if(run == 0 || time < best)
+        best = time;
+    }
+    return best;
+  }
+
+  void report(const char *name, size_t size,
+              const std::function<size_t()> &scalar,
+              const std::function<size_t()> &vectorized, size_t bytes)
+  {
+    const double scalarTime = measure(scalar, bytes);
+    const double vectorizedTime = measure(vectorized, bytes);
+    std::printf("%-16s %8zu %12.1f %12.1f %8.2fx\n", name, size,
+                scalarTime, vectorizedTime, scalarTime / vectorizedTime);
+  }
+
+  void benchmark(size_t size)
+  {
+    // Tag data without the searched patterns, and ASCII text ending in a
+    // non-ASCII character, which is the usual case for the text kernels.
+
+    std::vector<char> data(size);
+    for(size_t i = 0; i < size; ++i)
+      data[i] = static_cast<char>(i * 7 % 0xF0);
+    const char *const begin = data.data();
+    const char *const end = begin + size;
+    const char pattern[] = "TXXX";
+
+    std::string text(size, 0);
+    for(size_t i = 0; i < size; ++i)
+      text[i] = static_cast<char>('a' + i % 26);
+    text.back() = static_cast<char>(0xE9);
+    std::wstring wideText(size, 0);
+    Simd::widenScalar(text.data(), size, wideText.data());
+    std::vector<wchar_t> wide(size);
+    std::vector<char> narrow(size);
+
+    report("find", size,
+      [&] { return static_cast<size_t>(Simd::findScalar(begin, end, pattern, 4) != nullptr); },
+      [&] { return static_cast<size_t>(Simd::find(begin, end, pattern, 4) != nullptr); },
+      size);
+    report("rfind", size,
+      [&] { return static_cast<size_t>(Simd::rfindScalar(begin, end, pattern, 4) != nullptr); },
+      [&] { return static_cast<size_t>(Simd::rfind(begin, end, pattern, 4) != nullptr); },
+      size);
+    report("findFrameSync", size,
+      [&] { return static_cast<size_t>(Simd::findFrameSyncScalar(begin, end) != nullptr); },
+      [&] { return static_cast<size_t>(Simd::findFrameSync(begin, end) != nullptr); },
+      size);
+    report("rfindFrameSync", size,
+      [&] { return static_cast<size_t>(Simd::rfindFrameSyncScalar(begin, end) != nullptr); },
+      [&] { return static_cast<size_t>(Simd::rfindFrameSync(begin, end) != nullptr); },
+      size);
+    report("asciiLength", size,
+      [&] { return Simd::asciiLengthScalar(text.data(), text.data() + size); },
+      [&] { return Simd::asciiLength(text.data(), text.data() + size); },
+      size);
+    report("widen", size,
+      [&] { Simd::widenScalar(text.data(), size, wide.data()); return size_t(wide[size / 2]); },
+      [&] { Simd::widen(text.data(), size, wide.data()); return size_t(wide[size / 2]); },
+      size);
+    report("narrowAscii", size,
+      [&] { return Simd::narrowAsciiScalar(wideText.data(), size, narrow.data()); },
+      [&] { return Simd::narrowAscii(wideText.data(), size, narrow.data()); },
+      size);
+  }
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+  std::vector<size_t> sizes;
+  for(int i = 1; i < argc; ++i)
+    sizes.push_back(static_cast<size_t>(std::strtoul(argv[i], nullptr, 10)));
+  if(sizes.empty())
+    sizes = { 16, 64, 1024, 65536 };
+
+  std::printf("Instruction set: %s\n\n", Simd::instructionSet());
+  std::printf("%-16s %8s %12s %12s %9s\n", "kernel", "bytes", "scalar ns", "simd ns", "speedup");
+  for(size_t size : sizes) {
+    if(size > 0)
+      benchmark(size);
+  }
+
+  return 0;
+}
@@ -13,6 +13,12 @@
 /* Defined if your compiler supports ISO _strdup */
 #cmakedefine   HAVE_ISO_STRDUP 1
 
+/* Defined if copy_file_range() is available */
+#cmakedefine   HAVE_COPY_FILE_RANGE 1
+
+/* Defined if fallocate() supports inserting and collapsing ranges */
+#cmakedefine   HAVE_FALLOCATE_RANGE 1
+
 /* Defined if zlib is installed */
 #cmakedefine   HAVE_ZLIB 1
 
@@ -39,6 +39,8 @@ public:
   Item::ItemTypes type { Text };
   String key;
   ByteVector value;
+  // Moved into value when it is requested for the first time.
+  DeferredData deferredValue;
   StringList text;
   bool readOnly { false };
 };
@@ -119,6 +121,10 @@ String APE::Item::key() const
 
 ByteVector APE::Item::binaryData() const
 {
+  if(!d->deferredValue.isNull()) {
+    d->value = d->deferredValue.data();
+    d->deferredValue = DeferredData();
+  }
   return d->value;
 }
 
@@ -126,6 +132,7 @@ void APE::Item::setBinaryData(const ByteVector &value)
 {
   d->type = Binary;
   d->value = value;
+  d->deferredValue = DeferredData();
   d->text.clear();
 }
 
@@ -139,6 +146,7 @@ void APE::Item::setValue(const String &value)
   d->type = Text;
   d->text = value;
   d->value.clear();
+  d->deferredValue = DeferredData();
 }
 
 void APE::Item::setValues(const StringList &values)
@@ -146,6 +154,7 @@ void APE::Item::setValues(const StringList &values)
   d->type = Text;
   d->text = values;
   d->value.clear();
+  d->deferredValue = DeferredData();
 }
 
 void APE::Item::appendValue(const String &value)
@@ -153,6 +162,7 @@ void APE::Item::appendValue(const String &value)
   d->type = Text;
   d->text.append(value);
   d->value.clear();
+  d->deferredValue = DeferredData();
 }
 
 void APE::Item::appendValues(const StringList &values)
@@ -160,6 +170,7 @@ void APE::Item::appendValues(const StringList &values)
   d->type = Text;
   d->text.append(values);
   d->value.clear();
+  d->deferredValue = DeferredData();
 }
 
 int APE::Item::size() const
@@ -177,7 +188,8 @@ int APE::Item::size() const
 
     case Binary:
     case Locator:
-      result += d->value.size();
+      result += d->deferredValue.isNull()
+        ? d->value.size() : static_cast<unsigned int>(d->deferredValue.size());
       break;
   }
   return result;
@@ -204,7 +216,7 @@ bool APE::Item::isEmpty() const
       return d->text.size() == 1 && d->text.front().isEmpty();
     case Binary:
     case Locator:
-      return d->value.isEmpty();
+      return d->value.isEmpty() && d->deferredValue.isNull();
     default:
       return false;
   }
@@ -232,6 +244,7 @@ void APE::Item::parse(const ByteVector &data)
   setReadOnly(flags & 1);
   setType(static_cast<ItemTypes>((flags >> 1) & 3));
 
+  d->deferredValue = DeferredData();
   if(Text == d->type)
     d->text = StringList(ByteVectorList::split(val, '\0'), String::UTF8);
   else
@@ -258,7 +271,7 @@ ByteVector APE::Item::render() const
     d->value = val;
   }
   else
-    val.append(d->value);
+    val.append(binaryData());
 
   data.append(ByteVector::fromUInt(val.size(), false));
   data.append(ByteVector::fromUInt(flags, false));
@@ -268,3 +281,13 @@ ByteVector APE::Item::render() const
 
   return data;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+void APE::Item::setDeferredData(const DeferredData &data)
+{
+  d->value.clear();
+  d->deferredValue = data;
+}
@@ -29,6 +29,7 @@
 #include "tbytevector.h"
 #include "tstring.h"
 #include "tstringlist.h"
+#include "tdeferreddata.h"
 
 namespace TagLib {
   namespace APE {
@@ -95,6 +96,10 @@ namespace TagLib {
       /*!
        * Returns the binary value.
        * If the item type is not \a Binary, always returns an empty ByteVector.
+       *
+       * \note A large binary value may have been skipped while reading the
+       * tag because of the limits set with IOStream::setMaxPayloadSize() or
+       * IOStream::setReadBudget(), it is read from the file now.
        */
       ByteVector binaryData() const;
 
@@ -194,6 +199,13 @@ namespace TagLib {
       bool isEmpty() const;
 
     private:
+      friend class Tag;
+
+      /*!
+       * Replaces the binary value by a reference to the value in the file.
+       */
+      void setDeferredData(const DeferredData &data);
+
       class ItemPrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<ItemPrivate> d;
@@ -33,12 +33,15 @@
 
 #include "apetag.h"
 
+#include <algorithm>
 #include <array>
+#include <map>
 #include <utility>
 
 #include "tdebug.h"
 #include "tfile.h"
 #include "tpropertymap.h"
+#include "tarena.h"
 #include "apefooter.h"
 #include "apeitem.h"
 
@@ -51,6 +54,10 @@ namespace
   constexpr unsigned int MaxKeyLength = 255;
   constexpr unsigned int MAX_APE_ITEM_COUNT = 50000;
 
+  // Binary values which are larger are not read with the tag if the stream
+  // limits the payload size, see readDeferringBinaryItems().
+  constexpr unsigned int DeferredValueThreshold = 1024;
+
   const String FRONT_COVER("COVER ART (FRONT)");
   const String BACK_COVER("COVER ART (BACK)");
 
@@ -74,6 +81,9 @@ public:
 
   Footer footer;
   ItemListMap itemListMap;
+  // Values of binary items left in the file while reading, by position of
+  // the item in the data passed to parse().
+  std::map<unsigned int, DeferredData> deferredItems;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -432,6 +442,8 @@ void APE::Tag::read()
 {
   if(d->file && d->file->isValid()) {
 
+    const Arena::Scope arenaScope(d->file);
+
     d->file->seek(d->footerLocation);
     d->footer.setData(d->file->readBlock(Footer::size()));
 
@@ -439,8 +451,16 @@ void APE::Tag::read()
        d->footer.tagSize() > static_cast<unsigned long>(d->file->length()))
       return;
 
-    d->file->seek(d->footerLocation + Footer::size() - d->footer.tagSize());
-    parse(d->file->readBlock(d->footer.tagSize() - Footer::size()));
+    const offset_t dataOffset = d->footerLocation + Footer::size() - d->footer.tagSize();
+    const unsigned int dataLength = d->footer.tagSize() - Footer::size();
+    if(d->file->deferPayload(dataLength)) {
+      parse(readDeferringBinaryItems(dataOffset, dataLength));
+      d->deferredItems.clear();
+    }
+    else {
+      d->file->seek(dataOffset);
+      parse(d->file->readBlock(dataLength));
+    }
   }
 }
 
@@ -497,6 +517,8 @@ void APE::Tag::parse(const ByteVector &data)
     {
       APE::Item item;
       item.parse(data.mid(pos));
+      if(const auto it = d->deferredItems.find(pos); it != d->deferredItems.end())
+        item.setDeferredData(it->second);
 
       d->itemListMap.insert(item.key().upper(), item);
     }
@@ -507,3 +529,52 @@ void APE::Tag::parse(const ByteVector &data)
     pos += keyLength + valLength + 9;
   }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// private methods
+////////////////////////////////////////////////////////////////////////////////
+
+ByteVector APE::Tag::readDeferringBinaryItems(offset_t offset, unsigned int length)
+{
+  // Only the headers of large binary items (usually cover art) are read, the
+  // value length is set to zero in the returned data and the values are
+  // recorded to be read when they are requested.  If an item looks broken,
+  // the rest of the tag is read as is and left to parse().
+
+  ByteVector data;
+  unsigned int pos = 0;
+
+  for(unsigned int i = 0; i < d->footer.itemCount() && length - pos >= 11; i++) {
+    d->file->seek(offset + pos);
+    const ByteVector header = d->file->readBlock(std::min(8 + MaxKeyLength + 1, length - pos));
+    const int nullPos = header.find('\0', 8);
+    if(nullPos < 0)
+      break;
+
+    const unsigned int headerLength = nullPos + 1;
+    const unsigned int valueLength = header.toUInt(0, false);
+    const unsigned int flags = header.toUInt(4, false);
+    if(valueLength > length - pos - headerLength)
+      break;
+
+    if(((flags >> 1) & 3) == Item::Binary && valueLength > DeferredValueThreshold) {
+      d->deferredItems[data.size()] =
+        d->file->deferData(offset + pos + headerLength, valueLength);
+      data.append(ByteVector::fromUInt(0, false));
+      data.append(header.mid(4, headerLength - 4));
+    }
+    else {
+      d->file->seek(offset + pos);
+      data.append(d->file->readBlock(headerLength + valueLength));
+    }
+
+    pos += headerLength + valueLength;
+  }
+
+  if(pos < length) {
+    d->file->seek(offset + pos);
+    data.append(d->file->readBlock(length - pos));
+  }
+
+  return data;
+}
@@ -203,6 +203,12 @@ namespace TagLib {
       void parse(const ByteVector &data);
 
     private:
+      /*!
+       * Reads the \a length bytes of items at \a offset, leaving the values
+       * of large binary items in the file.
+       */
+      ByteVector readDeferringBinaryItems(offset_t offset, unsigned int length);
+
       class TagPrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<TagPrivate> d;
@@ -32,6 +32,13 @@
 
 using namespace TagLib;
 
+namespace
+{
+  // Number of bytes read from a picture which is too large to be read
+  // completely, it has to contain all fields in front of the image data.
+  constexpr unsigned int DeferredPictureFieldsLength = 1024;
+}  // namespace
+
 class ASF::Attribute::AttributePrivate
 {
 public:
@@ -227,11 +234,22 @@ String ASF::Attribute::parse(ASF::File &file, int kind)
 
   case BytesType:
   case GuidType:
+    if(d->type == BytesType && name == "WM/Picture" &&
+       size > DeferredPictureFieldsLength && file.deferPayload(size)) {
+      const offset_t offset = file.tell();
+      d->pictureValue.parse(file.readBlock(DeferredPictureFieldsLength),
+                            &file, offset, size);
+      if(d->pictureValue.isValid()) {
+        file.seek(offset + size);
+        break;
+      }
+      file.seek(offset);
+    }
     d->byteVectorValue = file.readBlock(size);
     break;
   }
 
-  if(d->type == BytesType && name == "WM/Picture") {
+  if(d->type == BytesType && name == "WM/Picture" && !d->pictureValue.isValid()) {
     d->pictureValue.parse(d->byteVectorValue);
     if(d->pictureValue.isValid()) {
       d->byteVectorValue.clear();
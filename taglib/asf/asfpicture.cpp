@@ -38,6 +38,8 @@ public:
   String mimeType;
   String description;
   ByteVector picture;
+  // Used instead of picture if the image was not read with the attribute.
+  DeferredData deferredPicture;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -90,19 +92,39 @@ void ASF::Picture::setDescription(const String &desc)
 
 ByteVector ASF::Picture::picture() const
 {
-  return d->picture;
+  return d->deferredPicture.isNull() ? d->picture : d->deferredPicture.data();
 }
 
 void ASF::Picture::setPicture(const ByteVector &p)
 {
   d->picture = p;
+  d->deferredPicture = DeferredData();
+}
+
+bool ASF::Picture::writePicture(IOStream *sink) const
+{
+  if(!d->deferredPicture.isNull())
+    return d->deferredPicture.writeTo(sink);
+
+  if(!sink)
+    return false;
+
+  sink->writeBlock(d->picture);
+  return true;
+}
+
+bool ASF::Picture::isDataDeferred() const
+{
+  return !d->deferredPicture.isNull() && !d->deferredPicture.isLoaded();
 }
 
 int ASF::Picture::dataSize() const
 {
+  const auto pictureSize = d->deferredPicture.isNull()
+    ? d->picture.size() : static_cast<unsigned int>(d->deferredPicture.size());
   return
     9 + (d->mimeType.length() + d->description.length()) * 2 +
-    d->picture.size();
+    pictureSize;
 }
 
 ASF::Picture &ASF::Picture::operator=(const ASF::Picture &) = default;
@@ -119,47 +141,77 @@ ByteVector ASF::Picture::render() const
   if(!isValid())
     return ByteVector();
 
+  const ByteVector data = picture();
   return
     ByteVector(static_cast<char>(d->type)) +
-    ByteVector::fromUInt(d->picture.size(), false) +
+    ByteVector::fromUInt(data.size(), false) +
     renderString(d->mimeType) +
     renderString(d->description) +
-    d->picture;
+    data;
 }
 
 void ASF::Picture::parse(const ByteVector& bytes)
 {
   d->valid = false;
-  if(bytes.size() < 9)
+  unsigned int dataLen = 0;
+  const int pos = parseFields(bytes, dataLen);
+  if(pos < 0 || dataLen + pos != bytes.size())
+    return;
+
+  d->picture = bytes.mid(pos, dataLen);
+  d->deferredPicture = DeferredData();
+  d->valid = true;
+}
+
+void ASF::Picture::parse(const ByteVector &bytes, TagLib::File *file,
+                         offset_t offset, unsigned int size)
+{
+  // bytes is only the beginning of the attribute value, the image data is
+  // left in the file.
+
+  d->valid = false;
+  unsigned int dataLen = 0;
+  const int pos = parseFields(bytes, dataLen);
+  if(pos < 0 || dataLen + pos != size)
     return;
+
+  d->picture.clear();
+  d->deferredPicture = file->deferData(offset + pos, dataLen);
+  d->valid = true;
+}
+
+ASF::Picture ASF::Picture::fromInvalid()
+{
+  Picture ret;
+  ret.d->valid = false;
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+int ASF::Picture::parseFields(const ByteVector &bytes, unsigned int &dataLength)
+{
+  if(bytes.size() < 9)
+    return -1;
   int pos = 0;
   d->type = typeFromByte(bytes[0]); ++pos;
-  const unsigned int dataLen = bytes.toUInt(pos, false); pos+=4;
+  dataLength = bytes.toUInt(pos, false); pos+=4;
 
   const ByteVector nullStringTerminator(2, 0);
 
   int endPos = bytes.find(nullStringTerminator, pos, 2);
   if(endPos < 0)
-    return;
+    return -1;
   d->mimeType = String(bytes.mid(pos, endPos - pos), String::UTF16LE);
   pos = endPos+2;
 
   endPos = bytes.find(nullStringTerminator, pos, 2);
   if(endPos < 0)
-    return;
+    return -1;
   d->description = String(bytes.mid(pos, endPos - pos), String::UTF16LE);
   pos = endPos+2;
 
-  if(dataLen + pos != bytes.size())
-    return;
-
-  d->picture = bytes.mid(pos, dataLen);
-  d->valid = true;
-}
-
-ASF::Picture ASF::Picture::fromInvalid()
-{
-  Picture ret;
-  ret.d->valid = false;
-  return ret;
+  return pos;
 }
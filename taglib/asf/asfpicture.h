@@ -30,6 +30,7 @@
 #include "tbytevector.h"
 #include "tpicturetype.h"
 #include "taglib_export.h"
+#include "tdeferreddata.h"
 
 namespace TagLib
 {
@@ -138,6 +139,9 @@ namespace TagLib
        * \note ByteVector has a data() method that returns a <tt>const char *</tt> which
        * should make it easy to export this data to external programs.
        *
+       * \note If the data was skipped while reading the file, it is read from
+       * the file now, see isDataDeferred().
+       *
        * \see setPicture()
        * \see mimeType()
        */
@@ -153,6 +157,23 @@ namespace TagLib
        */
       void setPicture(const ByteVector &p);
 
+      /*!
+       * Writes the image data to \a sink at its current position.  If the
+       * data was skipped while reading the file, it is streamed from the file
+       * without being kept in memory.  Returns \c false if the data could
+       * not be read.
+       *
+       * \see picture()
+       */
+      bool writePicture(IOStream *sink) const;
+
+      /*!
+       * Returns \c true if the image data was not read from the file because
+       * of the limits set with IOStream::setMaxPayloadSize() or
+       * IOStream::setReadBudget().  It is loaded when picture() is called.
+       */
+      bool isDataDeferred() const;
+
       /*!
        * Returns picture as binary raw data \a value
        */
@@ -166,10 +187,15 @@ namespace TagLib
 #ifndef DO_NOT_DOCUMENT
       /* THIS IS PRIVATE, DON'T TOUCH IT! */
       void parse(const ByteVector& );
+      void parse(const ByteVector &bytes, TagLib::File *file, offset_t offset,
+                 unsigned int size);
       static Picture fromInvalid();
 #endif
 
       private:
+        int parseFields(const ByteVector &bytes, unsigned int &dataLength);
+
+
         class PicturePrivate;
         TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
         std::shared_ptr<PicturePrivate> d;
@@ -29,15 +29,30 @@
 
 #include "fileref.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "taglib_config.h"
 #include "tfilestream.h"
+#include "tmmapstream.h"
 #include "tpropertymap.h"
 #include "tstringlist.h"
 #include "tvariant.h"
+#include "tbytevectorstream.h"
 #include "tdebug.h"
+#include "id3v1tag.h"
+#include "id3v2header.h"
 #include "mpegfile.h"
 #ifdef TAGLIB_WITH_RIFF
 #include "aifffile.h"
@@ -93,7 +108,62 @@ class FileRef::StreamTypeResolver::StreamTypeResolverPrivate
 
 namespace
 {
-  List<const FileRef::FileTypeResolver *> fileTypeResolvers;
+  using namespace std::string_view_literals;
+
+  // The resolvers may be changed while files are opened in other threads.
+  // A published set of resolvers is never modified.  Readers atomically load
+  // a pointer to the current set without locking, writers are serialized by
+  // a mutex and publish a modified copy.  The replaced sets are kept until
+  // the registry is destroyed at exit, because readers may still use them;
+  // the resolvers are rarely changed, so they do not add up.
+
+  struct Resolvers {
+    std::vector<const FileRef::FileTypeResolver *> fileTypeResolvers;
+
+    // The resolvers in fileTypeResolvers which can also create files from
+    // streams, they are sorted out when they are added.
+
+    std::vector<const FileRef::StreamTypeResolver *> streamTypeResolvers;
+  };
+
+  class ResolverRegistry
+  {
+  public:
+    ResolverRegistry()
+    {
+      sets.push_back(std::make_unique<const Resolvers>());
+      current.store(sets.back().get(), std::memory_order_release);
+    }
+
+    const Resolvers *load() const
+    {
+      return current.load(std::memory_order_acquire);
+    }
+
+    template <class Modify>
+    void update(const Modify &modify)
+    {
+      std::lock_guard<std::mutex> lock(writeMutex);
+      auto updated = std::make_unique<Resolvers>(*load());
+      modify(*updated);
+      sets.push_back(std::move(updated));
+      current.store(sets.back().get(), std::memory_order_release);
+    }
+
+  private:
+    std::atomic<const Resolvers *> current { nullptr };
+    // All sets which have been published, guarded by writeMutex.
+    std::vector<std::unique_ptr<const Resolvers>> sets;
+    std::mutex writeMutex;
+  };
+
+  // Constructed on first use, resolvers may be added by static initializers.
+
+  ResolverRegistry &resolverRegistry()
+  {
+    static ResolverRegistry registry;
+    return registry;
+  }
 
   // Detect the file type by user-defined resolvers.
 
@@ -107,7 +177,8 @@ namespace
     if(::strlen(fileName) == 0)
       return nullptr;
 #endif
-    for(const auto &resolver : std::as_const(fileTypeResolvers)) {
+    const auto resolvers = resolverRegistry().load();
+    for(const auto &resolver : resolvers->fileTypeResolvers) {
       File *file = resolver->createFile(fileName, readAudioProperties, audioPropertiesStyle);
       if(file)
         return file;
@@ -119,192 +190,376 @@ namespace
   File *detectByResolvers(IOStream* stream, bool readAudioProperties,
                           AudioProperties::ReadStyle audioPropertiesStyle)
   {
-    for(const auto &resolver : std::as_const(fileTypeResolvers)) {
-      if(auto streamResolver = dynamic_cast<const FileRef::StreamTypeResolver *>(resolver)) {
-        if(File *file = streamResolver->createFileFromStream(
-             stream, readAudioProperties, audioPropertiesStyle))
-          return file;
-      }
+    const auto resolvers = resolverRegistry().load();
+    for(const auto &resolver : resolvers->streamTypeResolvers) {
+      if(File *file = resolver->createFileFromStream(
+           stream, readAudioProperties, audioPropertiesStyle))
+        return file;
     }
 
     return nullptr;
   }
 
-  // Detect the file type based on the file extension.
+  ////////////////////////////////////////////////////////////////////////////////
+  // built-in file types
+  ////////////////////////////////////////////////////////////////////////////////
 
-  File* detectByExtension(IOStream *stream, bool readAudioProperties,
-                          AudioProperties::ReadStyle audioPropertiesStyle)
-  {
-#ifdef _WIN32
-    const String s = stream->name().toString();
-#else
-    const String s(stream->name());
-#endif
+  using FileFactory = File *(*)(IOStream *, bool, AudioProperties::ReadStyle);
 
-    String ext;
-    if(const int pos = s.rfind("."); pos != -1)
-      ext = s.substr(pos + 1).upper();
+  template <class T>
+  File *createFile(IOStream *stream, bool readAudioProperties,
+                   AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+    return new T(stream, readAudioProperties, audioPropertiesStyle);
+  }
 
-    // If this list is updated, the method defaultFileExtensions() should also be
-    // updated.  However at some point that list should be created at the same time
-    // that a default file type resolver is created.
+#ifdef TAGLIB_WITH_VORBIS
+  // .oga can be any audio in the Ogg container.  First try FLAC, then Vorbis.
 
-    if(ext.isEmpty())
-      return nullptr;
+  File *createOggAudioFile(IOStream *stream, bool readAudioProperties,
+                           AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+    File *file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
+    if(!file->isValid()) {
+      delete file;
+      file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
+    }
+    return file;
+  }
+#endif
 
-    // .oga can be any audio in the Ogg container. So leave it to content-based detection.
+  // The file types which can be created by FileRef.  Types which are not
+  // compiled in are left out, so they can still be recognized by probe() but
+  // not be opened.
 
-    File *file = nullptr;
+  struct FileTypeFactory {
+    FileRef::FileType type;
+    FileFactory create;
+  };
 
-    if(ext == "MP3" || ext == "MP2" || ext == "AAC")
-      file = new MPEG::File(stream, readAudioProperties, audioPropertiesStyle);
+  constexpr FileTypeFactory fileTypeFactories[] = {
+    { FileRef::FileType::MPEG, createFile<MPEG::File> },
 #ifdef TAGLIB_WITH_VORBIS
-    else if(ext == "OGG")
-      file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "OGA") {
-      /* .oga can be any audio in the Ogg container. First try FLAC, then Vorbis. */
-      file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-      if(!file->isValid()) {
-        delete file;
-        file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
-      }
-    }
-    else if(ext == "FLAC")
-      file = new FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "SPX")
-      file = new Ogg::Speex::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "OPUS")
-      file = new Ogg::Opus::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::OggVorbis, createFile<Ogg::Vorbis::File> },
+    { FileRef::FileType::OggFLAC, createFile<Ogg::FLAC::File> },
+    { FileRef::FileType::OggSpeex, createFile<Ogg::Speex::File> },
+    { FileRef::FileType::OggOpus, createFile<Ogg::Opus::File> },
+    { FileRef::FileType::FLAC, createFile<FLAC::File> },
 #endif
 #ifdef TAGLIB_WITH_APE
-    else if(ext == "MPC")
-      file = new MPC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "WV")
-      file = new WavPack::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "APE")
-      file = new APE::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::MPC, createFile<MPC::File> },
+    { FileRef::FileType::WavPack, createFile<WavPack::File> },
+    { FileRef::FileType::APE, createFile<APE::File> },
 #endif
 #ifdef TAGLIB_WITH_TRUEAUDIO
-    else if(ext == "TTA")
-      file = new TrueAudio::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::TrueAudio, createFile<TrueAudio::File> },
 #endif
 #ifdef TAGLIB_WITH_MP4
-    else if(ext == "M4A" || ext == "M4R" || ext == "M4B" || ext == "M4P" || ext == "MP4" || ext == "3G2" || ext == "M4V")
-      file = new MP4::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::MP4, createFile<MP4::File> },
 #endif
 #ifdef TAGLIB_WITH_ASF
-    else if(ext == "WMA" || ext == "ASF")
-      file = new ASF::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::ASF, createFile<ASF::File> },
 #endif
 #ifdef TAGLIB_WITH_RIFF
-    else if(ext == "AIF" || ext == "AIFF" || ext == "AFC" || ext == "AIFC")
-      file = new RIFF::AIFF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "WAV")
-      file = new RIFF::WAV::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::AIFF, createFile<RIFF::AIFF::File> },
+    { FileRef::FileType::WAV, createFile<RIFF::WAV::File> },
 #endif
 #ifdef TAGLIB_WITH_MOD
-    // module, nst and wow are possible but uncommon extensions
-    else if(ext == "MOD" || ext == "MODULE" || ext == "NST" || ext == "WOW")
-      file = new Mod::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "S3M")
-      file = new S3M::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "IT")
-      file = new IT::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "XM")
-      file = new XM::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::Mod, createFile<Mod::File> },
+    { FileRef::FileType::S3M, createFile<S3M::File> },
+    { FileRef::FileType::IT, createFile<IT::File> },
+    { FileRef::FileType::XM, createFile<XM::File> },
 #endif
 #ifdef TAGLIB_WITH_DSF
-    else if(ext == "DSF")
-      file = new DSF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(ext == "DFF" || ext == "DSDIFF")
-      file = new DSDIFF::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::DSF, createFile<DSF::File> },
+    { FileRef::FileType::DSDIFF, createFile<DSDIFF::File> },
 #endif
 #ifdef TAGLIB_WITH_SHORTEN
-    else if(ext == "SHN")
-      file = new Shorten::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::Shorten, createFile<Shorten::File> },
 #endif
 #ifdef TAGLIB_WITH_MATROSKA
-    else if(ext == "MKA" || ext == "MKV" || ext == "WEBM")
-      file = new Matroska::File(stream, readAudioProperties, audioPropertiesStyle);
+    { FileRef::FileType::Matroska, createFile<Matroska::File> },
 #endif
+  };
 
-    // if file is not valid, leave it to content-based detection.
-
-    if(file) {
-      if(file->isValid())
-        return file;
-      delete file;
-    }
-
-    return nullptr;
-  }
+  // The file name extensions in lowercase, in the order returned by
+  // FileRef::defaultFileExtensions().
 
-  // Detect the file type based on the actual content of the stream.
+  struct ExtensionFactory {
+    std::string_view extension;
+    FileFactory create;
+  };
 
-  File *detectByContent(IOStream *stream, bool readAudioProperties,
-                        AudioProperties::ReadStyle audioPropertiesStyle)
-  {
-    File *file = nullptr;
-
-    if(false);
+  constexpr ExtensionFactory extensionFactories[] = {
+    { "mp3"sv, createFile<MPEG::File> },
+    { "mp2"sv, createFile<MPEG::File> },
+    { "aac"sv, createFile<MPEG::File> },
 #ifdef TAGLIB_WITH_VORBIS
-    else if(Ogg::Vorbis::File::isSupported(stream))
-      file = new Ogg::Vorbis::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(Ogg::FLAC::File::isSupported(stream))
-      file = new Ogg::FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(FLAC::File::isSupported(stream))
-      file = new FLAC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(Ogg::Speex::File::isSupported(stream))
-      file = new Ogg::Speex::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(Ogg::Opus::File::isSupported(stream))
-      file = new Ogg::Opus::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "ogg"sv, createFile<Ogg::Vorbis::File> },
+    { "flac"sv, createFile<FLAC::File> },
+    { "oga"sv, createOggAudioFile },
+    { "opus"sv, createFile<Ogg::Opus::File> },
+    { "spx"sv, createFile<Ogg::Speex::File> },
 #endif
 #ifdef TAGLIB_WITH_APE
-    else if(MPC::File::isSupported(stream))
-      file = new MPC::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(WavPack::File::isSupported(stream))
-      file = new WavPack::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(APE::File::isSupported(stream))
-      file = new APE::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "mpc"sv, createFile<MPC::File> },
+    { "wv"sv, createFile<WavPack::File> },
+    { "ape"sv, createFile<APE::File> },
 #endif
 #ifdef TAGLIB_WITH_TRUEAUDIO
-    else if(TrueAudio::File::isSupported(stream))
-      file = new TrueAudio::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "tta"sv, createFile<TrueAudio::File> },
 #endif
 #ifdef TAGLIB_WITH_MP4
-    else if(MP4::File::isSupported(stream))
-      file = new MP4::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "m4a"sv, createFile<MP4::File> },
+    { "m4r"sv, createFile<MP4::File> },
+    { "m4b"sv, createFile<MP4::File> },
+    { "m4p"sv, createFile<MP4::File> },
+    { "3g2"sv, createFile<MP4::File> },
+    { "mp4"sv, createFile<MP4::File> },
+    { "m4v"sv, createFile<MP4::File> },
 #endif
 #ifdef TAGLIB_WITH_ASF
-    else if(ASF::File::isSupported(stream))
-      file = new ASF::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "wma"sv, createFile<ASF::File> },
+    { "asf"sv, createFile<ASF::File> },
 #endif
 #ifdef TAGLIB_WITH_RIFF
-    else if(RIFF::AIFF::File::isSupported(stream))
-      file = new RIFF::AIFF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(RIFF::WAV::File::isSupported(stream))
-      file = new RIFF::WAV::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "aif"sv, createFile<RIFF::AIFF::File> },
+    { "aiff"sv, createFile<RIFF::AIFF::File> },
+    { "afc"sv, createFile<RIFF::AIFF::File> },
+    { "aifc"sv, createFile<RIFF::AIFF::File> },
+    { "wav"sv, createFile<RIFF::WAV::File> },
+#endif
+#ifdef TAGLIB_WITH_MOD
+    { "mod"sv, createFile<Mod::File> },
+    // module, nst and wow are possible but uncommon extensions
+    { "module"sv, createFile<Mod::File> },
+    { "nst"sv, createFile<Mod::File> },
+    { "wow"sv, createFile<Mod::File> },
+    { "s3m"sv, createFile<S3M::File> },
+    { "it"sv, createFile<IT::File> },
+    { "xm"sv, createFile<XM::File> },
 #endif
 #ifdef TAGLIB_WITH_DSF
-    else if(DSF::File::isSupported(stream))
-      file = new DSF::File(stream, readAudioProperties, audioPropertiesStyle);
-    else if(DSDIFF::File::isSupported(stream))
-      file = new DSDIFF::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "dsf"sv, createFile<DSF::File> },
+    { "dff"sv, createFile<DSDIFF::File> },
+    { "dsdiff"sv, createFile<DSDIFF::File> },
 #endif
 #ifdef TAGLIB_WITH_SHORTEN
-    else if(Shorten::File::isSupported(stream))
-      file = new Shorten::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "shn"sv, createFile<Shorten::File> },
 #endif
 #ifdef TAGLIB_WITH_MATROSKA
-    else if(Matroska::File::isSupported(stream))
-      file = new Matroska::File(stream, readAudioProperties, audioPropertiesStyle);
+    { "mkv"sv, createFile<Matroska::File> },
+    { "mka"sv, createFile<Matroska::File> },
+    { "webm"sv, createFile<Matroska::File> },
 #endif
-    else if(MPEG::File::isSupported(stream))
-      file = new MPEG::File(stream, readAudioProperties, audioPropertiesStyle);
+  };
+
+  // Looks up the factories by index, Matroska is the last FileType.
+
+  FileFactory factoryForType(FileRef::FileType type)
+  {
+    static const auto factories = [] {
+      std::array<FileFactory, static_cast<size_t>(FileRef::FileType::Matroska) + 1> a {};
+      for(const auto &entry : fileTypeFactories)
+        a[static_cast<size_t>(entry.type)] = entry.create;
+      return a;
+    }();
+    return factories[static_cast<size_t>(type)];
+  }
+
+  // Looks up the factories for a lowercase extension in a hash table.
+
+  FileFactory factoryForExtension(const std::string &extension)
+  {
+    static const auto factories = [] {
+      std::unordered_map<std::string_view, FileFactory> m;
+      for(const auto &entry : extensionFactories)
+        m.emplace(entry.extension, entry.create);
+      return m;
+    }();
+    const auto it = factories.find(extension);
+    return it != factories.end() ? it->second : nullptr;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // signatures
+  ////////////////////////////////////////////////////////////////////////////////
+
+  // Size of the prefix read by FileRef::probe().  The signatures are searched
+  // in the first 1024 bytes like in the isSupported() methods of the file
+  // types, the rest is needed to check the frame which follows an MPEG frame
+  // header.
+
+  constexpr unsigned int ProbeSize = 4096;
+  constexpr unsigned int SignatureSize = 1024;
+
+  // Number of bytes at the end of the stream which can hold an ID3v1 tag and
+  // an APE tag footer in front of it.
+
+  constexpr unsigned int TailSize = 160;
+
+  // The data read by FileRef::probe().  audio holds the first bytes after an
+  // ID3v2 tag and is the same as head if there is no tag.
+
+  struct ProbeData {
+    const ByteVector &head;
+    const ByteVector &audio;
+    bool tagged;
+  };
+
+  // Where an ID is expected: at a fixed offset or anywhere in the first
+  // SignatureSize bytes, counted from the start of the stream or from the end
+  // of an ID3v2 tag.
+
+  constexpr int Anywhere = -1;
+  enum class Origin { Head, Audio };
+
+  struct SignatureId {
+    std::string_view id;
+    int offset;
+  };
+
+  using SignatureMatcher = FileRef::ProbeConfidence (*)(const ProbeData &);
+
+  // A signature is either an ID, optionally followed by a second ID which
+  // must also be present, or a function for formats which need more checks.
+  // An ID expected at the start which is found somewhere else lowers the
+  // confidence to Medium.
 
-    // isSupported() only does a quick check, so double check the file here.
+  struct Signature {
+    FileRef::FileType type;
+    Origin origin;
+    SignatureId first;
+    SignatureId second;
+    FileRef::ProbeConfidence confidence;
+    SignatureMatcher match;
+  };
+
+  bool containsId(const ByteVector &data, const SignatureId &id, bool *atStart = nullptr)
+  {
+    if(id.offset == Anywhere) {
+      const int pos = data.mid(0, SignatureSize).find(
+        ByteVector(id.id.data(), static_cast<unsigned int>(id.id.size())));
+      if(atStart)
+        *atStart = pos == 0;
+      return pos >= 0;
+    }
+
+    if(atStart)
+      *atStart = true;
+    return static_cast<size_t>(id.offset) + id.id.size() <= data.size() &&
+           std::memcmp(data.data() + id.offset, id.id.data(), id.id.size()) == 0;
+  }
+
+  FileRef::ProbeConfidence matchMPEG(const ProbeData &data)
+  {
+    // MPEG frame headers are easily found in unrelated binary data, so they
+    // are only a weak signature unless the stream also has tags.
+
+    if(ByteVectorStream stream(data.audio); MPEG::File::isSupported(&stream))
+      return data.tagged ? FileRef::ProbeConfidence::Medium : FileRef::ProbeConfidence::Low;
+    return FileRef::ProbeConfidence::None;
+  }
+
+  FileRef::ProbeConfidence matchMod(const ProbeData &data)
+  {
+    // A ProTracker module has no magic number at its start, only a four
+    // character ID at offset 1080.  Only the IDs written by ProTracker and
+    // the common multichannel trackers are accepted, and even those are
+    // easily found in unrelated data, so they are a weak signature.
+
+    const auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+
+    const ByteVector id = data.head.mid(1080, 4);
+    if(id.size() != 4)
+      return FileRef::ProbeConfidence::None;
+
+    if(id == "M.K." || id == "M!K!")
+      return FileRef::ProbeConfidence::Low;
+
+    // "xCHN" with 1 to 9 channels and "xxCH" with 10 to 32 channels.
+
+    if(id.containsAt("CHN", 1) && id[0] >= '1' && id[0] <= '9')
+      return FileRef::ProbeConfidence::Low;
+
+    if(id.containsAt("CH", 2) && isDigit(id[0]) && isDigit(id[1])) {
+      const int channels = (id[0] - '0') * 10 + (id[1] - '0');
+      if(channels >= 10 && channels <= 32)
+        return FileRef::ProbeConfidence::Low;
+    }
+
+    return FileRef::ProbeConfidence::None;
+  }
+
+  // The signatures in the order in which they are checked.  This is the
+  // order of the former isSupported() chain, so ambiguous data ends up with
+  // the same type.  MPEG frame headers and the ID of a ProTracker module are
+  // weak signatures, so they are checked last.
+
+  constexpr FileRef::ProbeConfidence High = FileRef::ProbeConfidence::High;
+  constexpr FileRef::ProbeConfidence Medium = FileRef::ProbeConfidence::Medium;
+
+  constexpr Signature signatures[] = {
+    { FileRef::FileType::OggVorbis, Origin::Head, { "OggS"sv, Anywhere }, { "\x01vorbis"sv, Anywhere }, High, nullptr },
+    { FileRef::FileType::OggFLAC, Origin::Head, { "OggS"sv, Anywhere }, { "fLaC"sv, Anywhere }, High, nullptr },
+    { FileRef::FileType::FLAC, Origin::Audio, { "fLaC"sv, Anywhere }, {}, High, nullptr },
+    { FileRef::FileType::OggSpeex, Origin::Head, { "OggS"sv, Anywhere }, { "Speex   "sv, Anywhere }, High, nullptr },
+    { FileRef::FileType::OggOpus, Origin::Head, { "OggS"sv, Anywhere }, { "OpusHead"sv, Anywhere }, High, nullptr },
+    { FileRef::FileType::MPC, Origin::Audio, { "MPCK"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::MPC, Origin::Audio, { "MP+"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::WavPack, Origin::Head, { "wvpk"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::APE, Origin::Audio, { "MAC "sv, Anywhere }, {}, High, nullptr },
+    { FileRef::FileType::TrueAudio, Origin::Audio, { "TTA"sv, 0 }, {}, Medium, nullptr },
+    { FileRef::FileType::MP4, Origin::Head, { "ftyp"sv, 4 }, {}, High, nullptr },
+    { FileRef::FileType::ASF, Origin::Head,
+      { "\x30\x26\xB2\x75\x8E\x66\xCF\x11\xA6\xD9\x00\xAA\x00\x62\xCE\x6C"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::AIFF, Origin::Head, { "FORM"sv, 0 }, { "AIFF"sv, 8 }, High, nullptr },
+    { FileRef::FileType::AIFF, Origin::Head, { "FORM"sv, 0 }, { "AIFC"sv, 8 }, High, nullptr },
+    { FileRef::FileType::WAV, Origin::Head, { "RIFF"sv, 0 }, { "WAVE"sv, 8 }, High, nullptr },
+    { FileRef::FileType::WAV, Origin::Head, { "RF64"sv, 0 }, { "WAVE"sv, 8 }, High, nullptr },
+    { FileRef::FileType::WAV, Origin::Head, { "BW64"sv, 0 }, { "WAVE"sv, 8 }, High, nullptr },
+    { FileRef::FileType::DSF, Origin::Head, { "DSD "sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::DSDIFF, Origin::Head, { "FRM8"sv, 0 }, { "DSD "sv, 12 }, High, nullptr },
+    { FileRef::FileType::Shorten, Origin::Head, { "ajkg"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::Matroska, Origin::Head, { "\x1A\x45\xDF\xA3"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::IT, Origin::Head, { "IMPM"sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::XM, Origin::Head, { "Extended Module: "sv, 0 }, {}, High, nullptr },
+    { FileRef::FileType::S3M, Origin::Head, { "SCRM"sv, 44 }, {}, High, nullptr },
+    { FileRef::FileType::MPEG, Origin::Audio, {}, {}, High, matchMPEG },
+    { FileRef::FileType::Mod, Origin::Head, {}, {}, High, matchMod },
+  };
+
+  FileRef::ProbeResult classify(const ProbeData &data)
+  {
+    for(const auto &signature : signatures) {
+      if(signature.match) {
+        if(const auto confidence = signature.match(data);
+           confidence != FileRef::ProbeConfidence::None)
+          return { signature.type, confidence };
+        continue;
+      }
+
+      const ByteVector &buffer = signature.origin == Origin::Head ? data.head : data.audio;
+      bool atStart = false;
+      if(containsId(buffer, signature.first, &atStart) &&
+         (signature.second.id.empty() || containsId(buffer, signature.second)))
+        return { signature.type, atStart ? signature.confidence : Medium };
+    }
 
-    if(file) {
+    return { FileRef::FileType::Unknown, FileRef::ProbeConfidence::None };
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // detection
+  ////////////////////////////////////////////////////////////////////////////////
+
+  File *createValidFile(FileFactory create, IOStream *stream, bool readAudioProperties,
+                        AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+    if(!create)
+      return nullptr;
+
+    if(File *file = create(stream, readAudioProperties, audioPropertiesStyle)) {
       if(file->isValid())
         return file;
       delete file;
@@ -313,6 +568,127 @@ namespace
     return nullptr;
   }
 
+  // Detect the file type based on the file extension.  If the file is not
+  // valid, leave it to content-based detection.
+
+  File* detectByExtension(IOStream *stream, bool readAudioProperties,
+                          AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+#ifdef _WIN32
+    const String s = stream->name().toString();
+#else
+    const String s(stream->name());
+#endif
+
+    const int pos = s.rfind(".");
+    if(pos == -1)
+      return nullptr;
+
+    std::string ext = s.substr(pos + 1).to8Bit(true);
+    if(ext.empty())
+      return nullptr;
+
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) {
+      return static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+    });
+
+    return createValidFile(factoryForExtension(ext), stream,
+                           readAudioProperties, audioPropertiesStyle);
+  }
+
+  // Detect the file type based on the actual content of the stream.  probe()
+  // only does a quick check, so the file is double checked here.
+
+  File *detectByContent(IOStream *stream, bool readAudioProperties,
+                        AudioProperties::ReadStyle audioPropertiesStyle)
+  {
+    return createValidFile(factoryForType(FileRef::probe(stream).type), stream,
+                           readAudioProperties, audioPropertiesStyle);
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // batch reading
+  ////////////////////////////////////////////////////////////////////////////////
+
+  FileRef::ReadResult readResult(const FileRef &ref)
+  {
+    FileRef::ReadResult result;
+
+    if(ref.isNull()) {
+      result.error = "Could not open the file or the file type is not supported";
+      return result;
+    }
+
+    result.properties = ref.properties();
+    for(const auto &key : ref.complexPropertyKeys())
+      result.complexProperties.insert(key, ref.complexProperties(key));
+
+    if(const AudioProperties *properties = ref.audioProperties()) {
+      result.hasAudioProperties = true;
+      result.lengthInMilliseconds = properties->lengthInMilliseconds();
+      result.bitrate = properties->bitrate();
+      result.sampleRate = properties->sampleRate();
+      result.channels = properties->channels();
+    }
+
+    result.isValid = true;
+    return result;
+  }
+
+  // Reads count files, the one at index i is opened by open(i).  Each thread
+  // takes the next index from a shared counter, so slow files do not hold up
+  // the files queued behind them.
+
+  template <class Open>
+  List<FileRef::ReadResult> readInParallel(unsigned int count, unsigned int threadCount,
+                                           const Open &open)
+  {
+    std::vector<FileRef::ReadResult> results(count);
+    std::atomic<unsigned int> next { 0 };
+
+    const auto work = [&] {
+      for(unsigned int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+        try {
+          results[i] = readResult(open(i));
+        }
+        catch(const std::exception &e) {
+          results[i].error = String(e.what(), String::UTF8);
+        }
+        catch(...) {
+          results[i].error = "Unknown error";
+        }
+      }
+    };
+
+    if(threadCount == 0)
+      threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+    threadCount = std::min(threadCount, count);
+
+    std::vector<std::thread> threads;
+    if(threadCount > 1) {
+      threads.reserve(threadCount - 1);
+      for(unsigned int i = 1; i < threadCount; ++i) {
+        try {
+          threads.emplace_back(work);
+        }
+        catch(const std::system_error &) {
+          debug("FileRef::readMany() -- Could not start a thread.");
+          break;
+        }
+      }
+    }
+
+    work();
+
+    for(auto &thread : threads)
+      thread.join();
+
+    List<FileRef::ReadResult> list;
+    for(const auto &result : results)
+      list.append(result);
+    return list;
+  }
+
 }  // namespace
 
 class FileRef::FileRefPrivate
@@ -362,6 +738,14 @@ FileRef::FileRef(FileName fileName, bool readAudioProperties,
   parse(fileName, readAudioProperties, audioPropertiesStyle);
 }
 
+FileRef::FileRef(FileName fileName, bool readAudioProperties,
+                 AudioProperties::ReadStyle audioPropertiesStyle,
+                 StreamType streamType) :
+  d(std::make_shared<FileRefPrivate>())
+{
+  parse(fileName, readAudioProperties, audioPropertiesStyle, streamType);
+}
+
 FileRef::FileRef(IOStream *stream, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle) :
   d(std::make_shared<FileRefPrivate>())
 {
@@ -455,81 +839,107 @@ bool FileRef::save()
   return d->file->save();
 }
 
+bool FileRef::saveAtomically()
+{
+  if(d->isNullWithDebugMessage(__func__)) {
+    return false;
+  }
+  return d->file->saveAtomically();
+}
+
 const FileRef::FileTypeResolver *FileRef::addFileTypeResolver(const FileRef::FileTypeResolver *resolver) // static
 {
-  fileTypeResolvers.prepend(resolver);
+  const auto streamResolver = dynamic_cast<const StreamTypeResolver *>(resolver);
+  resolverRegistry().update([&](Resolvers &resolvers) {
+    resolvers.fileTypeResolvers.insert(resolvers.fileTypeResolvers.begin(), resolver);
+    if(streamResolver)
+      resolvers.streamTypeResolvers.insert(resolvers.streamTypeResolvers.begin(), streamResolver);
+  });
   return resolver;
 }
 
 void FileRef::clearFileTypeResolvers() // static
 {
-  fileTypeResolvers.clear();
+  resolverRegistry().update([](Resolvers &resolvers) {
+    resolvers = Resolvers();
+  });
+}
+
+FileRef::ProbeResult FileRef::probe(IOStream *stream)
+{
+  if(!stream || !stream->isOpen())
+    return { FileType::Unknown, ProbeConfidence::None };
+
+  const offset_t originalPosition = stream->tell();
+
+  stream->seek(0);
+  const ByteVector head = stream->readBlock(ProbeSize);
+
+  // Some formats may be preceded by an ID3v2 tag, they are checked with the
+  // data after it.  The missing part is only read if the tag does not end
+  // early in the prefix.
+
+  ByteVector audio = head;
+  bool tagged = false;
+  if(head.size() >= ID3v2::Header::size() &&
+     head.startsWith(ID3v2::Header::fileIdentifier())) {
+    const offset_t audioOffset =
+      ID3v2::Header(head.mid(0, ID3v2::Header::size())).completeTagSize();
+    audio = head.mid(static_cast<unsigned int>(
+      std::min<offset_t>(audioOffset, head.size())));
+    if(head.size() == ProbeSize && audio.size() < ProbeSize) {
+      stream->seek(audioOffset + audio.size());
+      audio.append(stream->readBlock(ProbeSize - audio.size()));
+    }
+    tagged = true;
+  }
+
+  if(!tagged) {
+    if(const offset_t length = stream->length(); length >= 32) {
+      stream->seek(-std::min<offset_t>(length, TailSize), IOStream::End);
+      const ByteVector tail = stream->readBlock(TailSize);
+      tagged = (tail.size() >= 128 &&
+                tail.containsAt(ID3v1::Tag::fileIdentifier(), tail.size() - 128)) ||
+               tail.containsAt("APETAGEX", tail.size() - 32) ||
+               (tail.size() == TailSize && tail.startsWith("APETAGEX"));
+    }
+  }
+
+  stream->seek(originalPosition);
+
+  return classify({ head, audio, tagged });
+}
+
+List<FileRef::ReadResult> FileRef::readMany(const List<FileName> &fileNames,
+                                            bool readAudioProperties,
+                                            AudioProperties::ReadStyle audioPropertiesStyle,
+                                            unsigned int threadCount)
+{
+  const std::vector<FileName> names(fileNames.begin(), fileNames.end());
+  return readInParallel(static_cast<unsigned int>(names.size()), threadCount,
+    [&](unsigned int i) {
+      return FileRef(names[i], readAudioProperties, audioPropertiesStyle);
+    });
+}
+
+List<FileRef::ReadResult> FileRef::readMany(const List<IOStream *> &streams,
+                                            bool readAudioProperties,
+                                            AudioProperties::ReadStyle audioPropertiesStyle,
+                                            unsigned int threadCount)
+{
+  const std::vector<IOStream *> s(streams.begin(), streams.end());
+  return readInParallel(static_cast<unsigned int>(s.size()), threadCount,
+    [&](unsigned int i) {
+      return FileRef(s[i], readAudioProperties, audioPropertiesStyle);
+    });
 }
 
 StringList FileRef::defaultFileExtensions()
 {
   StringList l;
 
-  l.append("mp3");
-  l.append("mp2");
-  l.append("aac");
-#ifdef TAGLIB_WITH_VORBIS
-  l.append("ogg");
-  l.append("flac");
-  l.append("oga");
-  l.append("opus");
-  l.append("spx");
-#endif
-#ifdef TAGLIB_WITH_APE
-  l.append("mpc");
-  l.append("wv");
-  l.append("ape");
-#endif
-#ifdef TAGLIB_WITH_TRUEAUDIO
-  l.append("tta");
-#endif
-#ifdef TAGLIB_WITH_MP4
-  l.append("m4a");
-  l.append("m4r");
-  l.append("m4b");
-  l.append("m4p");
-  l.append("3g2");
-  l.append("mp4");
-  l.append("m4v");
-#endif
-#ifdef TAGLIB_WITH_ASF
-  l.append("wma");
-  l.append("asf");
-#endif
-#ifdef TAGLIB_WITH_RIFF
-  l.append("aif");
-  l.append("aiff");
-  l.append("afc");
-  l.append("aifc");
-  l.append("wav");
-#endif
-#ifdef TAGLIB_WITH_MOD
-  l.append("mod");
-  l.append("module"); // alias for "mod"
-  l.append("nst"); // alias for "mod"
-  l.append("wow"); // alias for "mod"
-  l.append("s3m");
-  l.append("it");
-  l.append("xm");
-#endif
-#ifdef TAGLIB_WITH_DSF
-  l.append("dsf");
-  l.append("dff");
-  l.append("dsdiff"); // alias for "dff"
-#endif
-#ifdef TAGLIB_WITH_SHORTEN
-  l.append("shn");
-#endif
-#ifdef TAGLIB_WITH_MATROSKA
-  l.append("mkv");
-  l.append("mka");
-  l.append("webm");
-#endif
+  for(const auto &entry : extensionFactories)
+    l.append(String(std::string(entry.extension)));
 
   return l;
 }
@@ -563,7 +973,8 @@ bool FileRef::operator!=(const FileRef &ref) const
 ////////////////////////////////////////////////////////////////////////////////
 
 void FileRef::parse(FileName fileName, bool readAudioProperties,
-                    AudioProperties::ReadStyle audioPropertiesStyle)
+                    AudioProperties::ReadStyle audioPropertiesStyle,
+                    StreamType streamType)
 {
   // Try user-defined resolvers.
 
@@ -573,7 +984,15 @@ void FileRef::parse(FileName fileName, bool readAudioProperties,
 
   // Try to resolve file types based on the file extension.
 
-  d->stream = new FileStream(fileName);
+  if(streamType == StreamType::Mmap) {
+    d->stream = new MmapStream(fileName);
+    if(!d->stream->isOpen()) {
+      delete d->stream;
+      d->stream = nullptr;
+    }
+  }
+  if(!d->stream)
+    d->stream = new FileStream(fileName);
   d->file = detectByExtension(d->stream, readAudioProperties, audioPropertiesStyle);
   if(d->file)
     return;
@@ -28,6 +28,8 @@
 
 #include "tfile.h"
 #include "tstringlist.h"
+#include "tpropertymap.h"
+#include "tvariant.h"
 
 #include "taglib_export.h"
 #include "audioproperties.h"
@@ -169,6 +171,120 @@ namespace TagLib {
       std::unique_ptr<StreamTypeResolverPrivate> d;
     };
 
+    /*!
+     * Specifies which kind of IOStream is used to open a file by name.
+     */
+    enum class StreamType {
+      //! Open the file with a FileStream, this supports saving.
+      File,
+      //! Map the file with a read-only MmapStream, this avoids a system call
+      //! and a buffer copy for each read.  Falls back to a FileStream if the
+      //! file cannot be mapped.
+      Mmap
+    };
+
+    /*!
+     * The file formats which are recognized by probe().
+     */
+    enum class FileType {
+      //! The format could not be recognized.
+      Unknown,
+      //! MPEG audio, i.e. MP1, MP2, MP3 or ADTS AAC
+      MPEG,
+      //! Ogg Vorbis
+      OggVorbis,
+      //! FLAC in an Ogg container
+      OggFLAC,
+      //! Ogg Speex
+      OggSpeex,
+      //! Ogg Opus
+      OggOpus,
+      //! FLAC
+      FLAC,
+      //! Musepack
+      MPC,
+      //! WavPack
+      WavPack,
+      //! Monkey's Audio
+      APE,
+      //! TrueAudio
+      TrueAudio,
+      //! MP4 container, e.g. M4A
+      MP4,
+      //! ASF container, e.g. WMA
+      ASF,
+      //! AIFF or AIFF-C
+      AIFF,
+      //! WAV, including RF64 and BW64
+      WAV,
+      //! ProTracker module
+      Mod,
+      //! ScreamTracker III module
+      S3M,
+      //! Impulse Tracker module
+      IT,
+      //! Extended module
+      XM,
+      //! DSD Stream File
+      DSF,
+      //! DSD Interchange File Format
+      DSDIFF,
+      //! Shorten
+      Shorten,
+      //! Matroska container, e.g. MKA or WebM
+      Matroska
+    };
+
+    /*!
+     * Specifies how reliable the file type returned by probe() is.
+     */
+    enum class ProbeConfidence {
+      //! Nothing was recognized.
+      None,
+      //! Only a weak signature was found, e.g. MPEG frame headers in data
+      //! without any tags.
+      Low,
+      //! A signature was found, but not at the position where the format
+      //! defines it, or a weak signature is backed by tags.
+      Medium,
+      //! The magic number of the format was found where it is expected.
+      High
+    };
+
+    /*!
+     * The result of probe().
+     */
+    struct ProbeResult {
+      //! The recognized file type
+      FileType type;
+      //! How reliable \a type is
+      ProbeConfidence confidence;
+    };
+
+    /*!
+     * The metadata of a single file read by readMany().
+     */
+    struct ReadResult {
+      //! \c true if the file could be opened and read
+      bool isValid { false };
+      //! Why the file could not be read, empty if \a isValid is \c true
+      String error;
+      //! The tag properties, see File::properties()
+      PropertyMap properties;
+      //! The complex properties by key, see File::complexProperties()
+      Map<String, List<VariantMap>> complexProperties;
+      //! \c true if audio properties have been read
+      bool hasAudioProperties { false };
+      //! See AudioProperties::lengthInMilliseconds()
+      int lengthInMilliseconds { 0 };
+      //! See AudioProperties::bitrate()
+      int bitrate { 0 };
+      //! See AudioProperties::sampleRate()
+      int sampleRate { 0 };
+      //! See AudioProperties::channels()
+      int channels { 0 };
+    };
+
     /*!
      * Creates a null FileRef.
      */
@@ -188,6 +304,23 @@ namespace TagLib {
                      AudioProperties::ReadStyle
                      audioPropertiesStyle = AudioProperties::Average);
 
+    /*!
+     * Create a FileRef from \a fileName and open it using a stream of type
+     * \a streamType.  If \a readAudioProperties is \c true then the audio
+     * properties will be read using \a audioPropertiesStyle.  If
+     * \a readAudioProperties is \c false then \a audioPropertiesStyle will be
+     * ignored.
+     *
+     * \note If \a streamType is StreamType::Mmap, the file is opened read only
+     * and save() will fail.
+     *
+     * \see StreamType
+     */
+    FileRef(FileName fileName,
+            bool readAudioProperties,
+            AudioProperties::ReadStyle audioPropertiesStyle,
+            StreamType streamType);
+
     /*!
      * Construct a FileRef from an opened \a IOStream.  If \a readAudioProperties
      * is \c true then the audio properties will be read using \a audioPropertiesStyle.
@@ -340,6 +473,15 @@ namespace TagLib {
      */
     bool save();
 
+    /*!
+     * Saves the file to a temporary copy which then replaces the original
+     * file, so that it is never left partially written.  Returns \c true on
+     * success.
+     *
+     * \see File::saveAtomically()
+     */
+    bool saveAtomically();
+
     /*!
      * Adds a FileTypeResolver to the list of those used by TagLib.  Each
      * additional FileTypeResolver is added to the front of a list of resolvers
@@ -350,6 +492,9 @@ namespace TagLib {
      * this is mostly so that static initializers have something to use for
      * assignment).
      *
+     * Resolvers may be added and cleared while files are opened in other
+     * threads, which keep using the resolvers present when they started.
+     *
      * \see FileTypeResolver
      */
     static const FileTypeResolver *addFileTypeResolver(const FileTypeResolver *resolver);
@@ -377,6 +522,57 @@ namespace TagLib {
      */
     static StringList defaultFileExtensions();
 
+    /*!
+     * Recognizes the format of \a stream from its content without creating a
+     * File object.  This reads a single block from the start of the stream
+     * (and the beginning of the audio data, if it follows a large ID3v2 tag)
+     * and the last bytes for ID3v1 and APE tags, so it is much cheaper than
+     * opening the file.  The position of \a stream is not changed.
+     *
+     * This checks the same signatures as the content based detection of the
+     * FileRef constructors, so a file of the returned type will usually be
+     * opened successfully, but the data is not validated beyond its headers.
+     * User-defined resolvers and the file name are not taken into account.
+     *
+     * \see ProbeResult
+     */
+    static ProbeResult probe(IOStream *stream);
+
+    /*!
+     * Reads the metadata of the files \a fileNames in parallel and returns a
+     * result for each file in the same order.  The files are opened like with
+     * the FileRef constructor, i.e. user-defined resolvers are used, and only
+     * read.
+     *
+     * The files are distributed over \a threadCount threads, including the
+     * calling one, each thread takes the next file as soon as it is done with
+     * the previous one.  If \a threadCount is 0, the number of hardware
+     * threads is used.  Errors are reported in the result of the affected
+     * file and do not stop the other files from being read.
+     *
+     * \note The resolvers, the default ID3v2::FrameFactory and
+     * MP4::ItemFactory and the DebugListener are shared by all threads, so
+     * resolvers and custom listeners must be thread safe.
+     */
+    static List<ReadResult> readMany(const List<FileName> &fileNames,
+                                     bool readAudioProperties = true,
+                                     AudioProperties::ReadStyle
+                                     audioPropertiesStyle = AudioProperties::Average,
+                                     unsigned int threadCount = 0);
+
+    /*!
+     * Reads the metadata of \a streams in parallel and returns a result for
+     * each stream in the same order.  Each stream is only used by a single
+     * thread.  The streams are not owned by this function.
+     *
+     * \see readMany(const List<FileName> &, bool, AudioProperties::ReadStyle, unsigned int)
+     */
+    static List<ReadResult> readMany(const List<IOStream *> &streams,
+                                     bool readAudioProperties = true,
+                                     AudioProperties::ReadStyle
+                                     audioPropertiesStyle = AudioProperties::Average,
+                                     unsigned int threadCount = 0);
+
     /*!
      * Returns \c true if the file (and as such other pointers) are null.
      */
@@ -404,7 +600,8 @@ namespace TagLib {
     bool operator!=(const FileRef &ref) const;
 
   private:
-    void parse(FileName fileName, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle);
+    void parse(FileName fileName, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle,
+               StreamType streamType = StreamType::File);
     void parse(IOStream *stream, bool readAudioProperties, AudioProperties::ReadStyle audioPropertiesStyle);
 
     class FileRefPrivate;
@@ -50,6 +50,10 @@ namespace
 
   constexpr char LastBlockFlag = '\x80';
   constexpr unsigned int MAX_FLAC_METADATA_BLOCK_COUNT = 50000;
+
+  // Number of bytes read from a picture block whose image data is skipped,
+  // enough for the fields in front of the data in nearly all files.
+  constexpr unsigned int DeferredPictureFieldsLength = 1024;
 }  // namespace
 
 class FLAC::File::FilePrivate
@@ -313,7 +317,8 @@ bool FLAC::File::save()
     }
     if(commentBlock && (*it)->code() == MetadataBlock::Picture) {
       // Set the new Vorbis Comment block before the first picture block
-      d->blocks.insert(it, commentBlock);
+      it = d->blocks.insert(it, commentBlock);
+      ++it;
       commentBlock = nullptr;
     }
     ++it;
@@ -363,14 +368,13 @@ bool FLAC::File::save()
   data.append(paddingHeader);
   data.resize(static_cast<unsigned int>(data.size() + paddingLength));
 
-  // Write the data to the file
+  // The metadata blocks and the ID3 tags are written in a single pass over
+  // the file, so the offsets in the plan refer to the file as it was before
+  // saving.
 
-  insert(data, d->flacStart, originalLength);
+  WritePlan plan;
 
-  d->streamStart += static_cast<long>(data.size()) - originalLength;
-
-  if(d->ID3v1Location >= 0)
-    d->ID3v1Location += static_cast<long>(data.size()) - originalLength;
+  const offset_t fileLength = length();
 
   // Update ID3 tags
 
@@ -381,60 +385,50 @@ bool FLAC::File::save()
     if(d->ID3v2Location < 0)
       d->ID3v2Location = 0;
 
-    data = ID3v2Tag()->render();
-    insert(data, d->ID3v2Location, d->ID3v2OriginalSize);
-
-    d->flacStart   += static_cast<long>(data.size()) - d->ID3v2OriginalSize;
-    d->streamStart += static_cast<long>(data.size()) - d->ID3v2OriginalSize;
-
-    if(d->ID3v1Location >= 0)
-      d->ID3v1Location += static_cast<long>(data.size()) - d->ID3v2OriginalSize;
-
-    d->ID3v2OriginalSize = data.size();
+    const ByteVector id3v2Data = ID3v2Tag()->render();
+    plan.replace(d->ID3v2Location, d->ID3v2OriginalSize, id3v2Data);
+    d->ID3v2OriginalSize = id3v2Data.size();
   }
   else {
 
     // ID3v2 tag is empty. Remove the old one.
 
     if(d->ID3v2Location >= 0) {
-      removeBlock(d->ID3v2Location, d->ID3v2OriginalSize);
-
-      d->flacStart   -= d->ID3v2OriginalSize;
-      d->streamStart -= d->ID3v2OriginalSize;
-
-      if(d->ID3v1Location >= 0)
-        d->ID3v1Location -= d->ID3v2OriginalSize;
-
+      plan.replace(d->ID3v2Location, d->ID3v2OriginalSize, ByteVector());
       d->ID3v2Location = -1;
       d->ID3v2OriginalSize = 0;
     }
   }
 
+  // Write the metadata blocks
+
+  plan.replace(d->flacStart, originalLength, data);
+
   if(ID3v1Tag() && !ID3v1Tag()->isEmpty()) {
 
     // ID3v1 tag is not empty. Update the old one or create a new one.
 
-    if(d->ID3v1Location >= 0) {
-      seek(d->ID3v1Location);
-    }
-    else {
-      seek(0, End);
-      d->ID3v1Location = tell();
-    }
+    if(d->ID3v1Location >= 0)
+      plan.replace(d->ID3v1Location, fileLength - d->ID3v1Location, ID3v1Tag()->render());
+    else
+      plan.replace(fileLength, 0, ID3v1Tag()->render());
 
-    writeBlock(ID3v1Tag()->render());
+    d->ID3v1Location = fileLength + plan.lengthDelta() - 128;
   }
   else {
 
     // ID3v1 tag is empty. Remove the old one.
 
     if(d->ID3v1Location >= 0) {
-      truncate(d->ID3v1Location);
+      plan.replace(d->ID3v1Location, fileLength - d->ID3v1Location, ByteVector());
       d->ID3v1Location = -1;
     }
   }
 
-  return true;
+  d->streamStart = plan.newOffset(d->streamStart);
+  d->flacStart = plan.newOffset(d->flacStart);
+
+  return applyWritePlan(plan);
 }
 
 ID3v2::Tag *FLAC::File::ID3v2Tag(bool create)
@@ -677,8 +671,15 @@ void FLAC::File::scan()
       return;
     }
 
-    const ByteVector data = readBlock(blockLength);
-    if(data.size() != blockLength) {
+    // Only read the fields of large pictures if the payloads are limited.
+
+    const bool deferPicture = blockType == MetadataBlock::Picture &&
+      blockLength > DeferredPictureFieldsLength && deferPayload(blockLength);
+    const unsigned int readLength =
+      deferPicture ? DeferredPictureFieldsLength : blockLength;
+
+    const ByteVector data = readBlock(readLength);
+    if(data.size() != readLength) {
       debug("FLAC::File::scan() -- Failed to read a metadata block");
       setValid(false);
       return;
@@ -698,7 +699,18 @@ void FLAC::File::scan()
     }
     else if(blockType == MetadataBlock::Picture) {
       auto picture = new FLAC::Picture();
-      if(picture->parse(data)) {
+      bool parsed = false;
+      if(deferPicture) {
+        parsed = picture->parseDeferred(data, this, nextBlockOffset + 4, blockLength);
+        if(!parsed) {
+          seek(nextBlockOffset + 4);
+          parsed = picture->parse(readBlock(blockLength));
+        }
+      }
+      else {
+        parsed = picture->parse(data);
+      }
+      if(parsed) {
         block = picture;
       }
       else {
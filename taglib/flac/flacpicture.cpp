@@ -26,6 +26,8 @@
 #include "flacpicture.h"
 
 #include "tdebug.h"
+#include "tfile.h"
+#include "tiostream.h"
 
 using namespace TagLib;
 
@@ -40,6 +42,8 @@ public:
   int colorDepth { 0 };
   int numColors { 0 };
   ByteVector data;
+  // Used instead of data if the image was not read with the block.
+  DeferredData deferredData;
 };
 
 FLAC::Picture::Picture() :
@@ -62,45 +66,17 @@ int FLAC::Picture::code() const
 
 bool FLAC::Picture::parse(const ByteVector &data)
 {
-  if(data.size() < 32) {
-    debug("A picture block must contain at least 5 bytes.");
-    return false;
-  }
-
   unsigned int pos = 0;
-  d->type = typeFromUInt(data.toUInt(pos));
-  pos += 4;
-  unsigned int mimeTypeLength = data.toUInt(pos);
-  pos += 4;
-  if(pos + mimeTypeLength + 24 > data.size()) {
-    debug("Invalid picture block.");
-    return false;
-  }
-  d->mimeType = String(data.mid(pos, mimeTypeLength), String::UTF8);
-  pos += mimeTypeLength;
-  unsigned int descriptionLength = data.toUInt(pos);
-  pos += 4;
-  if(pos + descriptionLength + 20 > data.size()) {
-    debug("Invalid picture block.");
+  unsigned int dataLength = 0;
+  if(!parseFields(data, pos, dataLength))
     return false;
-  }
-  d->description = String(data.mid(pos, descriptionLength), String::UTF8);
-  pos += descriptionLength;
-  d->width = data.toUInt(pos);
-  pos += 4;
-  d->height = data.toUInt(pos);
-  pos += 4;
-  d->colorDepth = data.toUInt(pos);
-  pos += 4;
-  d->numColors = data.toUInt(pos);
-  pos += 4;
-  unsigned int dataLength = data.toUInt(pos);
-  pos += 4;
+
   if(pos + dataLength > data.size()) {
     debug("Invalid picture block.");
     return false;
   }
   d->data = data.mid(pos, dataLength);
+  d->deferredData = DeferredData();
 
   return true;
 }
@@ -119,8 +95,9 @@ ByteVector FLAC::Picture::render() const
   result.append(ByteVector::fromUInt(d->height));
   result.append(ByteVector::fromUInt(d->colorDepth));
   result.append(ByteVector::fromUInt(d->numColors));
-  result.append(ByteVector::fromUInt(d->data.size()));
-  result.append(d->data);
+  const ByteVector pictureData = data();
+  result.append(ByteVector::fromUInt(pictureData.size()));
+  result.append(pictureData);
   return result;
 }
 
@@ -196,10 +173,114 @@ void FLAC::Picture::setNumColors(int numColors)
 
 ByteVector FLAC::Picture::data() const
 {
-  return d->data;
+  return d->deferredData.isNull() ? d->data : d->deferredData.data();
 }
 
 void FLAC::Picture::setData(const ByteVector &data)
 {
   d->data = data;
+  d->deferredData = DeferredData();
+}
+
+bool FLAC::Picture::writeData(IOStream *sink) const
+{
+  if(!d->deferredData.isNull())
+    return d->deferredData.writeTo(sink);
+
+  if(!sink)
+    return false;
+
+  sink->writeBlock(d->data);
+  return true;
+}
+
+bool FLAC::Picture::isDataDeferred() const
+{
+  return !d->deferredData.isNull() && !d->deferredData.isLoaded();
+}
+
+offset_t FLAC::Picture::deferredDataOffset() const
+{
+  return isDataDeferred() ? d->deferredData.offset() : 0;
+}
+
+offset_t FLAC::Picture::deferredDataSize() const
+{
+  return isDataDeferred() ? d->deferredData.size() : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+bool FLAC::Picture::parseDeferred(const ByteVector &data, TagLib::File *file,
+                                  offset_t blockOffset, unsigned int blockLength)
+{
+  // data is only the beginning of the block, check that it contains all
+  // fields before parsing them to not report a valid block as invalid.
+
+  if(data.size() < 32)
+    return false;
+  const offset_t mimeTypeLength = data.toUInt(4U);
+  if(8 + mimeTypeLength + 4 > data.size())
+    return false;
+  const offset_t descriptionLength =
+    data.toUInt(static_cast<unsigned int>(8 + mimeTypeLength));
+  if(8 + mimeTypeLength + 4 + descriptionLength + 20 > data.size())
+    return false;
+
+  unsigned int pos = 0;
+  unsigned int dataLength = 0;
+  if(!parseFields(data, pos, dataLength))
+    return false;
+
+  if(pos + dataLength > blockLength) {
+    debug("Invalid picture block.");
+    return false;
+  }
+  d->data.clear();
+  d->deferredData = file->deferData(blockOffset + pos, dataLength);
+
+  return true;
+}
+
+bool FLAC::Picture::parseFields(const ByteVector &data, unsigned int &pos,
+                                unsigned int &dataLength)
+{
+  if(data.size() < 32) {
+    debug("A picture block must contain at least 5 bytes.");
+    return false;
+  }
+
+  pos = 0;
+  d->type = typeFromUInt(data.toUInt(pos));
+  pos += 4;
+  unsigned int mimeTypeLength = data.toUInt(pos);
+  pos += 4;
+  if(pos + mimeTypeLength + 24 > data.size()) {
+    debug("Invalid picture block.");
+    return false;
+  }
+  d->mimeType = String(data.mid(pos, mimeTypeLength), String::UTF8);
+  pos += mimeTypeLength;
+  unsigned int descriptionLength = data.toUInt(pos);
+  pos += 4;
+  if(pos + descriptionLength + 20 > data.size()) {
+    debug("Invalid picture block.");
+    return false;
+  }
+  d->description = String(data.mid(pos, descriptionLength), String::UTF8);
+  pos += descriptionLength;
+  d->width = data.toUInt(pos);
+  pos += 4;
+  d->height = data.toUInt(pos);
+  pos += 4;
+  d->colorDepth = data.toUInt(pos);
+  pos += 4;
+  d->numColors = data.toUInt(pos);
+  pos += 4;
+  dataLength = data.toUInt(pos);
+  pos += 4;
+
+  return true;
 }
@@ -31,6 +31,8 @@
 #include "tbytevector.h"
 #include "tpicturetype.h"
 #include "taglib_export.h"
+#include "taglib.h"
+#include "tdeferreddata.h"
 #include "flacmetadatablock.h"
 
 namespace TagLib {
@@ -128,6 +130,9 @@ namespace TagLib {
 
       /*!
        * Returns the image data.
+       *
+       * \note If the data was skipped while reading the file, it is read from
+       * the file now, see isDataDeferred().
        */
       ByteVector data() const;
 
@@ -136,6 +141,31 @@ namespace TagLib {
        */
       void setData(const ByteVector &data);
 
+      /*!
+       * Writes the image data to \a sink at its current position.  If the
+       * data was skipped while reading the file, it is streamed from the file
+       * without being kept in memory.  Returns \c false if the data could
+       * not be read.
+       */
+      bool writeData(IOStream *sink) const;
+
+      /*!
+       * Returns \c true if the image data was not read from the file because
+       * of the limits set with IOStream::setMaxPayloadSize() or
+       * IOStream::setReadBudget().  It is loaded when data() is called.
+       */
+      bool isDataDeferred() const;
+
+      /*!
+       * Returns the offset of the not yet loaded image data inside the file.
+       */
+      offset_t deferredDataOffset() const;
+
+      /*!
+       * Returns the size of the not yet loaded image data.
+       */
+      offset_t deferredDataSize() const;
+
       /*!
        * Returns the FLAC metadata block type.
        */
@@ -152,6 +182,24 @@ namespace TagLib {
       bool parse(const ByteVector &data);
 
     private:
+      friend class File;
+
+      /*!
+       * Parses the fields of a picture block without the image data.
+       * \a data is the beginning of the block of \a blockLength bytes which
+       * starts at \a blockOffset in \a file.  Returns \c false if \a data
+       * does not contain all fields.
+       */
+      bool parseDeferred(const ByteVector &data, TagLib::File *file,
+                         offset_t blockOffset, unsigned int blockLength);
+
+      /*!
+       * Parses the fields in front of the image data and sets \a pos to the
+       * offset of the image data and \a dataLength to its size.
+       */
+      bool parseFields(const ByteVector &data, unsigned int &pos,
+                       unsigned int &dataLength);
+
       class PicturePrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<PicturePrivate> d;
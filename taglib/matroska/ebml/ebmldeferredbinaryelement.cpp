@@ -42,18 +42,17 @@ bool EBML::DeferredBinaryElement::read(File &file)
 {
   // The file is positioned at the data of the element, which is all we have
   // to remember in order to be able to read it later.
-  dataOffset = file.tell();
-  deferred = true;
+  deferredData = file.deferData(file.tell(), getDataSize());
   skipData(file);
   return true;
 }
 
 bool EBML::DeferredBinaryElement::isDeferred() const
 {
-  return deferred;
+  return !deferredData.isNull();
 }
 
-offset_t EBML::DeferredBinaryElement::getDataOffset() const
+const DeferredData &EBML::DeferredBinaryElement::getDeferredData() const
 {
-  return dataOffset;
+  return deferredData;
 }
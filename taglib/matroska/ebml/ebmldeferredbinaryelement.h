@@ -23,6 +23,7 @@
 #ifndef DO_NOT_DOCUMENT
 
 #include "ebmlbinaryelement.h"
+#include "tdeferreddata.h"
 
 namespace TagLib {
   class File;
@@ -30,9 +31,9 @@ namespace TagLib {
   namespace EBML {
     /*!
      * A binary element whose data is not pulled into memory while the file is
-     * read.  read() only registers the offset of the data in the file and
-     * skips over it, so that the payload can be loaded later, when it is
-     * really requested.  This keeps reading the metadata of a file cheap even
+     * read.  read() only registers the data in the file using
+     * File::deferData() and skips over it, so that the payload can be loaded
+     * later, when it is really requested.  This keeps reading the metadata of a file cheap even
      * if it contains large attachments.
      *
      * Elements which are created to be rendered (i.e. not read from a file)
@@ -53,19 +54,18 @@ namespace TagLib {
 
       /*!
        * Returns \c true if the data has not been read into memory, i.e. if it
-       * has to be loaded from getDataOffset() to be available.
+       * has to be loaded using getDeferredData() to be available.
        */
       bool isDeferred() const;
 
       /*!
-       * Returns the offset of the data inside the file, only valid if
+       * Returns the reference to the data inside the file, only valid if
        * isDeferred() is \c true.
        */
-      offset_t getDataOffset() const;
+      const DeferredData &getDeferredData() const;
 
     private:
-      offset_t dataOffset = 0;
-      bool deferred = false;
+      DeferredData deferredData;
     };
   }
 }
@@ -77,11 +77,11 @@ std::unique_ptr<Matroska::Attachments> EBML::MkAttachments::parse() const
     const String mediaTypeValue = mediaType ? *mediaType : String();
     const String descriptionValue = description ? *description : String();
     if(data->isDeferred()) {
-      // The data has been left in the file, it is loaded when the attachments
-      // are requested, see Matroska::File::attachments().
+      // The data has been left in the file, it is loaded when it is
+      // requested, see Matroska::AttachedFile::data().
       attachments->addAttachedFile(Matroska::AttachedFile(
-        data->getDataOffset(), data->getDataSize(), *filename, mediaTypeValue,
-        uid, descriptionValue));
+        data->getDeferredData(), *filename, mediaTypeValue, uid,
+        descriptionValue));
     }
     else {
       attachments->addAttachedFile(Matroska::AttachedFile(
@@ -30,21 +30,19 @@ public:
     const String &mediaType, UID uid, const String &description) :
     fileName(fileName), description(description), mediaType(mediaType),
     data(data), uid(uid) {}
-  AttachedFilePrivate(offset_t dataOffset, offset_t dataSize,
+  AttachedFilePrivate(const DeferredData &deferredData,
     const String &fileName, const String &mediaType, UID uid,
     const String &description) :
     fileName(fileName), description(description), mediaType(mediaType),
-    uid(uid), dataOffset(dataOffset), dataSize(dataSize), dataDeferred(true) {}
+    uid(uid), deferredData(deferredData) {}
   ~AttachedFilePrivate() = default;
   String fileName;
   String description;
   String mediaType;
   ByteVector data;
   UID uid = 0;
-  // Position of the data in the file, valid while dataDeferred is true.
-  offset_t dataOffset = 0;
-  offset_t dataSize = 0;
-  bool dataDeferred = false;
+  // Moved into data when it is requested for the first time.
+  DeferredData deferredData;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,14 +56,6 @@ Matroska::AttachedFile::AttachedFile(const ByteVector &data,
 {
 }
 
-Matroska::AttachedFile::AttachedFile(offset_t dataOffset, offset_t dataSize,
-  const String &fileName, const String &mediaType, UID uid,
-  const String &description) :
-  d(std::make_unique<AttachedFilePrivate>(dataOffset, dataSize, fileName,
-                                          mediaType, uid, description))
-{
-}
-
 Matroska::AttachedFile::AttachedFile(const AttachedFile &other) :
   d(std::make_unique<AttachedFilePrivate>(*other.d))
 {
@@ -107,6 +97,10 @@ const String &Matroska::AttachedFile::mediaType() const
 
 const ByteVector &Matroska::AttachedFile::data() const
 {
+  if(!d->deferredData.isNull()) {
+    d->data = d->deferredData.data();
+    d->deferredData = DeferredData();
+  }
   return d->data;
 }
 
@@ -119,25 +113,9 @@ Matroska::AttachedFile::UID Matroska::AttachedFile::uid() const
 // private members
 ////////////////////////////////////////////////////////////////////////////////
 
-bool Matroska::AttachedFile::isDataDeferred() const
-{
-  return d->dataDeferred;
-}
-
-offset_t Matroska::AttachedFile::deferredDataOffset() const
-{
-  return d->dataOffset;
-}
-
-offset_t Matroska::AttachedFile::deferredDataSize() const
-{
-  return d->dataSize;
-}
-
-void Matroska::AttachedFile::setLoadedData(const ByteVector &data)
+Matroska::AttachedFile::AttachedFile(const DeferredData &data,
+  const String &fileName, const String &mediaType, UID uid,
+  const String &description) :
+  d(std::make_unique<AttachedFilePrivate>(data, fileName, mediaType, uid, description))
 {
-  d->data = data;
-  d->dataDeferred = false;
-  d->dataOffset = 0;
-  d->dataSize = 0;
 }
@@ -23,6 +23,7 @@
 
 #include <memory>
 #include "taglib.h"
+#include "tdeferreddata.h"
 #include "tstring.h"
 #include "taglib_export.h"
 
@@ -100,9 +101,7 @@ namespace TagLib {
        * Returns the data of the attached file.
        *
        * \note When the attached file was read from a file, its data is only
-       * loaded from the file when the attachments are requested using
-       * Matroska::File::attachments().  Objects obtained from there therefore
-       * always have their data available.
+       * loaded from the file when it is requested for the first time.
        */
       const ByteVector &data() const;
 
@@ -113,30 +112,16 @@ namespace TagLib {
 
     private:
       friend class EBML::MkAttachments;
-      friend class File;
       class AttachedFilePrivate;
 
       /*!
-       * Construct an attached file whose data is not loaded yet.  The data is
-       * at \a dataOffset in the file and \a dataSize bytes long, it will be
-       * loaded by Matroska::File when the attachments are requested.
+       * Construct an attached file whose data is not loaded yet, it will be
+       * read from the file when data() is called.
        */
-      AttachedFile(offset_t dataOffset, offset_t dataSize,
-                   const String &fileName, const String &mediaType, UID uid,
+      AttachedFile(const DeferredData &data, const String &fileName,
+                   const String &mediaType, UID uid,
                    const String &description);
 
-      //! Returns \c true if the data still has to be loaded from the file.
-      bool isDataDeferred() const;
-
-      //! Returns the offset of the not yet loaded data inside the file.
-      offset_t deferredDataOffset() const;
-
-      //! Returns the size of the not yet loaded data.
-      offset_t deferredDataSize() const;
-
-      //! Sets the data which has been loaded from the file.
-      void setLoadedData(const ByteVector &data);
-
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<AttachedFilePrivate> d;
     };
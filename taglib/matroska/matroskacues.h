@@ -22,6 +22,7 @@
 #define TAGLIB_MATROSKACUES_H
 #ifndef DO_NOT_DOCUMENT
 
+#include <list>
 #include <optional>
 
 #include "tlist.h"
@@ -250,7 +250,6 @@ List<VariantMap> Matroska::File::complexProperties(const String &key) const
     }
   }
   if(d->attachments) {
-    loadAttachedFileData();
     const auto &attachedFiles = d->attachments->attachedFileList();
     for(const auto &attachedFile : attachedFiles) {
       if(keyMatchesAttachedFile(key, attachedFile)) {
@@ -357,7 +356,6 @@ Matroska::Attachments *Matroska::File::attachments(bool create) const
 {
   if(!d->attachments && create)
     d->attachments = std::make_unique<Attachments>();
-  loadAttachedFileData();
   return d->attachments.get();
 }
 
@@ -368,42 +366,6 @@ Matroska::Chapters *Matroska::File::chapters(bool create) const
   return d->chapters.get();
 }
 
-void Matroska::File::loadAttachedFileData() const
-{
-  if(!d->attachments)
-    return;
-
-  // Check with the const list first, getting the mutable list would mark the
-  // attachments as to be rendered again.
-  const auto &files = d->attachments->attachedFileList();
-  if(std::none_of(files.begin(), files.end(),
-                  [](const AttachedFile &file) { return file.isDataDeferred(); }))
-    return;
-
-  bool positionSaved = false;
-  offset_t position = 0;
-  for(auto &attachedFile : d->attachments->attachedFiles()) {
-    if(!attachedFile.isDataDeferred())
-      continue;
-    if(!positionSaved) {
-      position = d->file->tell();
-      positionSaved = true;
-    }
-    const auto dataSize = attachedFile.deferredDataSize();
-    d->file->seek(attachedFile.deferredDataOffset());
-    ByteVector data = d->file->readBlock(dataSize);
-    if(static_cast<offset_t>(data.size()) != dataSize) {
-      debug("Failed to read data of attached file");
-    }
-    // Mark the data as loaded even if it is incomplete, retrying would fail
-    // just the same and the file position is no longer known afterwards.
-    attachedFile.setLoadedData(data);
-  }
-  if(positionSaved) {
-    d->file->seek(position);
-  }
-}
-
 void Matroska::File::read(bool readProperties, Properties::ReadStyle readStyle)
 {
   const offset_t fileLength = length();
@@ -510,11 +472,6 @@ bool Matroska::File::save(WriteStyle writeStyle)
     return false;
   }
 
-  // The attachments are rendered from the attached files, so the data of
-  // attached files which have not been requested has to be loaded now, before
-  // the file is modified, otherwise it would be lost.
-  loadAttachedFileData();
-
   // Do not create new attachments, chapters or tags and corresponding
   // seek head entries if only empty objects were created.
   if(d->chapters && d->chapters->chapterEditionList().isEmpty() &&
@@ -189,13 +189,6 @@ namespace TagLib::Matroska {
 
   private:
     void read(bool readProperties, Properties::ReadStyle readStyle);
-    /*!
-     * Read the data of the attached files which has been left in the file
-     * while reading, see EBML::DeferredBinaryElement.  This is done when the
-     * attachments are requested and before saving, so that an attachment
-     * which has never been requested is not lost when the file is written.
-     */
-    void loadAttachedFileData() const;
     class FilePrivate;
     friend class Properties;
     TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
@@ -78,7 +78,7 @@ void MP4::Atom::read(File *file, int depth, unsigned int &atomCount)
 
   d->children.setAutoDelete(true);
 
-  ByteVector header = file->readBlock(8);
+  ByteVector header = file->readView(8);
   if(header.size() != 8) {
     // The atom header must be 8 bytes long, otherwise there is either
     // trailing garbage or the file is truncated
@@ -96,7 +96,7 @@ void MP4::Atom::read(File *file, int depth, unsigned int &atomCount)
   }
   else if(d->length == 1) {
     // The atom has a 64-bit length.
-    d->length = file->readBlock(8).toLongLong();
+    d->length = file->readView(8).toLongLong();
   }
 
   if(d->length < 8 || d->length > file->length() - d->offset) {
@@ -123,7 +123,7 @@ void MP4::Atom::read(File *file, int depth, unsigned int &atomCount)
         // meta is not a full atom (i.e. not followed by version, flags). It
         // is followed by the size and type of the first child atom.
         auto metaIsFullAtom = std::none_of(metaChildrenNames.begin(), metaChildrenNames.end(),
-          [nextSize = file->readBlock(8).mid(4, 4)](const auto &child) { return nextSize == child; });
+          [nextSize = file->readView(8).mid(4, 4)](const auto &child) { return nextSize == child; });
         // Only skip next four bytes, which contain version and flags, if meta
         // is a full atom.
         file->seek(posAfterMeta + (metaIsFullAtom ? 4 : 0));
@@ -25,6 +25,8 @@
 
 #include "mp4coverart.h"
 
+#include "tiostream.h"
+
 using namespace TagLib;
 
 class MP4::CoverArt::CoverArtPrivate
@@ -32,6 +34,8 @@ class MP4::CoverArt::CoverArtPrivate
 public:
   Format format { MP4::CoverArt::JPEG };
   ByteVector data;
+  // Used instead of data if the image was not read with the tag.
+  DeferredData deferredData;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -67,7 +71,38 @@ MP4::CoverArt::format() const
 ByteVector
 MP4::CoverArt::data() const
 {
-  return d->data;
+  return d->deferredData.isNull() ? d->data : d->deferredData.data();
+}
+
+bool
+MP4::CoverArt::writeData(IOStream *sink) const
+{
+  if(!d->deferredData.isNull())
+    return d->deferredData.writeTo(sink);
+
+  if(!sink)
+    return false;
+
+  sink->writeBlock(d->data);
+  return true;
+}
+
+bool
+MP4::CoverArt::isDataDeferred() const
+{
+  return !d->deferredData.isNull() && !d->deferredData.isLoaded();
+}
+
+offset_t
+MP4::CoverArt::deferredDataOffset() const
+{
+  return isDataDeferred() ? d->deferredData.offset() : 0;
+}
+
+offset_t
+MP4::CoverArt::deferredDataSize() const
+{
+  return isDataDeferred() ? d->deferredData.size() : 0;
 }
 
 bool MP4::CoverArt::operator==(const CoverArt &other) const
@@ -79,3 +114,14 @@ bool MP4::CoverArt::operator!=(const CoverArt &other) const
 {
   return !(*this == other);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+MP4::CoverArt::CoverArt(Format format, const DeferredData &data) :
+  d(std::make_shared<CoverArtPrivate>())
+{
+  d->format = format;
+  d->deferredData = data;
+}
@@ -29,6 +29,8 @@
 #include "tlist.h"
 #include "tbytevector.h"
 #include "taglib_export.h"
+#include "taglib.h"
+#include "tdeferreddata.h"
 #include "mp4atom.h"
 
 namespace TagLib {
@@ -66,9 +68,39 @@ namespace TagLib {
       //! Format of the image
       Format format() const;
 
-      //! The image data
+      /*!
+       * Returns the image data.
+       *
+       * \note If the data was skipped while reading the file, it is read from
+       * the file now, see isDataDeferred().
+       */
       ByteVector data() const;
 
+      /*!
+       * Writes the image data to \a sink at its current position.  If the
+       * data was skipped while reading the file, it is streamed from the file
+       * without being kept in memory.  Returns \c false if the data could
+       * not be read.
+       */
+      bool writeData(IOStream *sink) const;
+
+      /*!
+       * Returns \c true if the image data was not read from the file because
+       * of the limits set with IOStream::setMaxPayloadSize() or
+       * IOStream::setReadBudget().  It is loaded when data() is called.
+       */
+      bool isDataDeferred() const;
+
+      /*!
+       * Returns the offset of the not yet loaded image data inside the file.
+       */
+      offset_t deferredDataOffset() const;
+
+      /*!
+       * Returns the size of the not yet loaded image data.
+       */
+      offset_t deferredDataSize() const;
+
       /*!
        * Returns \c true if the CoverArt and \a other are of the same format and
        * contain the same data.
@@ -81,6 +113,14 @@ namespace TagLib {
       bool operator!=(const CoverArt &other) const;
 
     private:
+      friend class Tag;
+
+      /*!
+       * Construct a cover art whose data is read from the file when it is
+       * needed.
+       */
+      CoverArt(Format format, const DeferredData &data);
+
       class CoverArtPrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::shared_ptr<CoverArtPrivate> d;
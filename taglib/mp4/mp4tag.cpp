@@ -29,6 +29,7 @@
 
 #include "tdebug.h"
 #include "tpropertymap.h"
+#include "tarena.h"
 #include "mp4itemfactory.h"
 #include "mp4atom.h"
 #include "mp4coverart.h"
@@ -65,9 +66,17 @@ MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms,
   d->file = file;
   d->atoms = atoms;
 
+  const Arena::Scope arenaScope(file);
+
   const MP4::Atom *ilst = atoms->find("moov", "udta", "meta", "ilst");
   if(ilst) {
     for(const auto &atom : ilst->children()) {
+      if(atom->name() == "covr" && file->deferPayload(atom->length())) {
+        if(const Item item = readDeferredCovr(atom); item.isValid()) {
+          addItem(atom->name(), item);
+          continue;
+        }
+      }
       file->seek(atom->offset() + 8);
       ByteVector data = d->file->readBlock(atom->length() - 8);
       if(const auto &[name, itm] = d->factory->parseItem(atom, data);
@@ -90,6 +99,33 @@ MP4::Tag::Tag(TagLib::File *file, MP4::Atoms *atoms,
 
 MP4::Tag::~Tag() = default;
 
+MP4::Item
+MP4::Tag::readDeferredCovr(const MP4::Atom *atom)
+{
+  // Only the headers of the data atoms are read, the image data is loaded
+  // when it is accessed.  Cover art with unexpected flags is left to the
+  // item factory, which detects the format from the image data.
+
+  CoverArtList value;
+  offset_t pos = atom->offset() + 8;
+  const offset_t end = atom->offset() + atom->length();
+  while(pos + 16 <= end) {
+    d->file->seek(pos);
+    const ByteVector header = d->file->readBlock(16);
+    const unsigned int length = header.toUInt();
+    const int flags = static_cast<int>(header.toUInt(8U));
+    if(length < 16 || pos + length > end || header.mid(4, 4) != "data")
+      return Item();
+    if(flags != TypeJPEG && flags != TypePNG && flags != TypeBMP &&
+       flags != TypeGIF && flags != TypeImplicit)
+      return Item();
+    value.append(CoverArt(static_cast<CoverArt::Format>(flags),
+                          d->file->deferData(pos + 16, length - 16)));
+    pos += length;
+  }
+  return !value.isEmpty() ? Item(value) : Item();
+}
+
 ByteVector
 MP4::Tag::padIlst(const ByteVector &data, int length) const
 {
@@ -128,6 +128,12 @@ namespace TagLib {
 
         void addItem(const String &name, const Item &value);
 
+        /*!
+         * Reads the cover art in \a atom without the image data, returns an
+         * invalid item if this is not possible.
+         */
+        Item readDeferredCovr(const Atom *atom);
+
         class TagPrivate;
         TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
         std::unique_ptr<TagPrivate> d;
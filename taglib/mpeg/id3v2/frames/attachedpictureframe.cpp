@@ -26,6 +26,7 @@
 #include "attachedpictureframe.h"
 
 #include "tstringlist.h"
+#include "tiostream.h"
 #include "tutils.h"
 #include "tdebug.h"
 
@@ -40,6 +41,8 @@ public:
   AttachedPictureFrame::Type type { AttachedPictureFrame::Other };
   String description;
   ByteVector data;
+  // Used instead of data if the image was not read with the tag.
+  DeferredData deferredData;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -79,6 +82,8 @@ String::Type AttachedPictureFrame::textEncoding() const
 
 void AttachedPictureFrame::setTextEncoding(String::Type t)
 {
+  if(t != d->textEncoding)
+    discardOriginalData();
   d->textEncoding = t;
 }
 
@@ -89,6 +94,7 @@ String AttachedPictureFrame::mimeType() const
 
 void AttachedPictureFrame::setMimeType(const String &m)
 {
+  discardOriginalData();
   d->mimeType = m;
 }
 
@@ -99,6 +105,7 @@ AttachedPictureFrame::Type AttachedPictureFrame::type() const
 
 void AttachedPictureFrame::setType(Type t)
 {
+  discardOriginalData();
   d->type = t;
 }
 
@@ -109,17 +116,47 @@ String AttachedPictureFrame::description() const
 
 void AttachedPictureFrame::setDescription(const String &desc)
 {
+  discardOriginalData();
   d->description = desc;
 }
 
 ByteVector AttachedPictureFrame::picture() const
 {
-  return d->data;
+  return d->deferredData.isNull() ? d->data : d->deferredData.data();
 }
 
 void AttachedPictureFrame::setPicture(const ByteVector &p)
 {
+  discardOriginalData();
   d->data = p;
+  d->deferredData = DeferredData();
+}
+
+bool AttachedPictureFrame::writePicture(IOStream *sink) const
+{
+  if(!d->deferredData.isNull())
+    return d->deferredData.writeTo(sink);
+
+  if(!sink)
+    return false;
+
+  sink->writeBlock(d->data);
+  return true;
+}
+
+bool AttachedPictureFrame::isDataDeferred() const
+{
+  return !d->deferredData.isNull() && !d->deferredData.isLoaded();
+}
+
+offset_t AttachedPictureFrame::deferredDataOffset() const
+{
+  return isDataDeferred() ? d->deferredData.offset() : 0;
+}
+
+offset_t AttachedPictureFrame::deferredDataSize() const
+{
+  return isDataDeferred() ? d->deferredData.size() : 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -148,6 +185,7 @@ void AttachedPictureFrame::parseFields(const ByteVector &data)
   d->description = readStringField(data, d->textEncoding, &pos);
 
   d->data = data.mid(pos);
+  d->deferredData = DeferredData();
 }
 
 ByteVector AttachedPictureFrame::renderFields() const
@@ -162,7 +200,7 @@ ByteVector AttachedPictureFrame::renderFields() const
   data.append(static_cast<char>(d->type));
   data.append(d->description.data(encoding));
   data.append(textDelimiter(encoding));
-  data.append(d->data);
+  data.append(picture());
 
   return data;
 }
@@ -176,6 +214,14 @@ AttachedPictureFrame::AttachedPictureFrame(const ByteVector &data, Header *h) :
   d(std::make_unique<AttachedPictureFramePrivate>())
 {
   parseFields(fieldData(data));
+  keepOriginalData(data);
+}
+
+void AttachedPictureFrame::setDeferredData(const DeferredData &data)
+{
+  discardOriginalData();
+  d->data.clear();
+  d->deferredData = data;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -209,6 +255,7 @@ void AttachedPictureFrameV22::parseFields(const ByteVector &data)
   d->description = readStringField(data, d->textEncoding, &pos);
 
   d->data = data.mid(pos);
+  d->deferredData = DeferredData();
 }
 
 AttachedPictureFrameV22::AttachedPictureFrameV22(const ByteVector &data, Header *h)
@@ -27,6 +27,8 @@
 #define TAGLIB_ATTACHEDPICTUREFRAME_H
 
 #include "taglib_export.h"
+#include "taglib.h"
+#include "tdeferreddata.h"
 #include "tpicturetype.h"
 #include "id3v2frame.h"
 
@@ -152,6 +154,9 @@ namespace TagLib {
        * \note ByteVector has a data() method that returns a <tt>const char *</tt> which
        * should make it easy to export this data to external programs.
        *
+       * \note If the data was skipped while reading the tag, it is read from
+       * the file now, see isDataDeferred().
+       *
        * \see setPicture()
        * \see mimeType()
        */
@@ -167,6 +172,34 @@ namespace TagLib {
        */
       void setPicture(const ByteVector &p);
 
+      /*!
+       * Writes the image data to \a sink at its current position, e.g. a
+       * FileStream created for a file descriptor.  If the data was skipped
+       * while reading the tag, it is streamed from the file and decoded on
+       * the way without being kept in memory.  Returns \c false if the data
+       * could not be read.
+       *
+       * \see picture()
+       */
+      bool writePicture(IOStream *sink) const;
+
+      /*!
+       * Returns \c true if the image data was not read from the file because
+       * of the limits set with IOStream::setMaxPayloadSize() or
+       * IOStream::setReadBudget().  It is loaded when picture() is called.
+       */
+      bool isDataDeferred() const;
+
+      /*!
+       * Returns the offset of the not yet loaded image data inside the file.
+       */
+      offset_t deferredDataOffset() const;
+
+      /*!
+       * Returns the size of the not yet loaded image data.
+       */
+      offset_t deferredDataSize() const;
+
     protected:
       void parseFields(const ByteVector &data) override;
       ByteVector renderFields() const override;
@@ -175,7 +208,14 @@ namespace TagLib {
       std::unique_ptr<AttachedPictureFramePrivate> d;
 
     private:
+      friend class Tag;
+
       AttachedPictureFrame(const ByteVector &data, Header *h);
+
+      /*!
+       * Replaces the image data by a reference to the data in the file.
+       */
+      void setDeferredData(const DeferredData &data);
     };
 
     //! support for ID3v2.2 PIC frames
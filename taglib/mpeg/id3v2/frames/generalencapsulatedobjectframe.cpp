@@ -89,6 +89,8 @@ String::Type GeneralEncapsulatedObjectFrame::textEncoding() const
 
 void GeneralEncapsulatedObjectFrame::setTextEncoding(String::Type encoding)
 {
+  if(encoding != d->textEncoding)
+    discardOriginalData();
   d->textEncoding = encoding;
 }
 
@@ -99,6 +101,7 @@ String GeneralEncapsulatedObjectFrame::mimeType() const
 
 void GeneralEncapsulatedObjectFrame::setMimeType(const String &type)
 {
+  discardOriginalData();
   d->mimeType = type;
 }
 
@@ -109,6 +112,7 @@ String GeneralEncapsulatedObjectFrame::fileName() const
 
 void GeneralEncapsulatedObjectFrame::setFileName(const String &name)
 {
+  discardOriginalData();
   d->fileName = name;
 }
 
@@ -119,6 +123,7 @@ String GeneralEncapsulatedObjectFrame::description() const
 
 void GeneralEncapsulatedObjectFrame::setDescription(const String &desc)
 {
+  discardOriginalData();
   d->description = desc;
 }
 
@@ -129,6 +134,7 @@ ByteVector GeneralEncapsulatedObjectFrame::object() const
 
 void GeneralEncapsulatedObjectFrame::setObject(const ByteVector &data)
 {
+  discardOriginalData();
   d->data = data;
 }
 
@@ -185,4 +191,5 @@ GeneralEncapsulatedObjectFrame::GeneralEncapsulatedObjectFrame(const ByteVector
   d(std::make_unique<GeneralEncapsulatedObjectFramePrivate>())
 {
   parseFields(fieldData(data));
+  keepOriginalData(data);
 }
@@ -77,11 +77,13 @@ ByteVector PrivateFrame::data() const
 
 void PrivateFrame::setOwner(const String &s)
 {
+  discardOriginalData();
   d->owner = s;
 }
 
 void PrivateFrame::setData(const ByteVector & data)
 {
+  discardOriginalData();
   d->data = data;
 }
 
@@ -125,4 +127,5 @@ PrivateFrame::PrivateFrame(const ByteVector &data, Header *h) :
   d(std::make_unique<PrivateFramePrivate>())
 {
   parseFields(fieldData(data));
+  keepOriginalData(data);
 }
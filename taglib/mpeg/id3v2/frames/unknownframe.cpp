@@ -80,4 +80,5 @@ UnknownFrame::UnknownFrame(const ByteVector &data, Header *h) :
   d(std::make_unique<UnknownFramePrivate>())
 {
   parseFields(fieldData(data));
+  keepOriginalData(data);
 }
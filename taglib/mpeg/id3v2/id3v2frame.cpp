@@ -32,6 +32,7 @@
 #include "tdebug.h"
 #include "tstringlist.h"
 #include "tzlib.h"
+#include "tarena.h"
 #include "tpropertymap.h"
 #include "id3v2tag.h"
 #include "id3v2synchdata.h"
@@ -53,7 +54,14 @@ public:
   FramePrivate(const FramePrivate &) = delete;
   FramePrivate &operator=(const FramePrivate &) = delete;
 
+  static void *operator new(size_t size) { return Arena::allocate(size); }
+  static void operator delete(void *p) { Arena::deallocate(p); }
+
   Frame::Header *header { nullptr };
+
+  // The unmodified frame as it was read, see keepOriginalData().
+  ByteVector originalData;
+  unsigned int originalVersion { 0 };
 };
 
 namespace
@@ -98,6 +106,16 @@ unsigned int Frame::headerSize() const
 
 Frame::~Frame() = default;
 
+void *Frame::operator new(size_t size)
+{
+  return Arena::allocate(size);
+}
+
+void Frame::operator delete(void *p)
+{
+  Arena::deallocate(p);
+}
+
 ByteVector Frame::frameID() const
 {
   if(d->header)
@@ -128,6 +146,15 @@ StringList Frame::toStringList() const
 
 ByteVector Frame::render() const
 {
+  // The kept data is only valid for the version it has been read with and
+  // as long as the header still describes it.
+
+  if(!d->originalData.isEmpty() &&
+     d->header->version() == d->originalVersion &&
+     d->originalData.size() == d->header->size() + d->header->frameSize() &&
+     d->originalData.startsWith(d->header->frameID()))
+    return d->originalData;
+
   ByteVector fieldData = renderFields();
   d->header->setFrameSize(fieldData.size());
   ByteVector headerData = d->header->render();
@@ -272,6 +299,8 @@ Frame::Frame(Header *h) :
 
 void Frame::setHeader(Header *h, bool deleteCurrent)
 {
+  discardOriginalData();
+
   if(deleteCurrent)
     delete d->header;
 
@@ -280,6 +309,8 @@ void Frame::setHeader(Header *h, bool deleteCurrent)
 
 void Frame::parse(const ByteVector &data)
 {
+  discardOriginalData();
+
   if(d->header)
     d->header->setData(data);
   else
@@ -386,6 +417,26 @@ String::Type Frame::checkTextEncoding(const StringList &fields, String::Type enc
   return String::Latin1;
 }
 
+void Frame::keepOriginalData(const ByteVector &data)
+{
+  // Frames with flags would be rendered differently, and data which has
+  // been shortened by decoding the unsynchronisation does not match the
+  // header anymore.
+
+  const unsigned int frameSize = d->header->size() + d->header->frameSize();
+  if(d->header->version() >= 3 && data.size() >= frameSize &&
+     data[8] == 0 && data[9] == 0) {
+    d->originalData = data.mid(0, frameSize);
+    d->originalVersion = d->header->version();
+  }
+}
+
+void Frame::discardOriginalData()
+{
+  if(!d->originalData.isEmpty())
+    d->originalData.clear();
+}
+
 PropertyMap Frame::asProperties() const
 {
   if(dynamic_cast< const UnknownFrame *>(this)) {
@@ -422,6 +473,9 @@ void Frame::splitProperties(const PropertyMap &original, PropertyMap &singleFram
 class Frame::Header::HeaderPrivate
 {
 public:
+  static void *operator new(size_t size) { return Arena::allocate(size); }
+  static void operator delete(void *p) { Arena::deallocate(p); }
+
   ByteVector frameID;
   unsigned int frameSize { 0 };
   unsigned int version { 4 };
@@ -464,6 +518,16 @@ Frame::Header::Header(const ByteVector &data, unsigned int version) :
 
 Frame::Header::~Header() = default;
 
+void *Frame::Header::operator new(size_t size)
+{
+  return Arena::allocate(size);
+}
+
+void Frame::Header::operator delete(void *p)
+{
+  Arena::deallocate(p);
+}
+
 void Frame::Header::setData(const ByteVector &data, unsigned int version)
 {
   d->version = version;
@@ -68,6 +68,18 @@ namespace TagLib {
       Frame(const Frame &) = delete;
       Frame &operator=(const Frame &) = delete;
 
+      /*!
+       * Allocates frames from the arena of the file while its tag is parsed.
+       *
+       * \see IOStream::setArenaBlockSize()
+       */
+      static void *operator new(size_t size);
+
+      /*!
+       * Releases a frame allocated by operator new().
+       */
+      static void operator delete(void *p);
+
       /*!
        * Returns the Frame ID
        * (<a href="https://github.com/taglib/taglib/blob/master/taglib/mpeg/id3v2/id3v2.4.0-structure.txt">
@@ -122,7 +134,11 @@ namespace TagLib {
       virtual StringList toStringList() const;
 
       /*!
-       * Render the frame back to its binary format in a ByteVector.
+       * Render the frame back to its binary format in a ByteVector.  Frames
+       * which keep the data they were read from and have not been modified
+       * return that data.
+       *
+       * \see keepOriginalData()
        */
       ByteVector render() const;
 
@@ -242,6 +258,21 @@ namespace TagLib {
       String::Type checkTextEncoding(const StringList &fields,
                                      String::Type encoding) const;
 
+      /*!
+       * Keeps the frame data \a data the frame has been read from, so that
+       * render() returns it instead of rendering the fields again while the
+       * frame is not modified.  The data is only kept if it is stored without
+       * flags, i.e. not compressed or otherwise encoded.  This is useful for
+       * frames with large binary fields, subclasses which use it must call
+       * discardOriginalData() whenever their fields are changed.
+       */
+      void keepOriginalData(const ByteVector &data);
+
+      /*!
+       * Discards the data kept by keepOriginalData(), so that the frame is
+       * rendered from its fields again.
+       */
+      void discardOriginalData();
 
       /*!
        * Parses the contents of this frame as PropertyMap. If that fails, the returned
@@ -309,6 +340,18 @@ namespace TagLib {
       Header(const Header &) = delete;
       Header &operator=(const Header &) = delete;
 
+      /*!
+       * Allocates headers from the arena of the file while its tag is parsed.
+       *
+       * \see IOStream::setArenaBlockSize()
+       */
+      static void *operator new(size_t size);
+
+      /*!
+       * Releases a header allocated by operator new().
+       */
+      static void operator delete(void *p);
+
       /*!
        * Sets the data for the Header.  \a version should indicate the ID3v2
        * version number of the tag that this frame is contained in.
@@ -26,6 +26,7 @@
 #include "id3v2framefactory.h"
 
 #include <array>
+#include <atomic>
 #include <utility>
 
 #include "tutils.h"
@@ -109,8 +110,11 @@ namespace
 class FrameFactory::FrameFactoryPrivate
 {
 public:
-  String::Type defaultEncoding { String::Latin1 };
-  bool useDefaultEncoding { false };
+  // The default factory is shared by all threads, its settings may be
+  // changed while frames are created.
+
+  std::atomic<String::Type> defaultEncoding { String::Latin1 };
+  std::atomic<bool> useDefaultEncoding { false };
 
   template <class T> void setTextEncoding(T *frame)
   {
@@ -170,9 +174,8 @@ std::pair<Frame::Header *, bool> FrameFactory::prepareFrameHeader(
   if(version > 3 && (tagHeader->unsynchronisation() || header->unsynchronisation())) {
     // Data lengths are not part of the encoded data, but since they are synch-safe
     // integers they will be never actually encoded.
-    ByteVector frameData = data.mid(header->size(), header->frameSize());
-    frameData = SynchData::decode(frameData);
-    data = data.mid(0, header->size()) + frameData;
+    data = data.mid(0, header->size() + header->frameSize());
+    SynchData::decodeInPlace(data, header->size());
   }
 
   // TagLib doesn't mess with encrypted frames, so just treat them
@@ -442,8 +445,8 @@ String::Type FrameFactory::defaultTextEncoding() const
 
 void FrameFactory::setDefaultTextEncoding(String::Type encoding)
 {
-  d->useDefaultEncoding = true;
   d->defaultEncoding = encoding;
+  d->useDefaultEncoding = true;
 }
 
 bool FrameFactory::isUsingDefaultTextEncoding() const
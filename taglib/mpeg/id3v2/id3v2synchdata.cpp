@@ -25,6 +25,11 @@
 
 #include "id3v2synchdata.h"
 
+#include <cstring>
+#include <utility>
+
+#include "tsimd.h"
+
 using namespace TagLib;
 using namespace ID3v2;
 
@@ -72,29 +77,82 @@ ByteVector SynchData::fromUInt(unsigned int value)
 
 ByteVector SynchData::decode(const ByteVector &data)
 {
-  if(data.isEmpty()) {
-    return ByteVector();
-  }
-
-  // We have this optimized method instead of using ByteVector::replace(),
-  // since it makes a great difference when decoding huge unsynchronized frames.
-
-  ByteVector result(data.size());
+  ByteVector result = data;
+  decodeInPlace(result);
+  return result;
+}
 
-  auto src = data.begin();
-  auto dst = result.begin();
+void SynchData::decodeInPlace(ByteVector &data, unsigned int offset)
+{
+  if(offset >= data.size())
+    return;
+
+  // Only the runs between the pairs 0xFF 0x00 are moved, they are located
+  // with the vectorized search.  The data is only detached from other
+  // ByteVectors if there is something to remove.
+
+  static constexpr char pair[] = { '\xff', '\x00' };
+
+  const char *const constBegin = std::as_const(data).data();
+  const char *found = Simd::find(constBegin + offset, constBegin + data.size(), pair, 2);
+  if(!found)
+    return;
+
+  const auto firstPair = static_cast<size_t>(found - constBegin);
+  char *const begin = data.data();
+  char *const end = begin + data.size();
+  char *dst = begin + firstPair + 1;
+  const char *src = dst + 1;
+
+  while(src < end) {
+    const char *next = Simd::find(src, end, pair, 2);
+    const char *runEnd = next ? next + 1 : end;
+    const auto length = static_cast<size_t>(runEnd - src);
+    ::memmove(dst, src, length);
+    dst += length;
+    src = next ? runEnd + 1 : end;
+  }
 
-  while(src < data.end() - 1) {
-    *dst++ = *src++;
+  data.resize(static_cast<unsigned int>(dst - begin));
+}
 
-    if(*(src - 1) == '\xff' && *src == '\x00')
-      ++src;
+ByteVector SynchData::encode(const ByteVector &data)
+{
+  // Only the 0xFF bytes have to be looked at, the runs between them are
+  // copied as a whole.  The first pass counts the zero bytes to insert, so
+  // that the result is allocated once.
+
+  const char *const begin = data.data();
+  const char *const end = begin + data.size();
+  const char ff = '\xff';
+
+  const auto needsZero = [end](const char *next) {
+    return next == end || *next == '\x00' ||
+           (static_cast<unsigned char>(*next) & 0xE0) == 0xE0;
+  };
+
+  unsigned int count = 0;
+  for(const char *p = Simd::find(begin, end, &ff, 1); p; p = Simd::find(p + 1, end, &ff, 1)) {
+    if(needsZero(p + 1))
+      ++count;
   }
 
-  if(src < data.end())
-    *dst++ = *src++;
-
-  result.resize(static_cast<unsigned int>(dst - result.begin()));
+  if(count == 0)
+    return data;
+
+  ByteVector result(data.size() + count);
+  char *dst = result.data();
+  const char *src = begin;
+  for(const char *p = Simd::find(begin, end, &ff, 1); p; p = Simd::find(p + 1, end, &ff, 1)) {
+    if(needsZero(p + 1)) {
+      const auto length = static_cast<size_t>(p + 1 - src);
+      ::memcpy(dst, src, length);
+      dst += length;
+      *dst++ = '\x00';
+      src = p + 1;
+    }
+  }
+  ::memcpy(dst, src, static_cast<size_t>(end - src));
 
   return result;
 }
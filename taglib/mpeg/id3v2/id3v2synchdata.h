@@ -60,8 +60,26 @@ namespace TagLib {
 
       /*!
        * Convert the data from unsynchronized data to its original format.
+       *
+       * \see decodeInPlace()
        */
       TAGLIB_EXPORT ByteVector decode(const ByteVector &data);
+
+      /*!
+       * Converts the bytes of \a data after the first \a offset bytes from
+       * unsynchronized data to their original format in place.  Nothing is
+       * copied if \a data does not contain unsynchronized bytes or if it is
+       * not shared with another ByteVector.
+       */
+      TAGLIB_EXPORT void decodeInPlace(ByteVector &data, unsigned int offset = 0);
+
+      /*!
+       * Returns \a data unsynchronized, i.e. with a zero byte inserted after
+       * each 0xFF byte which is followed by a zero byte or could be taken as
+       * the start of an MPEG frame sync, and after a 0xFF byte at the end.
+       * decode() restores the original data.
+       */
+      TAGLIB_EXPORT ByteVector encode(const ByteVector &data);
     }  // namespace SynchData
 
   }  // namespace ID3v2
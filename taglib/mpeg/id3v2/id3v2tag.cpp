@@ -27,11 +27,15 @@
 
 #include <algorithm>
 #include <array>
+#include <map>
 #include <utility>
+#include <vector>
 
 #include "tdebug.h"
 #include "tfile.h"
 #include "tpropertymap.h"
+#include "tzlib.h"
+#include "tarena.h"
 #include "id3v2header.h"
 #include "id3v2extendedheader.h"
 #include "id3v2footer.h"
@@ -58,6 +62,67 @@ namespace
   constexpr long MaxPaddingSize = 1024 * 1024;
   constexpr unsigned int MAX_ID3V2_FRAME_COUNT = 50000;
 
+  // Number of bytes read from an attached picture frame whose image data is
+  // skipped, enough for the fields in front of the data in nearly all files.
+  constexpr unsigned int DeferredPictureFieldsLength = 1024;
+
+  // Same limits as for reading compressed frames completely.
+  constexpr unsigned int MaxDeferredDecompressedSize = 64U * 1024U * 1024U;
+  constexpr unsigned int MaxDeferredCompressionRatio = 64;
+
+  // An attached picture frame of which only the beginning is parsed.
+
+  struct DeferredFrame
+  {
+    // Start and body size of the frame in the file.
+    offset_t frameOffset;
+    unsigned int frameSize;
+    // The frame body without the data length indicator and its encoding.
+    offset_t bodyOffset;
+    unsigned int bodySize;
+    int encoding;
+    // The data length indicator of a compressed frame.
+    unsigned int decodedSize;
+    // Number of bytes of the decoded body passed to parse().
+    unsigned int headLength;
+  };
+
+  // A frame of which only the header has been read by a lazily parsing tag.
+
+  struct IndexedFrame
+  {
+    ByteVector frameID;
+    // Position of the frame in the data passed to parse().
+    unsigned int position;
+    bool created;
+    // The frame which was added to the tag when it was created, if any.
+    ID3v2::Frame *frame;
+  };
+
+  bool isFrameIDLike(const ByteVector &data, unsigned int length)
+  {
+    if(data.size() < length)
+      return false;
+    return std::all_of(data.begin(), data.begin() + length, [](char c) {
+      return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    });
+  }
+
+  // Replaces the frame size in the frame header \a header.
+
+  void setFrameSizeField(ByteVector &header, unsigned int version, unsigned int size)
+  {
+    if(version < 3) {
+      const ByteVector sizeData = ByteVector::fromUInt(size);
+      std::copy(sizeData.begin() + 1, sizeData.end(), header.begin() + 3);
+    }
+    else {
+      const ByteVector sizeData =
+        version == 3 ? ByteVector::fromUInt(size) : SynchData::fromUInt(size);
+      std::copy(sizeData.begin(), sizeData.end(), header.begin() + 4);
+    }
+  }
+
   /*!
    * Downgrade ID3v2.4 text \a encoding to value supported by ID3v2.3.
    */
@@ -100,6 +165,18 @@ public:
 
   FrameListMap frameListMap;
   FrameList frameList;
+  const FrameList emptyFrameList;
+
+  // Attached picture frames shortened by readDeferringPictures(), keyed by
+  // their position in the data passed to parse().
+  std::map<unsigned int, DeferredFrame> deferredFrames;
+
+  // Frames indexed by parse() if they are parsed lazily, the data and header
+  // of the tag are kept to create them when they are accessed.
+  std::vector<IndexedFrame> indexedFrames;
+  ByteVector indexedData;
+  std::unique_ptr<Header> indexedHeader;
+  size_t pendingFrameCount { 0 };
 };
 
 class ID3v2::Latin1StringHandler::Latin1StringHandlerPrivate
@@ -143,28 +220,28 @@ ID3v2::Tag::~Tag() = default;
 
 String ID3v2::Tag::title() const
 {
-  if(!d->frameListMap["TIT2"].isEmpty())
-    return joinTagValues(d->frameListMap["TIT2"].front()->toStringList());
+  if(const FrameList &frames = frameList("TIT2"); !frames.isEmpty())
+    return joinTagValues(frames.front()->toStringList());
   return String();
 }
 
 String ID3v2::Tag::artist() const
 {
-  if(!d->frameListMap["TPE1"].isEmpty())
-    return joinTagValues(d->frameListMap["TPE1"].front()->toStringList());
+  if(const FrameList &frames = frameList("TPE1"); !frames.isEmpty())
+    return joinTagValues(frames.front()->toStringList());
   return String();
 }
 
 String ID3v2::Tag::album() const
 {
-  if(!d->frameListMap["TALB"].isEmpty())
-    return joinTagValues(d->frameListMap["TALB"].front()->toStringList());
+  if(const FrameList &frames = frameList("TALB"); !frames.isEmpty())
+    return joinTagValues(frames.front()->toStringList());
   return String();
 }
 
 String ID3v2::Tag::comment() const
 {
-  const FrameList &comments = d->frameListMap["COMM"];
+  const FrameList &comments = frameList("COMM");
 
   if(comments.isEmpty())
     return String();
@@ -180,7 +257,7 @@ String ID3v2::Tag::comment() const
 
 String ID3v2::Tag::genre() const
 {
-  const FrameList &tconFrames = d->frameListMap["TCON"];
+  const FrameList &tconFrames = frameList("TCON");
   if(tconFrames.isEmpty())
   {
     return String();
@@ -220,15 +297,15 @@ String ID3v2::Tag::genre() const
 
 unsigned int ID3v2::Tag::year() const
 {
-  if(!d->frameListMap["TDRC"].isEmpty())
-    return d->frameListMap["TDRC"].front()->toString().substr(0, 4).toInt();
+  if(const FrameList &frames = frameList("TDRC"); !frames.isEmpty())
+    return frames.front()->toString().substr(0, 4).toInt();
   return 0;
 }
 
 unsigned int ID3v2::Tag::track() const
 {
-  if(!d->frameListMap["TRCK"].isEmpty())
-    return d->frameListMap["TRCK"].front()->toString().toInt();
+  if(const FrameList &frames = frameList("TRCK"); !frames.isEmpty())
+    return frames.front()->toString().toInt();
   return 0;
 }
 
@@ -254,7 +331,7 @@ void ID3v2::Tag::setComment(const String &s)
     return;
   }
 
-  if(const FrameList &comments = d->frameListMap["COMM"]; !comments.isEmpty()) {
+  if(const FrameList &comments = frameList("COMM"); !comments.isEmpty()) {
     for(const auto &commFrame : comments) {
       auto frame = dynamic_cast<CommentsFrame *>(commFrame);
       if(frame && frame->description().isEmpty()) {
@@ -318,6 +395,7 @@ void ID3v2::Tag::setTrack(unsigned int i)
 
 bool ID3v2::Tag::isEmpty() const
 {
+  createIndexedFrames();
   return d->frameList.isEmpty();
 }
 
@@ -333,27 +411,40 @@ ExtendedHeader *ID3v2::Tag::extendedHeader() const
 
 const FrameListMap &ID3v2::Tag::frameListMap() const
 {
+  createIndexedFrames();
   return d->frameListMap;
 }
 
 const FrameList &ID3v2::Tag::frameList() const
 {
+  createIndexedFrames();
   return d->frameList;
 }
 
 const FrameList &ID3v2::Tag::frameList(const ByteVector &frameID) const
 {
-  return d->frameListMap[frameID];
+  createIndexedFrames(frameID);
+
+  // A missing frame ID is not added to the map by this lookup.
+
+  const auto it = d->frameListMap.find(frameID);
+  return it != d->frameListMap.end() ? it->second : d->emptyFrameList;
 }
 
 void ID3v2::Tag::addFrame(Frame *frame)
 {
+  // The frames are kept in the order of the tag, so all indexed frames have
+  // to exist before the list is modified.
+
+  createIndexedFrames();
   d->frameList.append(frame);
   d->frameListMap[frame->frameID()].append(frame);
 }
 
 void ID3v2::Tag::removeFrame(Frame *frame, bool del)
 {
+  createIndexedFrames();
+
   // remove the frame from the frame list
   auto it = d->frameList.find(frame);
   d->frameList.erase(it);
@@ -369,7 +460,7 @@ void ID3v2::Tag::removeFrame(Frame *frame, bool del)
 
 void ID3v2::Tag::removeFrames(const ByteVector &id)
 {
-  const FrameList frames = d->frameListMap[id];
+  const FrameList frames = frameList(id);
   for(const auto &frame : frames)
     removeFrame(frame, true);
 }
@@ -473,6 +564,8 @@ PropertyMap ID3v2::Tag::setProperties(const PropertyMap &origProps)
 StringList ID3v2::Tag::complexPropertyKeys() const
 {
   StringList keys;
+  createIndexedFrames("APIC");
+  createIndexedFrames("GEOB");
   if(d->frameListMap.contains("APIC")) {
     keys.append("PICTURE");
   }
@@ -486,7 +579,7 @@ List<VariantMap> ID3v2::Tag::complexProperties(const String &key) const
 {
   List<VariantMap> props;
   if(const String uppercaseKey = key.upper(); uppercaseKey == "PICTURE") {
-    const FrameList pictures = d->frameListMap.value("APIC");
+    const FrameList pictures = frameList("APIC");
     for(const Frame *frame : pictures) {
       if(auto picture = dynamic_cast<const AttachedPictureFrame *>(frame)) {
         VariantMap property;
@@ -500,7 +593,7 @@ List<VariantMap> ID3v2::Tag::complexProperties(const String &key) const
     }
   }
   else if(uppercaseKey == "GENERALOBJECT") {
-    const FrameList geobs = d->frameListMap.value("GEOB");
+    const FrameList geobs = frameList("GEOB");
     for(const Frame *frame : geobs) {
       if(auto geob = dynamic_cast<const GeneralEncapsulatedObjectFrame *>(frame)) {
         VariantMap property;
@@ -703,6 +796,8 @@ ByteVector ID3v2::Tag::render(Version version) const
   FrameList newFrames;
   newFrames.setAutoDelete(true);
 
+  createIndexedFrames();
+
   FrameList frames;
   if(version == v4) {
     frames = d->frameList;
@@ -792,14 +887,30 @@ void ID3v2::Tag::read()
   if(!d->file->isOpen())
     return;
 
+  // The frames are taken from the arena of the file, if it has one.
+
+  const Arena::Scope arenaScope(d->file);
+
   d->file->seek(d->tagOffset);
   d->header.setData(d->file->readBlock(Header::size()));
 
   // If the tag size is 0, then this is an invalid tag (tags must contain at
   // least one frame)
 
-  if(d->header.tagSize() != 0)
-    parse(d->file->readBlock(d->header.tagSize()));
+  // Reading frame by frame is only worthwhile if the tag is large enough to
+  // contain payloads which have to be skipped.
+
+  // The data read here is not shared, so an unsynchronised tag is decoded
+  // in place without another copy of the tag.
+
+  if(d->header.tagSize() != 0) {
+    ByteVector data = d->file->deferPayload(d->header.tagSize())
+      ? readDeferringPictures() : d->file->readBlock(d->header.tagSize());
+    if(d->header.unsynchronisation() && d->header.majorVersion() <= 3)
+      SynchData::decodeInPlace(data);
+    parseFrames(data);
+    d->deferredFrames.clear();
+  }
 
   // Look for duplicate ID3v2 tags and treat them as an extra blank of this one.
   // It leads to overwriting them with zero when saving the tag.
@@ -831,8 +942,34 @@ void ID3v2::Tag::parse(const ByteVector &origData)
   ByteVector data = origData;
 
   if(d->header.unsynchronisation() && d->header.majorVersion() <= 3)
-    data = SynchData::decode(data);
+    SynchData::decodeInPlace(data);
 
+  parseFrames(data);
+}
+
+void ID3v2::Tag::setTextFrame(const ByteVector &id, const String &value)
+{
+  if(value.isEmpty()) {
+    removeFrames(id);
+    return;
+  }
+
+  if(const FrameList &frames = frameList(id); !frames.isEmpty())
+    frames.front()->setText(value);
+  else {
+    const String::Type encoding = d->factory->defaultTextEncoding();
+    auto f = new TextIdentificationFrame(id, encoding);
+    addFrame(f);
+    f->setText(value);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+void ID3v2::Tag::parseFrames(const ByteVector &data)
+{
   unsigned int frameDataPosition = 0;
   unsigned int frameDataLength = data.size();
   unsigned int frameCount = 0;
@@ -857,6 +994,15 @@ void ID3v2::Tag::parse(const ByteVector &origData)
 
   // parse frames
 
+  // Frames of ID3v2.4 tags are stored with the ID they get from the default
+  // factory, so they can be looked up by their ID before they are created.
+
+  if(d->file && d->file->lazyFrameParsing() && d->factory == FrameFactory::instance() &&
+     d->header.majorVersion() == 4) {
+    indexFrames(data, frameDataPosition, frameDataLength);
+    return;
+  }
+
   // Make sure that there is at least enough room in the remaining frame data for
   // a frame header.
 
@@ -886,6 +1032,8 @@ void ID3v2::Tag::parse(const ByteVector &origData)
     if(!frame)
       return;
 
+    const unsigned int framePosition = frameDataPosition;
+
     if(frame->header()->version() == headerVersion) {
       frameDataPosition += frame->size() + frame->headerSize();
     } else {
@@ -896,7 +1044,10 @@ void ID3v2::Tag::parse(const ByteVector &origData)
       frameDataPosition += origHeader.frameSize() + origHeader.size();
     }
 
-    if(frame->size() > 0) {
+    if(!d->deferredFrames.empty())
+      frame = deferPictureData(frame, framePosition);
+
+    if(frame && frame->size() > 0) {
       addFrame(frame);
     } else {
       // A frame with size 0 is invalid, drop it. "A frame must be at least 1
@@ -908,19 +1059,301 @@ void ID3v2::Tag::parse(const ByteVector &origData)
   d->factory->rebuildAggregateFrames(this);
 }
 
-void ID3v2::Tag::setTextFrame(const ByteVector &id, const String &value)
+void ID3v2::Tag::indexFrames(const ByteVector &data, unsigned int position,
+                             unsigned int length)
 {
-  if(value.isEmpty()) {
-    removeFrames(id);
+  // The checks are the same as in parse() and FrameFactory::createFrame(),
+  // so that the frames are created as if they had been parsed immediately.
+
+  // The frames only depend on the version and the unsynchronisation flag of
+  // the tag header, which may be changed before they are created.
+
+  ByteVector headerData = Header::fileIdentifier();
+  headerData.append(ByteVector("\x04\x00", 2));
+  headerData.append(static_cast<char>(d->header.unsynchronisation() ? 0x80 : 0x00));
+  headerData.append(SynchData::fromUInt(0));
+
+  d->indexedData = data;
+  d->indexedHeader = std::make_unique<Header>(headerData);
+
+  unsigned int frameCount = 0;
+
+  while(position < length - Header::size()) {
+    if(data.at(position) == 0) {
+      if(d->header.footerPresent()) {
+        debug("Padding *and* a footer found.  This is not allowed by the spec.");
+      }
+
+      break;
+    }
+
+    if(frameCount++ >= MAX_ID3V2_FRAME_COUNT) {
+      debug("ID3v2::Tag::parse() -- Maximum frame count exceeded");
+      break;
+    }
+
+    const Frame::Header frameHeader(data.mid(position, Header::size()), 4);
+    ByteVector frameID = frameHeader.frameID();
+    const unsigned int frameSize = frameHeader.frameSize();
+    if(!isFrameIDLike(frameID, 4) ||
+       frameSize < (frameHeader.dataLengthIndicator() ? 4U : 0U) ||
+       frameSize > data.size() - position)
+      break;
+
+    if(frameID == "TRDC")
+      frameID = "TDRC";
+
+    // Frames with size 0 are dropped anyway, attached pictures whose image
+    // data is deferred are created now, they are already shortened.
+
+    if(frameSize > 0) {
+      d->indexedFrames.push_back({frameID, position, false, nullptr});
+      ++d->pendingFrameCount;
+      if(d->deferredFrames.find(position) != d->deferredFrames.end()) {
+        // All frames before it are still pending, so it goes to the end.
+        if(Frame *frame = createIndexedFrame(d->indexedFrames.size() - 1)) {
+          d->frameList.append(frame);
+          d->frameListMap[frame->frameID()].append(frame);
+        }
+      }
+    }
+
+    position += frameHeader.size() + frameSize;
+  }
+
+  if(d->pendingFrameCount == 0) {
+    d->indexedFrames.clear();
+    d->indexedData.clear();
+    d->indexedHeader.reset();
+  }
+}
+
+void ID3v2::Tag::createIndexedFrames(const ByteVector &frameID) const
+{
+  if(d->pendingFrameCount == 0)
     return;
+
+  const Arena::Scope arenaScope(d->file);
+
+  // The lists hold the frames created so far in the order of the tag.  They
+  // are walked along with the index, so that each new frame is inserted in
+  // front of the next frame which already exists, in the list of all frames
+  // and in the list of its frame ID.
+
+  auto next = d->frameList.begin();
+  std::map<ByteVector, FrameList::Iterator> nextWithID;
+  const auto nextWithSameID = [this, &nextWithID](const ByteVector &id) -> FrameList::Iterator & {
+    auto it = nextWithID.find(id);
+    if(it == nextWithID.end())
+      it = nextWithID.emplace(id, d->frameListMap[id].begin()).first;
+    return it->second;
+  };
+
+  for(size_t i = 0; i < d->indexedFrames.size(); ++i) {
+    const IndexedFrame &indexed = d->indexedFrames[i];
+    if(indexed.created) {
+      if(indexed.frame) {
+        ++next;
+        ++nextWithSameID(indexed.frame->frameID());
+      }
+    }
+    else if(frameID.isEmpty() || indexed.frameID == frameID) {
+      if(Frame *frame = createIndexedFrame(i)) {
+        const ByteVector id = frame->frameID();
+        d->frameList.insert(next, frame);
+        d->frameListMap[id].insert(nextWithSameID(id), frame);
+      }
+    }
   }
 
-  if(!d->frameListMap[id].isEmpty())
-    d->frameListMap[id].front()->setText(value);
-  else {
-    const String::Type encoding = d->factory->defaultTextEncoding();
-    auto f = new TextIdentificationFrame(id, encoding);
-    addFrame(f);
-    f->setText(value);
+  if(d->pendingFrameCount == 0) {
+    d->indexedFrames.clear();
+    d->indexedData.clear();
+    d->indexedHeader.reset();
+  }
+}
+
+ID3v2::Frame *ID3v2::Tag::createIndexedFrame(size_t index) const
+{
+  IndexedFrame &indexed = d->indexedFrames[index];
+  indexed.created = true;
+  --d->pendingFrameCount;
+
+  Frame *frame = d->factory->createFrame(d->indexedData.mid(indexed.position),
+                                         d->indexedHeader.get());
+  if(frame && !d->deferredFrames.empty())
+    frame = deferPictureData(frame, indexed.position);
+
+  if(frame && frame->size() == 0) {
+    delete frame;
+    frame = nullptr;
   }
+
+  indexed.frame = frame;
+  return frame;
+}
+
+ByteVector ID3v2::Tag::readDeferringPictures()
+{
+  const unsigned int version = d->header.majorVersion();
+  const unsigned int headerSize = version < 3 ? 6 : 10;
+  const offset_t bodyOffset = d->tagOffset + Header::size();
+  const offset_t bodyEnd = bodyOffset + d->header.tagSize();
+
+  // The frames cannot be located in the file if the whole tag is
+  // unsynchronised or if there is an extended header.
+
+  struct SkippedFrame
+  {
+    offset_t offset;
+    unsigned int size;
+    int encoding;
+    unsigned int extraLength;
+    unsigned int decodedSize;
+  };
+  std::vector<SkippedFrame> skippedFrames;
+
+  if(!(d->header.unsynchronisation() && version <= 3) && !d->header.extendedHeader()) {
+    const unsigned int idLength = version < 3 ? 3 : 4;
+    offset_t position = bodyOffset;
+
+    while(true) {
+      d->file->seek(position);
+      const Frame::Header frameHeader(d->file->readView(headerSize), version);
+      const unsigned int frameSize = frameHeader.frameSize();
+      const offset_t nextPosition = position + frameHeader.size() + frameSize;
+      if(!isFrameIDLike(frameHeader.frameID(), idLength) || frameSize == 0 ||
+         nextPosition > bodyEnd)
+        break;
+
+      // Stop at the first frame which is not followed by another frame or
+      // padding, the frame size may be wrong then.
+
+      if(nextPosition < bodyEnd) {
+        d->file->seek(nextPosition);
+        const ByteVector nextID = d->file->readView(idLength);
+        if(!nextID.isEmpty() && nextID[0] != 0 && !isFrameIDLike(nextID, idLength))
+          break;
+      }
+
+      // Unsynchronised and compressed image data is decoded while it is read
+      // later, the data length indicator in front of it is only checked.
+
+      int encoding = DeferredData::Plain;
+      if(version > 3 && (d->header.unsynchronisation() || frameHeader.unsynchronisation()))
+        encoding |= DeferredData::Unsynchronised;
+      if(frameHeader.compression())
+        encoding |= DeferredData::Compressed;
+      const unsigned int extraLength =
+        frameHeader.compression() || frameHeader.dataLengthIndicator() ? 4 : 0;
+
+      if(frameHeader.frameID() == (version < 3 ? "PIC" : "APIC") &&
+         !frameHeader.encryption() && !frameHeader.groupingIdentity() &&
+         (!frameHeader.compression() || zlib::isAvailable()) &&
+         frameSize > DeferredPictureFieldsLength + extraLength &&
+         d->file->deferPayload(frameSize)) {
+        unsigned int decodedSize = 0xffffffff;
+        if(frameHeader.compression()) {
+          d->file->seek(position + headerSize);
+          decodedSize = SynchData::toUInt(d->file->readBlock(4));
+          if(decodedSize > MaxDeferredDecompressedSize ||
+             decodedSize > static_cast<uint64_t>(frameSize - extraLength) *
+                           MaxDeferredCompressionRatio) {
+            position = nextPosition;
+            continue;
+          }
+        }
+        skippedFrames.push_back({position, frameSize, encoding, extraLength, decodedSize});
+      }
+
+      position = nextPosition;
+    }
+  }
+
+  // Read the tag with the image data of the skipped frames left out.  The
+  // beginning of encoded frames is decoded and passed on as a plain frame.
+
+  ByteVector data;
+  offset_t position = bodyOffset;
+  for(const auto &[frameOffset, frameSize, encoding, extraLength, decodedSize] : skippedFrames) {
+    d->file->seek(position);
+    data.append(d->file->readBlock(static_cast<size_t>(frameOffset - position)));
+
+    ByteVector frameHeader = d->file->readBlock(headerSize);
+    const offset_t frameBodyOffset = frameOffset + headerSize + extraLength;
+    const unsigned int frameBodySize = frameSize - extraLength;
+
+    ByteVector head;
+    if(encoding == DeferredData::Plain && extraLength == 0) {
+      head = d->file->readBlock(DeferredPictureFieldsLength);
+    }
+    else {
+      head = d->file->deferData(frameBodyOffset, frameBodySize, encoding, 0, decodedSize)
+        .head(DeferredPictureFieldsLength);
+
+      // The head is passed on decoded, so the format flags are cleared.
+
+      frameHeader[9] = 0;
+    }
+
+    // If the decoded frame is shorter than the part which is read anyway, it
+    // is passed on completely.
+
+    if(head.size() == DeferredPictureFieldsLength) {
+      d->deferredFrames[data.size()] = {
+        frameOffset, frameSize, frameBodyOffset, frameBodySize, encoding, decodedSize,
+        head.size()
+      };
+    }
+
+    // Frames of unsynchronised ID3v2.4 tags are decoded by the frame factory.
+
+    if(version > 3 && d->header.unsynchronisation())
+      head = SynchData::encode(head);
+
+    setFrameSizeField(frameHeader, version, head.size());
+    data.append(frameHeader);
+    data.append(head);
+
+    position = frameOffset + headerSize + frameSize;
+  }
+  d->file->seek(position);
+  data.append(d->file->readBlock(static_cast<size_t>(bodyEnd - position)));
+
+  return data;
+}
+
+Frame *ID3v2::Tag::deferPictureData(Frame *frame, unsigned int position) const
+{
+  const auto it = d->deferredFrames.find(position);
+  if(it == d->deferredFrames.end())
+    return frame;
+
+  const DeferredFrame &deferred = it->second;
+
+  // The image data is what remains of the bytes read after the fields.  If
+  // the fields did not fit, the complete frame has to be read after all.
+
+  if(auto picture = dynamic_cast<AttachedPictureFrame *>(frame);
+     picture && !picture->picture().isEmpty()) {
+    const unsigned int fieldsLength = deferred.headLength - picture->picture().size();
+    if(deferred.encoding == DeferredData::Plain) {
+      picture->setDeferredData(d->file->deferData(deferred.bodyOffset + fieldsLength,
+                                                  deferred.bodySize - fieldsLength));
+    }
+    else {
+      picture->setDeferredData(d->file->deferData(deferred.bodyOffset, deferred.bodySize,
+                                                  deferred.encoding, fieldsLength,
+                                                  deferred.decodedSize));
+    }
+    picture->header()->setFrameSize(deferred.frameSize);
+    return frame;
+  }
+
+  delete frame;
+
+  const unsigned int headerSize = d->header.majorVersion() < 3 ? 6 : 10;
+  d->file->seek(deferred.frameOffset);
+  const ByteVector frameData = d->file->readBlock(headerSize + deferred.frameSize);
+  return d->factory->createFrame(frameData, &d->header);
 }
@@ -379,8 +379,8 @@ namespace TagLib {
       void read();
 
       /*!
-       * This is called by read to parse the body of the tag.  It determines if an
-       * extended header exists and adds frames to the FrameListMap.
+       * Parses the body of the tag.  It determines if an extended header
+       * exists and adds frames to the FrameListMap.
        */
       void parse(const ByteVector &origData);
 
@@ -396,6 +396,46 @@ namespace TagLib {
       void downgradeFrames(FrameList *frames, FrameList *newFrames) const;
 
     private:
+      /*!
+       * Adds the frames in the body of the tag \a data, from which the
+       * unsynchronisation of the whole tag has already been removed.
+       */
+      void parseFrames(const ByteVector &data);
+
+      /*!
+       * Reads the body of the tag like read(), but reads only the beginning
+       * of attached picture frames whose image data should be deferred
+       * according to File::deferPayload().
+       */
+      ByteVector readDeferringPictures();
+
+      /*!
+       * Marks the image data of \a frame parsed at \a position in the data
+       * from readDeferringPictures() as deferred.  Returns the frame to add
+       * to the tag, which is a newly read frame if the image data could not
+       * be deferred, or null if that frame is invalid.
+       */
+      Frame *deferPictureData(Frame *frame, unsigned int position) const;
+
+      /*!
+       * Records the frames in \a data from \a position up to \a length
+       * without creating them, see IOStream::setLazyFrameParsing().
+       */
+      void indexFrames(const ByteVector &data, unsigned int position,
+                       unsigned int length);
+
+      /*!
+       * Creates the frames recorded by indexFrames() with the ID \a frameID,
+       * or all of them if \a frameID is empty, which do not exist yet.
+       */
+      void createIndexedFrames(const ByteVector &frameID = ByteVector()) const;
+
+      /*!
+       * Creates the recorded frame at \a index.  Returns the frame to add to
+       * the tag or a null pointer if it is empty or could not be created.
+       */
+      Frame *createIndexedFrame(size_t index) const;
+
       class TagPrivate;
       TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
       std::unique_ptr<TagPrivate> d;
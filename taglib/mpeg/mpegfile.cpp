@@ -31,6 +31,7 @@
 #include "id3v2framefactory.h"
 #include "tdebug.h"
 #include "tpropertymap.h"
+#include "tsimd.h"
 #ifdef TAGLIB_WITH_APE
 #include "apefooter.h"
 #include "apetag.h"
@@ -70,6 +71,8 @@ public:
   TagUnion tag;
 
   std::unique_ptr<Properties> properties;
+
+  std::unique_ptr<FrameIndex> frameIndex;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -225,10 +228,18 @@ bool MPEG::File::save(int tags, StripTags strip, ID3v2::Version version, Duplica
       Tag::duplicate(ID3v2Tag(), ID3v1Tag(true), false);
   }
 
-  // Remove all the tags not going to be saved.
+  // All tags are written in a single pass over the file, so the offsets in
+  // the plan refer to the file as it was before saving.  A tag which is not
+  // going to be saved is removed if the others are to be stripped or if it
+  // is empty.
+
+  WritePlan plan;
 
-  if(strip == StripOthers)
-    File::strip(~tags, false);
+  const offset_t fileLength = length();
+
+  bool writeID3v2 = false;
+  bool writeID3v1 = false;
+  bool writeAPE = false;
 
   if(ID3v2 & tags) {
 
@@ -236,49 +247,10 @@ bool MPEG::File::save(int tags, StripTags strip, ID3v2::Version version, Duplica
 
       // ID3v2 tag is not empty. Update the old one or create a new one.
 
-      if(d->ID3v2Location < 0)
-        d->ID3v2Location = 0;
-
       const ByteVector data = ID3v2Tag()->render(version);
-      insert(data, d->ID3v2Location, d->ID3v2OriginalSize);
-
-      if(d->APELocation >= 0)
-        d->APELocation += static_cast<long>(data.size()) - d->ID3v2OriginalSize;
-
-      if(d->ID3v1Location >= 0)
-        d->ID3v1Location += static_cast<long>(data.size()) - d->ID3v2OriginalSize;
-
+      plan.replace(std::max<offset_t>(d->ID3v2Location, 0), d->ID3v2OriginalSize, data);
       d->ID3v2OriginalSize = data.size();
-    }
-    else {
-
-      // ID3v2 tag is empty. Remove the old one.
-
-      File::strip(ID3v2, false);
-    }
-  }
-
-  if(ID3v1 & tags) {
-
-    if(ID3v1Tag() && !ID3v1Tag()->isEmpty()) {
-
-      // ID3v1 tag is not empty. Update the old one or create a new one.
-
-      if(d->ID3v1Location >= 0) {
-        seek(d->ID3v1Location);
-      }
-      else {
-        seek(0, End);
-        d->ID3v1Location = tell();
-      }
-
-      writeBlock(ID3v1Tag()->render());
-    }
-    else {
-
-      // ID3v1 tag is empty. Remove the old one.
-
-      File::strip(ID3v1, false);
+      writeID3v2 = true;
     }
   }
 
@@ -293,27 +265,66 @@ bool MPEG::File::save(int tags, StripTags strip, ID3v2::Version version, Duplica
         if(d->ID3v1Location >= 0)
           d->APELocation = d->ID3v1Location;
         else
-          d->APELocation = length();
+          d->APELocation = fileLength;
       }
 
       const ByteVector data = APETag()->render();
-      insert(data, d->APELocation, d->APEOriginalSize);
-
-      if(d->ID3v1Location >= 0)
-        d->ID3v1Location += static_cast<long>(data.size()) - d->APEOriginalSize;
-
+      plan.replace(d->APELocation, d->APEOriginalSize, data);
       d->APEOriginalSize = data.size();
+      writeAPE = true;
     }
-    else {
+  }
+#endif
 
-      // APE tag is empty. Remove the old one.
+  if(ID3v1 & tags) {
+
+    if(ID3v1Tag() && !ID3v1Tag()->isEmpty()) {
 
-      File::strip(APE, false);
+      // ID3v1 tag is not empty. Update the old one or create a new one.
+
+      if(d->ID3v1Location >= 0)
+        plan.replace(d->ID3v1Location, fileLength - d->ID3v1Location, ID3v1Tag()->render());
+      else
+        plan.replace(fileLength, 0, ID3v1Tag()->render());
+      writeID3v1 = true;
     }
   }
-#endif
 
-  return true;
+  if(!writeID3v2 && d->ID3v2Location >= 0 &&
+     ((ID3v2 & tags) || strip == StripOthers)) {
+    plan.replace(d->ID3v2Location, d->ID3v2OriginalSize, ByteVector());
+    d->ID3v2Location = -1;
+    d->ID3v2OriginalSize = 0;
+  }
+
+  if(!writeAPE && d->APELocation >= 0 &&
+     ((APE & tags) || strip == StripOthers)) {
+    plan.replace(d->APELocation, d->APEOriginalSize, ByteVector());
+    d->APELocation = -1;
+    d->APEOriginalSize = 0;
+  }
+
+  if(!writeID3v1 && d->ID3v1Location >= 0 &&
+     ((ID3v1 & tags) || strip == StripOthers)) {
+    plan.replace(d->ID3v1Location, fileLength - d->ID3v1Location, ByteVector());
+    d->ID3v1Location = -1;
+  }
+
+  // The ID3v1 tag always ends up at the end of the file.
+
+  if(writeID3v2)
+    d->ID3v2Location = plan.newOffset(std::max<offset_t>(d->ID3v2Location, 0));
+  if(d->APELocation >= 0)
+    d->APELocation = plan.newOffset(d->APELocation);
+  if(writeID3v1)
+    d->ID3v1Location = fileLength + plan.lengthDelta() - 128;
+  else if(d->ID3v1Location >= 0)
+    d->ID3v1Location = plan.newOffset(d->ID3v1Location, true);
+
+  if(!plan.isEmpty())
+    d->frameIndex.reset();
+
+  return applyWritePlan(plan);
 }
 
 ID3v2::Tag *MPEG::File::ID3v2Tag(bool create)
@@ -342,6 +353,9 @@ bool MPEG::File::strip(int tags, bool freeMemory)
     return false;
   }
 
+  if(tags & AllTags)
+    d->frameIndex.reset();
+
   if((tags & ID3v2) && d->ID3v2Location >= 0) {
     removeBlock(d->ID3v2Location, d->ID3v2OriginalSize);
 
@@ -385,45 +399,64 @@ bool MPEG::File::strip(int tags, bool freeMemory)
 
 offset_t MPEG::File::nextFrameOffset(offset_t position)
 {
-  ByteVector frameSyncBytes(2, '\0');
+  // The next frame usually follows immediately, so start with a small buffer
+  // and only grow it when scanning through junk data.
+
+  unsigned int bufferLength = bufferSize();
 
   while(true) {
     seek(position);
-    const ByteVector buffer = readBlock(bufferSize());
-    if(buffer.isEmpty())
+    const ByteVector buffer = readBlock(bufferLength);
+    if(buffer.size() < 2)
       return -1;
 
-    for(unsigned int i = 0; i < buffer.size(); ++i) {
-      frameSyncBytes[0] = frameSyncBytes[1];
-      frameSyncBytes[1] = buffer[i];
-      if(isFrameSync(frameSyncBytes)) {
-        if(const Header header(this, position + i - 1, true); header.isValid())
-          return position + i - 1;
-      }
+    // Candidates are found with a vectorized scan and checked against the
+    // buffer first, only the remaining ones are parsed as full headers.
+
+    const char *const begin = buffer.data();
+    const char *const end = begin + buffer.size();
+    for(const char *p = begin; (p = Simd::findFrameSync(p, end)) != nullptr; ++p) {
+      if(!isPossibleFrameHeader(p, static_cast<size_t>(end - p)))
+        continue;
+      const offset_t offset = position + (p - begin);
+      if(const Header header(this, offset, true); header.isValid())
+        return offset;
     }
 
-    position += bufferSize();
+    // The last byte is read again, a frame sync may start there.
+
+    position += buffer.size() - 1;
+    bufferLength = std::min(bufferLength * 2, ioBufferSize());
   }
 }
 
 offset_t MPEG::File::previousFrameOffset(offset_t position)
 {
-  ByteVector frameSyncBytes(2, '\0');
+  offset_t maxBufferLength = bufferSize();
+
+  // Each block but the first one is read with the first byte of the block
+  // after it, so that frame syncs crossing the boundary are found.
+
+  offset_t overlap = 0;
 
   while(position > 0) {
-    const offset_t bufferLength = std::min<offset_t>(position, bufferSize());
+    const offset_t bufferLength = std::min<offset_t>(position, maxBufferLength);
     position -= bufferLength;
+    maxBufferLength = std::min<offset_t>(maxBufferLength * 2, ioBufferSize());
 
     seek(position);
-    const ByteVector buffer = readBlock(bufferLength);
-
-    for(int i = buffer.size() - 1; i >= 0; --i) {
-      frameSyncBytes[1] = frameSyncBytes[0];
-      frameSyncBytes[0] = buffer[i];
-      if(isFrameSync(frameSyncBytes)) {
-        if(const Header header(this, position + i, true); header.isValid())
-          return position + i + header.frameLength();
+    const ByteVector buffer = readBlock(bufferLength + overlap);
+    overlap = 1;
+
+    const char *const begin = buffer.data();
+    const char *end = begin + buffer.size();
+    while(const char *p = Simd::rfindFrameSync(begin, end)) {
+      if(isPossibleFrameHeader(p, static_cast<size_t>(begin + buffer.size() - p))) {
+        const offset_t offset = position + (p - begin);
+        if(const Header header(this, offset, true); header.isValid())
+          return offset + header.frameLength();
       }
+      end = p + 1;
     }
   }
 
@@ -454,6 +487,71 @@ offset_t MPEG::File::lastFrameOffset()
   return previousFrameOffset(position);
 }
 
+const MPEG::FrameIndex *MPEG::File::frameIndex() const
+{
+  return d->frameIndex.get();
+}
+
+const MPEG::FrameIndex *MPEG::File::buildFrameIndex(unsigned int framesPerSeekPoint)
+{
+  d->frameIndex.reset();
+
+  offset_t offset = firstFrameOffset();
+  if(offset < 0)
+    return nullptr;
+
+  offset_t streamEnd;
+  if(hasAPETag())
+    streamEnd = d->APELocation;
+  else if(hasID3v1Tag())
+    streamEnd = d->ID3v1Location;
+  else
+    streamEnd = length();
+
+  const Header firstHeader(this, offset, false);
+  const auto isSameStream = [&firstHeader](const Header &header) {
+    return header.isValid() &&
+      header.version() == firstHeader.version() &&
+      header.layer() == firstHeader.layer() &&
+      header.sampleRate() == firstHeader.sampleRate() &&
+      header.frameLength() > 0;
+  };
+
+  auto index = std::make_unique<FrameIndex>(framesPerSeekPoint);
+
+  while(offset >= 0 && offset < streamEnd) {
+
+    // Usually the next frame follows immediately and its header is checked
+    // against the first one.  Otherwise, skip to the next frame which is
+    // followed by a consistent one.
+
+    seek(offset);
+    if(const ByteVector sync = readView(2); sync.size() == 2 && isFrameSync(sync)) {
+      if(const Header header(this, offset, false);
+         isSameStream(header) && offset + header.frameLength() <= streamEnd) {
+        index->addFrame(offset, header);
+        offset += header.frameLength();
+        continue;
+      }
+    }
+    offset = nextFrameOffset(offset + 1);
+  }
+
+  if(index->isEmpty())
+    return nullptr;
+
+  d->frameIndex = std::move(index);
+  return d->frameIndex.get();
+}
+
+void MPEG::File::setFrameIndex(const FrameIndex &index)
+{
+  if(index.isEmpty())
+    d->frameIndex.reset();
+  else
+    d->frameIndex = std::make_unique<FrameIndex>(index);
+}
+
 bool MPEG::File::hasID3v1Tag() const
 {
   return d->ID3v1Location >= 0;
@@ -536,10 +634,11 @@ offset_t MPEG::File::findID3v2(Properties::ReadStyle readStyle)
   ByteVector frameSyncBytes(2, '\0');
   ByteVector tagHeaderBytes(3, '\0');
   long position = 0;
+  unsigned int bufferLength = bufferSize();
 
   while(true) {
     seek(position);
-    const ByteVector buffer = readBlock(bufferSize());
+    const ByteVector buffer = readBlock(bufferLength);
     if(buffer.isEmpty())
       return -1;
 
@@ -558,6 +657,7 @@ offset_t MPEG::File::findID3v2(Properties::ReadStyle readStyle)
         return position + i - 2;
     }
 
-    position += bufferSize();
+    position += bufferLength;
+    bufferLength = std::min(bufferLength * 2, ioBufferSize());
   }
 }
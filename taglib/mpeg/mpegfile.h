@@ -30,6 +30,7 @@
 #include "taglib_export.h"
 #include "tag.h"
 #include "mpegproperties.h"
+#include "mpegframeindex.h"
 #include "id3v2.h"
 
 namespace TagLib {
@@ -319,6 +320,41 @@ namespace TagLib {
        */
       offset_t lastFrameOffset();
 
+      /*!
+       * Returns the index of the MPEG frames in the file or a null pointer if
+       * no index has been built.  The index is built when the audio
+       * properties are read with the Properties::Accurate read style and the
+       * stream has no VBR header, keeping a seek point for every 38 frames,
+       * or by calling buildFrameIndex().
+       *
+       * The index is discarded when the file is saved or tags are stripped,
+       * as the audio data may have moved.
+       *
+       * \see buildFrameIndex()
+       */
+      const FrameIndex *frameIndex() const;
+
+      /*!
+       * Scans all MPEG frames in the file and builds a FrameIndex keeping a
+       * seek point for every \a framesPerSeekPoint frames.  Frames which do
+       * not have the MPEG version, layer and sample rate of the first frame
+       * are skipped.  Returns the new index, which is owned by the file, or a
+       * null pointer if no frame was found.
+       *
+       * \see frameIndex()
+       */
+      const FrameIndex *buildFrameIndex(unsigned int framesPerSeekPoint = 1);
+
+      /*!
+       * Sets the index of the MPEG frames to \a index, e.g. one which has
+       * been rendered after a previous scan of the same file and restored
+       * with FrameIndex::parse().  An empty \a index removes the current
+       * index.
+       *
+       * \note The index is not checked against the file.
+       */
+      void setFrameIndex(const FrameIndex &index);
+
       /*!
        * Returns whether or not the file on disk actually has an ID3v1 tag.
        *
@@ -0,0 +1,242 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "mpegframeindex.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "tbytevector.h"
+#include "mpegheader.h"
+
+using namespace TagLib;
+
+namespace
+{
+  // Identifies a rendered index and its layout, which changes with the
+  // version byte.
+
+  const ByteVector Magic("TLFI", 4);
+  constexpr char FormatVersion = 1;
+
+  constexpr unsigned int PointSize = 16;
+  constexpr unsigned int HistogramEntrySize = 8;
+}  // namespace
+
+class MPEG::FrameIndex::FrameIndexPrivate
+{
+public:
+  FrameIndexPrivate(unsigned int framesPerSeekPoint) :
+    framesPerSeekPoint(std::max(framesPerSeekPoint, 1U))
+  {
+  }
+
+  unsigned int framesPerSeekPoint;
+  unsigned long long frameCount { 0 };
+  unsigned long long sampleCount { 0 };
+  int sampleRate { 0 };
+  offset_t streamLength { 0 };
+  Map<int, unsigned int> histogram;
+  std::vector<SeekPoint> seekPoints;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
+
+MPEG::FrameIndex::FrameIndex(unsigned int framesPerSeekPoint) :
+  d(std::make_unique<FrameIndexPrivate>(framesPerSeekPoint))
+{
+}
+
+MPEG::FrameIndex::FrameIndex(const FrameIndex &other) :
+  d(std::make_unique<FrameIndexPrivate>(*other.d))
+{
+}
+
+MPEG::FrameIndex::~FrameIndex() = default;
+
+MPEG::FrameIndex &MPEG::FrameIndex::operator=(const FrameIndex &other)
+{
+  if(this != &other)
+    *d = *other.d;
+  return *this;
+}
+
+void MPEG::FrameIndex::addFrame(offset_t offset, const Header &header)
+{
+  if(d->frameCount == 0)
+    d->sampleRate = header.sampleRate();
+
+  if(d->frameCount % d->framesPerSeekPoint == 0)
+    d->seekPoints.push_back({ offset, d->sampleCount });
+
+  ++d->frameCount;
+  d->sampleCount += header.samplesPerFrame();
+  d->streamLength += header.frameLength();
+  ++d->histogram[header.bitrate()];
+}
+
+bool MPEG::FrameIndex::isEmpty() const
+{
+  return d->frameCount == 0;
+}
+
+unsigned int MPEG::FrameIndex::framesPerSeekPoint() const
+{
+  return d->framesPerSeekPoint;
+}
+
+unsigned long long MPEG::FrameIndex::frameCount() const
+{
+  return d->frameCount;
+}
+
+unsigned long long MPEG::FrameIndex::sampleCount() const
+{
+  return d->sampleCount;
+}
+
+int MPEG::FrameIndex::sampleRate() const
+{
+  return d->sampleRate;
+}
+
+offset_t MPEG::FrameIndex::streamLength() const
+{
+  return d->streamLength;
+}
+
+int MPEG::FrameIndex::lengthInMilliseconds() const
+{
+  if(d->sampleRate <= 0)
+    return 0;
+
+  // A restored index may declare any sample count, a length which does not
+  // fit into int is rejected like the one of a VBR header.
+
+  const double length = d->sampleCount * 1000.0 / d->sampleRate + 0.5;
+  if(length >= static_cast<double>(std::numeric_limits<int>::max()))
+    return 0;
+
+  return static_cast<int>(length);
+}
+
+int MPEG::FrameIndex::bitrate() const
+{
+  const int length = lengthInMilliseconds();
+  if(length <= 0)
+    return 0;
+
+  const double bitrate = d->streamLength * 8.0 / length + 0.5;
+  if(bitrate < 0.0 || bitrate >= static_cast<double>(std::numeric_limits<int>::max()))
+    return 0;
+
+  return static_cast<int>(bitrate);
+}
+
+Map<int, unsigned int> MPEG::FrameIndex::bitrateHistogram() const
+{
+  return d->histogram;
+}
+
+unsigned int MPEG::FrameIndex::seekPointCount() const
+{
+  return static_cast<unsigned int>(d->seekPoints.size());
+}
+
+MPEG::FrameIndex::SeekPoint MPEG::FrameIndex::seekPoint(unsigned int index) const
+{
+  return d->seekPoints.at(index);
+}
+
+MPEG::FrameIndex::SeekPoint MPEG::FrameIndex::findSeekPoint(unsigned long long sample) const
+{
+  if(d->seekPoints.empty())
+    return { 0, 0 };
+
+  auto it = std::upper_bound(d->seekPoints.cbegin(), d->seekPoints.cend(), sample,
+    [](unsigned long long s, const SeekPoint &point) { return s < point.sample; });
+  if(it != d->seekPoints.cbegin())
+    --it;
+  return *it;
+}
+
+ByteVector MPEG::FrameIndex::render() const
+{
+  ByteVector data(Magic);
+  data.append(FormatVersion);
+  data.append(ByteVector::fromUInt(d->framesPerSeekPoint));
+  data.append(ByteVector::fromULongLong(d->frameCount));
+  data.append(ByteVector::fromULongLong(d->sampleCount));
+  data.append(ByteVector::fromUInt(d->sampleRate));
+  data.append(ByteVector::fromLongLong(d->streamLength));
+
+  data.append(ByteVector::fromUInt(d->histogram.size()));
+  for(const auto &[bitrate, count] : std::as_const(d->histogram)) {
+    data.append(ByteVector::fromUInt(bitrate));
+    data.append(ByteVector::fromUInt(count));
+  }
+
+  data.append(ByteVector::fromUInt(static_cast<unsigned int>(d->seekPoints.size())));
+  for(const auto &point : d->seekPoints) {
+    data.append(ByteVector::fromLongLong(point.offset));
+    data.append(ByteVector::fromULongLong(point.sample));
+  }
+
+  return data;
+}
+
+MPEG::FrameIndex MPEG::FrameIndex::parse(const ByteVector &data)
+{
+  constexpr unsigned int HeaderSize = 4 + 1 + 4 + 8 + 8 + 4 + 8 + 4;
+
+  if(data.size() < HeaderSize || !data.startsWith(Magic) || data[4] != FormatVersion)
+    return FrameIndex();
+
+  unsigned int pos = 5;
+  FrameIndex index(data.toUInt(pos));
+  FrameIndexPrivate &p = *index.d;
+  p.frameCount = data.toULongLong(pos += 4);
+  p.sampleCount = data.toULongLong(pos += 8);
+  p.sampleRate = static_cast<int>(data.toUInt(pos += 8));
+  p.streamLength = data.toLongLong(pos += 4);
+
+  const unsigned int histogramSize = data.toUInt(pos += 8);
+  pos += 4;
+  if(histogramSize > (data.size() - pos) / HistogramEntrySize)
+    return FrameIndex();
+  for(unsigned int i = 0; i < histogramSize; ++i, pos += HistogramEntrySize)
+    p.histogram.insert(static_cast<int>(data.toUInt(pos)), data.toUInt(pos + 4));
+
+  if(data.size() - pos < 4)
+    return FrameIndex();
+  const unsigned int pointCount = data.toUInt(pos);
+  pos += 4;
+  if((data.size() - pos) % PointSize != 0 || (data.size() - pos) / PointSize != pointCount)
+    return FrameIndex();
+  p.seekPoints.reserve(pointCount);
+  for(unsigned int i = 0; i < pointCount; ++i, pos += PointSize)
+    p.seekPoints.push_back({ data.toLongLong(pos), data.toULongLong(pos + 8) });
+
+  return index;
+}
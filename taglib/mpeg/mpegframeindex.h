@@ -0,0 +1,179 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_MPEGFRAMEINDEX_H
+#define TAGLIB_MPEGFRAMEINDEX_H
+
+#include <memory>
+
+#include "taglib.h"
+#include "taglib_export.h"
+#include "tmap.h"
+
+namespace TagLib {
+
+  class ByteVector;
+
+  namespace MPEG {
+
+    class Header;
+
+    //! An index of the frames of an MPEG stream
+
+    /*!
+     * This holds the totals of a complete scan over the frames of an MPEG
+     * stream together with seek points, i.e. the offsets of every
+     * framesPerSeekPoint() frames and the number of the first sample in them.
+     * It gives the exact duration and bitrate distribution of a stream
+     * without a VBR header and maps sample positions to file offsets without
+     * scanning the file again.
+     *
+     * The index can be stored with render() and restored with parse(), e.g.
+     * in a cache of a music library.  It is only valid as long as the audio
+     * data of the file is not modified and does not move, which is the case
+     * when the tags are saved.
+     *
+     * \see File::buildFrameIndex()
+     */
+
+    class TAGLIB_EXPORT FrameIndex
+    {
+    public:
+      /*!
+       * A position in the stream which can be used to start decoding.
+       */
+      struct SeekPoint {
+        //! The offset of the frame in the file
+        offset_t offset;
+        //! The number of the first sample in the frame, starting at zero
+        unsigned long long sample;
+      };
+
+      /*!
+       * Constructs an empty index which keeps a seek point for every
+       * \a framesPerSeekPoint frames.
+       */
+      explicit FrameIndex(unsigned int framesPerSeekPoint = 1);
+
+      /*!
+       * Constructs a copy of \a other.
+       */
+      FrameIndex(const FrameIndex &other);
+
+      /*!
+       * Destroys this FrameIndex instance.
+       */
+      ~FrameIndex();
+
+      /*!
+       * Copies the contents of \a other into this index.
+       */
+      FrameIndex &operator=(const FrameIndex &other);
+
+      /*!
+       * Adds the frame at \a offset described by \a header.  Frames have to
+       * be added in the order they appear in the stream.
+       */
+      void addFrame(offset_t offset, const Header &header);
+
+      /*!
+       * Returns \c true if no frame has been added.
+       */
+      bool isEmpty() const;
+
+      /*!
+       * Returns the number of frames for which a seek point is kept.
+       */
+      unsigned int framesPerSeekPoint() const;
+
+      /*!
+       * Returns the number of frames in the stream.
+       */
+      unsigned long long frameCount() const;
+
+      /*!
+       * Returns the number of samples per channel in the stream.
+       */
+      unsigned long long sampleCount() const;
+
+      /*!
+       * Returns the sample rate of the first frame in Hz.
+       */
+      int sampleRate() const;
+
+      /*!
+       * Returns the sum of the lengths of all frames in bytes.
+       */
+      offset_t streamLength() const;
+
+      /*!
+       * Returns the duration of the stream in milliseconds.
+       */
+      int lengthInMilliseconds() const;
+
+      /*!
+       * Returns the average bitrate of the stream in kb/s.
+       */
+      int bitrate() const;
+
+      /*!
+       * Returns the number of frames for each bitrate in kb/s.
+       */
+      Map<int, unsigned int> bitrateHistogram() const;
+
+      /*!
+       * Returns the number of seek points.
+       */
+      unsigned int seekPointCount() const;
+
+      /*!
+       * Returns the seek point at \a index, which must be less than
+       * seekPointCount().
+       */
+      SeekPoint seekPoint(unsigned int index) const;
+
+      /*!
+       * Returns the last seek point which starts at or before \a sample, or
+       * the first one if \a sample is before it.  The index must not be
+       * empty.
+       */
+      SeekPoint findSeekPoint(unsigned long long sample) const;
+
+      /*!
+       * Renders the index into a binary representation which can be read
+       * again with parse().
+       */
+      ByteVector render() const;
+
+      /*!
+       * Reads an index from \a data as rendered by render().  Returns an
+       * empty index if \a data is not a valid index.
+       */
+      static FrameIndex parse(const ByteVector &data);
+
+    private:
+      class FrameIndexPrivate;
+      TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
+      std::unique_ptr<FrameIndexPrivate> d;
+    };
+  }  // namespace MPEG
+}  // namespace TagLib
+
+#endif
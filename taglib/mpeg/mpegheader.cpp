@@ -152,7 +152,7 @@ MPEG::Header &MPEG::Header::operator=(const Header &h)
 void MPEG::Header::parse(File *file, offset_t offset, bool checkLength)
 {
   file->seek(offset);
-  const ByteVector data = file->readBlock(4);
+  const ByteVector data = file->readView(4);
 
   if(data.size() < 4) {
     debug("MPEG::Header::parse() -- data is too short for an MPEG frame header.");
@@ -233,7 +233,7 @@ void MPEG::Header::parse(File *file, offset_t offset, bool checkLength)
     d->isCopyrighted = (static_cast<unsigned char>(data[3]) & 0x04) != 0;
 
     // Calculate the frame length
-    if(const ByteVector frameLengthData = file->readBlock(2);
+    if(const ByteVector frameLengthData = file->readView(2);
        frameLengthData.size() >= 2) {
       d->frameLength = (static_cast<unsigned char>(data[3]) & 0x3) << 11 |
                        (static_cast<unsigned char>(frameLengthData[0]) << 3) |
@@ -342,7 +342,7 @@ void MPEG::Header::parse(File *file, offset_t offset, bool checkLength)
       return;
 
     file->seek(offset + d->frameLength);
-    const ByteVector nextData = file->readBlock(4);
+    const ByteVector nextData = file->readView(4);
 
     if(nextData.size() < 4)
       return;
@@ -37,6 +37,14 @@
 
 using namespace TagLib;
 
+namespace
+{
+  // The frame index built for the accurate length keeps a seek point for
+  // about every second of a 44.1 kHz stream, a point for every frame would
+  // take about 2 MB per hour of audio.
+  constexpr unsigned int FramesPerSeekPoint = 38;
+}  // namespace
+
 class MPEG::Properties::PropertiesPrivate
 {
 public:
@@ -178,6 +186,15 @@ void MPEG::Properties::read(File *file, ReadStyle readStyle)
         d->bitrate = static_cast<int>(bitrate + 0.5);
     }
   }
+  else if(const FrameIndex *index = readStyle == Accurate ? file->buildFrameIndex(FramesPerSeekPoint) : nullptr;
+          index && index->lengthInMilliseconds() > 0) {
+
+    // Without a VBR header, the accurate length and bitrate are taken from a
+    // complete scan of the frames, which is kept by the file.
+
+    d->length = index->lengthInMilliseconds();
+    d->bitrate = index->bitrate();
+  }
   else {
     int bitRate = firstHeader.bitrate();
     if(firstHeader.isADTS()) {
@@ -193,6 +210,8 @@ void MPEG::Properties::read(File *file, ReadStyle readStyle)
       // is accurate enough, we stop when the average bytes/frame rate is stable
       // for 10 frames and then calculate the length from the estimated bitrate
       // and the stream length.
+      // With Accurate read style, all frames have already been counted in the
+      // frame index above, unless it could not be built.
       if(readStyle == Fast) {
         bitRate = 0;
         d->length = 0;
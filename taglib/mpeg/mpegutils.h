@@ -54,6 +54,41 @@ namespace TagLib
         return (b1 == 0xFF && b2 != 0xFF && (b2 & 0xE0) == 0xE0);
       }
 
+      /*!
+       * Returns \c false if the \a length bytes at \a data, which start with a
+       * frame sync, can not be the header of a valid frame because of reserved
+       * values in the version, layer, bitrate or sample rate fields.  This is
+       * a quick check for candidates found while scanning a buffer, it does
+       * not replace parsing a Header.  If \a length is less than 4, only the
+       * available bytes are checked.
+       */
+      inline bool isPossibleFrameHeader(const char *data, size_t length)
+      {
+        if(length < 2)
+          return true;
+
+        const unsigned char b2 = data[1];
+        const int versionBits = (b2 >> 3) & 0x03;
+        const int layerBits = (b2 >> 1) & 0x03;
+
+        if(versionBits == 1)
+          return false;
+
+        // Layer 0 is only used by ADTS, which is not checked further.
+
+        if(layerBits == 0)
+          return versionBits == 2 || versionBits == 3;
+
+        if(length < 3)
+          return true;
+
+        const unsigned char b3 = data[2];
+        const int bitrateIndex = (b3 >> 4) & 0x0F;
+        const int sampleRateIndex = (b3 >> 2) & 0x03;
+
+        return bitrateIndex != 0 && bitrateIndex != 0x0F && sampleRateIndex != 3;
+      }
+
     }  // namespace
   }  // namespace MPEG
 }  // namespace TagLib
@@ -47,7 +47,7 @@ offset_t Utils::findID3v1(File *file)
     file->seek(-131, File::End);
     const offset_t p = file->tell() + 3;
 
-    if(const TagLib::ByteVector data = file->readBlock(8);
+    if(const TagLib::ByteVector data = file->readView(8);
        data.containsAt(ID3v1::Tag::fileIdentifier(), 3) &&
 #ifdef TAGLIB_WITH_APE
        data != APE::Tag::fileIdentifier()
@@ -60,7 +60,7 @@ offset_t Utils::findID3v1(File *file)
     file->seek(-128, File::End);
     const offset_t p = file->tell();
 
-    if(file->readBlock(3) == ID3v1::Tag::fileIdentifier())
+    if(file->readView(3) == ID3v1::Tag::fileIdentifier())
       return p;
   }
 
@@ -74,7 +74,7 @@ offset_t Utils::findID3v2(File *file)
 
   file->seek(0);
 
-  if(file->readBlock(3) == ID3v2::Header::fileIdentifier())
+  if(file->readView(3) == ID3v2::Header::fileIdentifier())
     return 0;
 
   return -1;
@@ -92,7 +92,7 @@ offset_t Utils::findAPE(File *file, offset_t id3v1Location)
 
   const offset_t p = file->tell();
 
-  if(file->readBlock(8) ==
+  if(file->readView(8) ==
 #ifdef TAGLIB_WITH_APE
      APE::Tag::fileIdentifier()
 #else
@@ -115,13 +115,13 @@ ByteVector TagLib::Utils::readHeader(IOStream *stream, unsigned int length,
 
   if(skipID3v2) {
     stream->seek(0);
-    if(const ByteVector data = stream->readBlock(ID3v2::Header::size());
+    if(const ByteVector data = stream->readView(ID3v2::Header::size());
        data.startsWith(ID3v2::Header::fileIdentifier()))
       bufferOffset = ID3v2::Header(data).completeTagSize();
   }
 
   stream->seek(bufferOffset);
-  const ByteVector header = stream->readBlock(length);
+  const ByteVector header = stream->readView(length);
   stream->seek(originalPosition);
 
   if(headerOffset)
@@ -0,0 +1,222 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "tarena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tfile.h"
+
+using namespace TagLib;
+
+namespace
+{
+  // Allocations are aligned like those of operator new.
+
+  constexpr size_t Alignment = alignof(std::max_align_t);
+
+  // The blocks are made of whole pages, whose arena is looked up in a three
+  // level page map covering a 48 bit address space.  The tables are created
+  // on demand and kept until the program ends, so that lookups need neither
+  // locks nor anything but a few loads.
+
+  constexpr unsigned int PageBits = 12;
+  constexpr size_t PageSize = size_t(1) << PageBits;
+  constexpr unsigned int LevelBits = 12;
+  constexpr size_t LevelSize = size_t(1) << LevelBits;
+
+  struct PageMapLeaf
+  {
+    std::atomic<Arena *> arenas[LevelSize] {};
+  };
+
+  struct PageMapNode
+  {
+    std::atomic<PageMapLeaf *> leaves[LevelSize] {};
+  };
+
+  std::atomic<PageMapNode *> pageMap[LevelSize] {};
+
+  // Returns the value created by the first of the competing threads.
+
+  template <class T>
+  T *createEntry(std::atomic<T *> &entry)
+  {
+    T *existing = nullptr;
+    T *created = new T;
+    if(entry.compare_exchange_strong(existing, created, std::memory_order_acq_rel,
+                                     std::memory_order_acquire))
+      return created;
+
+    delete created;
+    return existing;
+  }
+
+  // Returns the page map entry of the page containing \a p, or a null pointer
+  // if the address is not covered or \a create is false and the tables do not
+  // exist yet.
+
+  std::atomic<Arena *> *pageEntry(const void *p, bool create)
+  {
+    const auto page = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) >> PageBits;
+    if(page >> (3 * LevelBits))
+      return nullptr;
+
+    auto &nodeEntry = pageMap[page >> (2 * LevelBits)];
+    PageMapNode *node = nodeEntry.load(std::memory_order_acquire);
+    if(!node) {
+      if(!create)
+        return nullptr;
+      node = createEntry(nodeEntry);
+    }
+
+    auto &leafEntry = node->leaves[(page >> LevelBits) & (LevelSize - 1)];
+    PageMapLeaf *leaf = leafEntry.load(std::memory_order_acquire);
+    if(!leaf) {
+      if(!create)
+        return nullptr;
+      leaf = createEntry(leafEntry);
+    }
+
+    return &leaf->arenas[page & (LevelSize - 1)];
+  }
+
+  void mapPages(const char *block, size_t size, Arena *arena)
+  {
+    for(size_t offset = 0; offset < size; offset += PageSize)
+      pageEntry(block + offset, false)->store(arena, std::memory_order_release);
+  }
+
+  // The references for the allocations are taken in batches, so that
+  // allocating does not need an atomic operation each time.
+
+  constexpr size_t ReferenceBatch = 256;
+
+  thread_local Arena *currentArena = nullptr;
+}  // namespace
+
+Arena::Arena(unsigned int blockSize) :
+  blockSize((std::max<size_t>(blockSize, PageSize) + PageSize - 1) / PageSize * PageSize)
+{
+}
+
+Arena::~Arena()
+{
+  for(char *block : blocks) {
+    mapPages(block, blockSize, nullptr);
+    ::operator delete(block, std::align_val_t(PageSize));
+  }
+}
+
+void Arena::release()
+{
+  const size_t count = 1 + reservedReferences;
+  reservedReferences = 0;
+  releaseReferences(count);
+}
+
+Arena *Arena::current()
+{
+  return currentArena;
+}
+
+void *Arena::allocate(size_t size)
+{
+  if(Arena *arena = currentArena) {
+    if(void *p = arena->allocateMemory(size))
+      return p;
+  }
+  return ::operator new(size);
+}
+
+void Arena::deallocate(void *p) noexcept
+{
+  if(!p)
+    return;
+
+  if(const auto entry = pageEntry(p, false)) {
+    if(Arena *arena = entry->load(std::memory_order_acquire)) {
+      arena->releaseReferences(1);
+      return;
+    }
+  }
+  ::operator delete(p);
+}
+
+void *Arena::allocateMemory(size_t size)
+{
+  size = (std::max<size_t>(size, 1) + Alignment - 1) / Alignment * Alignment;
+
+  // Large allocations go to the heap, so that they can be freed as soon as
+  // they are not needed anymore.
+
+  if(size > blockSize / 4 || (size > available && !addBlock()))
+    return nullptr;
+
+  if(reservedReferences == 0) {
+    references.fetch_add(ReferenceBatch, std::memory_order_relaxed);
+    reservedReferences = ReferenceBatch;
+  }
+  --reservedReferences;
+
+  void *p = position;
+  position += size;
+  available -= size;
+  return p;
+}
+
+bool Arena::addBlock()
+{
+  auto block = static_cast<char *>(::operator new(blockSize, std::align_val_t(PageSize)));
+
+  // Create the page map tables first, so that the pages are mapped to this
+  // arena either completely or not at all.
+
+  for(size_t offset = 0; offset < blockSize; offset += PageSize) {
+    if(!pageEntry(block + offset, true)) {
+      ::operator delete(block, std::align_val_t(PageSize));
+      return false;
+    }
+  }
+
+  mapPages(block, blockSize, this);
+  blocks.push_back(block);
+  position = block;
+  available = blockSize;
+  return true;
+}
+
+void Arena::releaseReferences(size_t count)
+{
+  if(references.fetch_sub(count, std::memory_order_acq_rel) == count)
+    delete this;
+}
+
+Arena::Scope::Scope(const File *file) :
+  previous(currentArena)
+{
+  currentArena = file ? file->arena() : nullptr;
+}
+
+Arena::Scope::~Scope()
+{
+  currentArena = previous;
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_ARENA_H
+#define TAGLIB_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// THIS FILE IS NOT A PART OF THE TAGLIB API
+
+#ifndef DO_NOT_DOCUMENT  // tell Doxygen not to document this header
+
+namespace TagLib {
+
+  class File;
+
+  /*!
+   * A monotonic allocator for the small objects created while the tags of a
+   * File are parsed.  Memory is handed out from large blocks which are only
+   * freed together, when the file and all objects allocated from the arena
+   * are gone.
+   *
+   * Allocations go to the arena of the innermost Scope on the current
+   * thread, or to the heap if there is none.  The pages of the blocks are
+   * recorded in a global page map, so that deallocate() can tell arena
+   * memory from heap memory without a header in front of the allocations.
+   * Objects can thus be released from any thread and may outlive the file.
+   */
+  class Arena
+  {
+  public:
+    /*!
+     * Constructs an arena which allocates blocks of \a blockSize bytes.  The
+     * arena is referenced by its creator, which has to call release().
+     */
+    explicit Arena(unsigned int blockSize);
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /*!
+     * Drops the reference of the creator, the arena is destroyed once all
+     * objects allocated from it are released as well.
+     */
+    void release();
+
+    /*!
+     * Returns the arena of the innermost Scope on this thread or a null
+     * pointer if there is none.
+     */
+    static Arena *current();
+
+    /*!
+     * Allocates \a size bytes from the current arena or the heap, used by
+     * the class specific operator new of the parsed objects.
+     */
+    static void *allocate(size_t size);
+
+    /*!
+     * Releases memory returned by allocate() or an Allocator.
+     */
+    static void deallocate(void *p) noexcept;
+
+    /*!
+     * Creates a shared object from the current arena, or with
+     * std::make_shared() if there is none.
+     */
+    template <class T, class... Args>
+    static std::shared_ptr<T> makeShared(Args &&... args);
+
+    /*!
+     * Makes the arena of a file the current arena of this thread while the
+     * scope exists.
+     */
+    class Scope
+    {
+    public:
+      explicit Scope(const File *file);
+      ~Scope();
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+
+    private:
+      Arena *previous;
+    };
+
+    /*!
+     * An allocator for standard library types taking memory from a given
+     * arena, e.g. for std::allocate_shared(), which keeps a copy of the
+     * allocator with the object.
+     */
+    template <class T>
+    class Allocator
+    {
+    public:
+      using value_type = T;
+
+      explicit Allocator(Arena *arena) : arena(arena) {}
+      template <class U>
+      Allocator(const Allocator<U> &other) : arena(other.arena) {}
+
+      T *allocate(size_t n)
+      {
+        if(void *p = arena->allocateMemory(n * sizeof(T)))
+          return static_cast<T *>(p);
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+      }
+
+      void deallocate(T *p, size_t)
+      {
+        Arena::deallocate(p);
+      }
+
+      template <class U>
+      bool operator==(const Allocator<U> &other) const { return arena == other.arena; }
+      template <class U>
+      bool operator!=(const Allocator<U> &other) const { return arena != other.arena; }
+
+    private:
+      template <class U>
+      friend class Allocator;
+
+      Arena *arena;
+    };
+
+  private:
+    ~Arena();
+
+    void *allocateMemory(size_t size);
+    bool addBlock();
+    void releaseReferences(size_t count);
+
+    const size_t blockSize;
+    std::vector<char *> blocks;
+    char *position { nullptr };
+    size_t available { 0 };
+    std::atomic<size_t> references { 1 };
+    size_t reservedReferences { 0 };
+  };
+
+  template <class T, class... Args>
+  std::shared_ptr<T> Arena::makeShared(Args &&... args)
+  {
+    if(Arena *arena = current())
+      return std::allocate_shared<T>(Allocator<T>(arena), std::forward<Args>(args)...);
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  }
+
+}  // namespace TagLib
+
+#endif
+
+#endif
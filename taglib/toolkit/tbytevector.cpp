@@ -32,6 +32,8 @@
 #include <iostream>
 
 #include "tdebug.h"
+#include "tsimd.h"
+#include "tarena.h"
 #include "tutils.h"
 
 // This is a bit ugly to keep writing over and over again.
@@ -107,6 +109,59 @@ int findVector(
   return -1;
 }
 
+namespace {
+
+  // Alignments up to this value use the vectorized search and skip the
+  // unaligned matches, larger ones step through the data like findVector().
+
+  constexpr int MaxSimdByteAlign = 8;
+
+  // Returns the offset of the first occurrence of \a pattern at or after
+  // \a offset in \a data, which is a multiple of \a byteAlign away from
+  // \a offset, or -1.
+
+  int findContiguous(const char *data, size_t dataSize,
+                     const char *pattern, size_t patternSize,
+                     unsigned int offset, int byteAlign)
+  {
+    const char *const begin = data + offset;
+    const char *const end = data + dataSize;
+    for(const char *p = begin; p < end;) {
+      p = Simd::find(p, end, pattern, patternSize);
+      if(!p)
+        return -1;
+      const auto misalignment = static_cast<int>((p - begin) % byteAlign);
+      if(misalignment == 0)
+        return static_cast<int>(p - data);
+      p += byteAlign - misalignment;
+    }
+    return -1;
+  }
+
+  // Returns the offset of the last occurrence of \a pattern in \a data which
+  // starts at or before \a lastStart and is a multiple of \a byteAlign away
+  // from it, or -1.
+
+  int rfindContiguous(const char *data, size_t lastStart,
+                      const char *pattern, size_t patternSize, int byteAlign)
+  {
+    size_t limit = lastStart;
+    while(true) {
+      const char *p = Simd::rfind(data, data + limit + patternSize, pattern, patternSize);
+      if(!p)
+        return -1;
+      const auto start = static_cast<size_t>(p - data);
+      const auto misalignment = static_cast<int>((lastStart - start) % byteAlign);
+      if(misalignment == 0)
+        return static_cast<int>(start);
+      if(start < static_cast<size_t>(byteAlign - misalignment))
+        return -1;
+      limit = start - (byteAlign - misalignment);
+    }
+  }
+
+}  // namespace
+
 template <class T>
 T toNumber(const ByteVector &v, size_t offset, size_t length, bool mostSignificantByteFirst)
 {
@@ -248,26 +303,62 @@ long double toFloat80(const ByteVector &v, size_t offset)
 class ByteVector::ByteVectorPrivate
 {
 public:
+  // Vectors of up to this size, e.g. frame IDs, atom names and short fields,
+  // are stored here instead of in a shared buffer.  Copying them is cheaper
+  // than allocating and sharing the buffer.
+
+  static constexpr unsigned int InlineCapacity = 16;
+
   ByteVectorPrivate(unsigned int l, char c) :
-    data(std::make_shared<std::vector<char>>(l, c)),
-    offset(0),
-    length(l) { }
+    length(l)
+  {
+    if(l <= InlineCapacity)
+      std::fill_n(inlineData, l, c);
+    else
+      data = Arena::makeShared<std::vector<char>>(l, c);
+  }
 
   ByteVectorPrivate(const char *s, unsigned int l) :
-    data(std::make_shared<std::vector<char>>(s, s + l)),
-    offset(0),
-    length(l) { }
+    length(l)
+  {
+    if(l <= InlineCapacity)
+      std::copy_n(s, l, inlineData);
+    else
+      data = Arena::makeShared<std::vector<char>>(s, s + l);
+  }
 
   ByteVectorPrivate(const ByteVectorPrivate &d, unsigned int o, unsigned int l) :
-    data(d.data),
-    offset(d.offset + o),
     length(l)
   {
+    if(d.data && l > InlineCapacity) {
+      data = d.data;
+      offset = d.offset + o;
+    }
+    else {
+      length = std::min(l, InlineCapacity);
+      std::copy_n(d.begin() + o, length, inlineData);
+    }
   }
 
+  char *begin()
+  {
+    return data ? data->data() + offset : inlineData;
+  }
+
+  const char *begin() const
+  {
+    return data ? data->data() + offset : inlineData;
+  }
+
+  // Taken from the arena of the file being parsed, if any.
+
+  static void *operator new(size_t size) { return Arena::allocate(size); }
+  static void operator delete(void *p) { Arena::deallocate(p); }
+
   std::shared_ptr<std::vector<char>> data;
-  unsigned int       offset;
-  unsigned int       length;
+  unsigned int offset { 0 };
+  unsigned int length;
+  char inlineData[InlineCapacity];
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -382,12 +473,12 @@ ByteVector &ByteVector::setData(const char *data)
 char *ByteVector::data()
 {
   detach();
-  return !isEmpty() ? &(*d->data)[d->offset] : nullptr;
+  return !isEmpty() ? d->begin() : nullptr;
 }
 
 const char *ByteVector::data() const
 {
-  return !isEmpty() ? &(*d->data)[d->offset] : nullptr;
+  return !isEmpty() ? d->begin() : nullptr;
 }
 
 ByteVector ByteVector::mid(unsigned int index, unsigned int length) const
@@ -400,17 +491,29 @@ ByteVector ByteVector::mid(unsigned int index, unsigned int length) const
 
 char ByteVector::at(unsigned int index) const
 {
-  return index < size() ? (*d->data)[d->offset + index] : 0;
+  return index < size() ? d->begin()[index] : 0;
 }
 
 int ByteVector::find(const ByteVector &pattern, unsigned int offset, int byteAlign) const
 {
+  if(byteAlign > 0 && byteAlign <= MaxSimdByteAlign) {
+    if(pattern.isEmpty() || static_cast<size_t>(offset) + pattern.size() > size())
+      return -1;
+    return findContiguous(data(), size(), pattern.data(), pattern.size(), offset, byteAlign);
+  }
+
   return findVector<ConstIterator>(
     begin(), end(), pattern.begin(), pattern.end(), offset, byteAlign);
 }
 
 int ByteVector::find(char c, unsigned int offset, int byteAlign) const
 {
+  if(byteAlign > 0 && byteAlign <= MaxSimdByteAlign) {
+    if(offset >= size())
+      return -1;
+    return findContiguous(data(), size(), &c, 1, offset, byteAlign);
+  }
+
   return findChar<ConstIterator>(begin(), end(), c, offset, byteAlign);
 }
 
@@ -422,6 +525,13 @@ int ByteVector::rfind(const ByteVector &pattern, unsigned int offset, int byteAl
       offset = 0;
   }
 
+  if(byteAlign > 0 && byteAlign <= MaxSimdByteAlign) {
+    if(pattern.isEmpty() || static_cast<size_t>(offset) + pattern.size() > size())
+      return -1;
+    return rfindContiguous(data(), size() - pattern.size() - offset,
+                           pattern.data(), pattern.size(), byteAlign);
+  }
+
   const int pos = findVector<ConstReverseIterator>(
     rbegin(), rend(), pattern.rbegin(), pattern.rend(), offset, byteAlign);
 
@@ -579,12 +689,23 @@ ByteVector &ByteVector::resize(unsigned int size, char padding)
   if(size != d->length) {
     detach();
 
-    // Remove the excessive length of the internal buffer first to pad correctly.
-    // This doesn't reallocate the buffer, since std::vector::resize() doesn't
-    // reallocate the buffer when shrinking.
+    if(!d->data && size <= ByteVectorPrivate::InlineCapacity) {
+      if(size > d->length)
+        std::fill(d->inlineData + d->length, d->inlineData + size, padding);
+    }
+    else {
+      if(!d->data) {
+        d->data = Arena::makeShared<std::vector<char>>(
+          d->inlineData, d->inlineData + d->length);
+      }
+
+      // Remove the excessive length of the internal buffer first to pad correctly.
+      // This doesn't reallocate the buffer, since std::vector::resize() doesn't
+      // reallocate the buffer when shrinking.
 
-    d->data->resize(d->offset + d->length);
-    d->data->resize(d->offset + size, padding);
+      d->data->resize(d->offset + d->length);
+      d->data->resize(d->offset + size, padding);
+    }
 
     d->length = size;
   }
@@ -595,61 +716,53 @@ ByteVector &ByteVector::resize(unsigned int size, char padding)
 ByteVector::Iterator ByteVector::begin()
 {
   detach();
-  return d->data->begin() + d->offset;
+  return d->begin();
 }
 
 ByteVector::ConstIterator ByteVector::begin() const
 {
-  return d->data->begin() + d->offset;
+  return d->begin();
 }
 
 ByteVector::ConstIterator ByteVector::cbegin() const
 {
-  return d->data->cbegin() + d->offset;
+  return d->begin();
 }
 
 ByteVector::Iterator ByteVector::end()
 {
   detach();
-  return d->data->begin() + d->offset + d->length;
+  return d->begin() + d->length;
 }
 
 ByteVector::ConstIterator ByteVector::end() const
 {
-  return d->data->begin() + d->offset + d->length;
+  return d->begin() + d->length;
 }
 
 ByteVector::ConstIterator ByteVector::cend() const
 {
-  return d->data->cbegin() + d->offset + d->length;
+  return d->begin() + d->length;
 }
 
 ByteVector::ReverseIterator ByteVector::rbegin()
 {
-  detach();
-  return d->data->rbegin() + (d->data->size() - (d->offset + d->length));
+  return ReverseIterator(end());
 }
 
 ByteVector::ConstReverseIterator ByteVector::rbegin() const
 {
-  // Workaround for the Solaris Studio 12.4 compiler.
-  // We need a const reference to the data vector so we can ensure the const version of rbegin() is called.
-  const std::vector<char> &v = *d->data;
-  return v.rbegin() + (v.size() - (d->offset + d->length));
+  return ConstReverseIterator(end());
 }
 
 ByteVector::ReverseIterator ByteVector::rend()
 {
-  detach();
-  return d->data->rbegin() + (d->data->size() - d->offset);
+  return ReverseIterator(begin());
 }
 
 ByteVector::ConstReverseIterator ByteVector::rend() const
 {
-  // Workaround for the Solaris Studio 12.4 compiler.
-  // We need a const reference to the data vector so we can ensure the const version of rbegin() is called.
-  const std::vector<char> &v = *d->data;
-  return v.rbegin() + (v.size() - d->offset);
+  return ConstReverseIterator(begin());
 }
 
 bool ByteVector::isEmpty() const
@@ -751,13 +864,13 @@ long double ByteVector::toFloat80BE(size_t offset) const
 
 const char &ByteVector::operator[](int index) const
 {
-  return (*d->data)[d->offset + index];
+  return d->begin()[index];
 }
 
 char &ByteVector::operator[](int index)
 {
   detach();
-  return (*d->data)[d->offset + index];
+  return d->begin()[index];
 }
 
 bool ByteVector::operator==(const ByteVector &v) const
@@ -973,9 +1086,9 @@ ByteVector ByteVector::toBase64() const
 
 void ByteVector::detach()
 {
-  if(d->data.use_count() > 1) {
+  if(d->data && d->data.use_count() > 1) {
     if(!isEmpty())
-      ByteVector(&d->data->front() + d->offset, d->length).swap(*this);
+      ByteVector(d->begin(), d->length).swap(*this);
     else
       ByteVector().swap(*this);
   }
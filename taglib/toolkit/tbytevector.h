@@ -26,6 +26,7 @@
 #ifndef TAGLIB_BYTEVECTOR_H
 #define TAGLIB_BYTEVECTOR_H
 
+#include <iterator>
 #include <memory>
 #include <vector>
 #include <iosfwd>
@@ -40,16 +41,19 @@ namespace TagLib {
    * This class provides an implicitly shared byte vector with some methods that
    * are useful for tagging purposes.  Many of the search functions are tailored
    * to what is useful for finding tag related patterns in a data array.
+   *
+   * Short vectors of up to 16 bytes are stored without a separate buffer and
+   * are copied instead of being shared.
    */
 
   class TAGLIB_EXPORT ByteVector
   {
   public:
 #ifndef DO_NOT_DOCUMENT
-    using Iterator = std::vector<char>::iterator;
-    using ConstIterator = std::vector<char>::const_iterator;
-    using ReverseIterator = std::vector<char>::reverse_iterator;
-    using ConstReverseIterator = std::vector<char>::const_reverse_iterator;
+    using Iterator = char *;
+    using ConstIterator = const char *;
+    using ReverseIterator = std::reverse_iterator<char *>;
+    using ConstReverseIterator = std::reverse_iterator<const char *>;
 #endif
 
     /*!
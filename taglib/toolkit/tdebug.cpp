@@ -29,6 +29,7 @@
 
 #if !defined(NDEBUG) || defined(TRACE_IN_RELEASE)
 
+#include <atomic>
 #include <bitset>
 
 #include "tdebug.h"
@@ -39,11 +40,11 @@
 namespace TagLib
 {
   // The instance is defined in tdebuglistener.cpp.
-  extern DebugListener *debugListener;
+  extern std::atomic<DebugListener *> debugListener;
 
   void debug(const String &s)
   {
-    debugListener->printMessage("TagLib: " + s + "\n");
+    debugListener.load()->printMessage("TagLib: " + s + "\n");
   }
 
   void debugData(const ByteVector &v)
@@ -54,7 +55,7 @@ namespace TagLib
         "*** [%u] - char '%c' - int %d, 0x%02x, 0b%s\n",
         i, v[i], v[i], v[i], bits.c_str());
 
-      debugListener->printMessage(msg);
+      debugListener.load()->printMessage(msg);
     }
   }
 }  // namespace TagLib
@@ -25,7 +25,9 @@
 
 #include "tdebuglistener.h"
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
 
 #ifdef _WIN32
 # include <windows.h>
@@ -40,6 +42,10 @@ namespace
   public:
     void printMessage(const String &msg) override
     {
+      // Messages from different threads are written as a whole.
+
+      std::lock_guard<std::mutex> lock(mutex);
+
 #ifdef _WIN32
 
       const std::wstring wstr = msg.toWString();
@@ -57,6 +63,9 @@ namespace
 
 #endif
     }
+
+  private:
+    std::mutex mutex;
   };
 
   DefaultListener defaultListener;
@@ -68,7 +77,7 @@ namespace TagLib
   {
   };
 
-  DebugListener *debugListener = &defaultListener;
+  std::atomic<DebugListener *> debugListener { &defaultListener };
 
   DebugListener::DebugListener() = default;
 
@@ -68,6 +68,11 @@ namespace TagLib
    * \note The caller is responsible for deleting the previous listener
    * as needed after it is released.
    *
+   * \note The listener may be replaced while messages are printed from
+   * other threads, which may still be calling the previous listener.  The
+   * listener itself is called from all threads which read files, so it has
+   * to be thread safe.
+   *
    * \see DebugListener
    */
   TAGLIB_EXPORT void setDebugListener(DebugListener *listener);
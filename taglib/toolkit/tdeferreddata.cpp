@@ -0,0 +1,289 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "tdeferreddata.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tfile.h"
+#include "tdebug.h"
+#include "tzlib.h"
+#include "id3v2synchdata.h"
+
+using namespace TagLib;
+
+namespace
+{
+  // Size of the pieces in which the data is read.
+  constexpr unsigned int ChunkSize = 64 * 1024;
+
+  // Compressed data is not read if it would expand more than this.
+  constexpr offset_t MaxCompressionRatio = 64;
+}  // namespace
+
+class DeferredData::DeferredDataPrivate
+{
+public:
+  DeferredDataPrivate(File *file, offset_t offset, offset_t size, int encoding,
+                      offset_t skip, unsigned int maxLength) :
+    file(file),
+    offset(offset),
+    size(size),
+    encoding(encoding),
+    skip(skip),
+    maxLength(maxLength)
+  {
+  }
+
+  // Null once the data is loaded or the file is destroyed.
+  File *file;
+  offset_t offset;
+  offset_t size;
+  int encoding;
+  // Number of decoded bytes in front of the data.
+  offset_t skip;
+  // Maximum length of the decompressed data.
+  unsigned int maxLength;
+  ByteVector data;
+  bool loaded { false };
+};
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
+
+DeferredData::DeferredData() = default;
+
+DeferredData::DeferredData(const DeferredData &) = default;
+
+DeferredData::~DeferredData() = default;
+
+DeferredData &DeferredData::operator=(const DeferredData &) = default;
+
+void DeferredData::swap(DeferredData &other) noexcept
+{
+  using std::swap;
+
+  swap(d, other.d);
+}
+
+bool DeferredData::isNull() const
+{
+  return !d;
+}
+
+bool DeferredData::isLoaded() const
+{
+  return d && d->loaded;
+}
+
+offset_t DeferredData::offset() const
+{
+  return d ? d->offset : 0;
+}
+
+offset_t DeferredData::size() const
+{
+  return d ? d->size : 0;
+}
+
+int DeferredData::encoding() const
+{
+  return d ? d->encoding : Plain;
+}
+
+ByteVector DeferredData::data() const
+{
+  if(!d)
+    return ByteVector();
+
+  if(d->loaded)
+    return d->data;
+
+  if(!d->file) {
+    debug("DeferredData::data() -- The file has already been closed.");
+    return ByteVector();
+  }
+
+  // Mark the data as loaded even if it is incomplete, retrying would fail
+  // just the same.  Plain data is read at once.
+
+  if(d->encoding == Plain) {
+    File *file = d->file;
+    const offset_t position = file->tell();
+    file->seek(d->offset + d->skip);
+    d->data = file->readBlock(static_cast<size_t>(d->size - d->skip));
+    file->seek(position);
+    if(static_cast<offset_t>(d->data.size()) != d->size - d->skip)
+      debug("DeferredData::data() -- Failed to read the data.");
+  }
+  else {
+    decode([this](const ByteVector &piece) {
+      d->data.append(piece);
+      return true;
+    });
+  }
+  d->loaded = true;
+  d->file = nullptr;
+
+  return d->data;
+}
+
+ByteVector DeferredData::head(unsigned int length) const
+{
+  if(!d)
+    return ByteVector();
+
+  if(d->loaded)
+    return d->data.mid(0, length);
+
+  if(!d->file) {
+    debug("DeferredData::head() -- The file has already been closed.");
+    return ByteVector();
+  }
+
+  ByteVector result;
+  decode([&result, length](const ByteVector &piece) {
+    result.append(piece.mid(0, length - result.size()));
+    return result.size() < length;
+  });
+  return result;
+}
+
+bool DeferredData::writeTo(IOStream *sink) const
+{
+  if(!d || !sink)
+    return false;
+
+  if(d->loaded) {
+    sink->writeBlock(d->data);
+    return true;
+  }
+
+  if(!d->file) {
+    debug("DeferredData::writeTo() -- The file has already been closed.");
+    return false;
+  }
+
+  return decode([sink](const ByteVector &piece) {
+    sink->writeBlock(piece);
+    return true;
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+DeferredData::DeferredData(File *file, offset_t offset, offset_t size,
+                           int encoding, offset_t skip, unsigned int maxLength) :
+  d(std::make_shared<DeferredDataPrivate>(file, offset, size, encoding, skip,
+                                          maxLength))
+{
+}
+
+bool DeferredData::decode(const std::function<bool(const ByteVector &)> &consumer) const
+{
+  std::unique_ptr<zlib::Inflater> inflater;
+  if(d->encoding & Compressed) {
+    if(d->maxLength > d->size * MaxCompressionRatio) {
+      debug("DeferredData::decode() -- The data exceeds the decompression limit.");
+      return false;
+    }
+    inflater = std::make_unique<zlib::Inflater>(d->maxLength);
+  }
+
+  File *file = d->file;
+  const offset_t position = file->tell();
+
+  offset_t remaining = d->size;
+  offset_t skip = d->skip;
+  bool afterFF = false;
+  bool complete = true;
+
+  // Plain data does not have to be decoded to be skipped.
+
+  if(d->encoding == Plain) {
+    file->seek(d->offset + skip);
+    remaining -= skip;
+    skip = 0;
+  }
+  else {
+    file->seek(d->offset);
+  }
+
+  while(remaining > 0) {
+    ByteVector piece = file->readBlock(
+      static_cast<size_t>(std::min<offset_t>(remaining, ChunkSize)));
+    if(piece.isEmpty()) {
+      complete = false;
+      break;
+    }
+    remaining -= piece.size();
+
+    // A pair 0xFF 0x00 may be split between two pieces.
+
+    if(d->encoding & Unsynchronised) {
+      const bool dropFirst = afterFF && piece[0] == '\x00';
+      afterFF = piece[piece.size() - 1] == '\xff';
+      ID3v2::SynchData::decodeInPlace(piece, dropFirst ? 1 : 0);
+      if(dropFirst)
+        piece = piece.mid(1);
+    }
+
+    // The data up to the maximum length is still passed on if the
+    // decompressed data is too long.
+
+    if(inflater) {
+      piece = inflater->decompress(piece);
+      if(!inflater->isValid())
+        complete = false;
+    }
+
+    if(skip > 0) {
+      const auto skipped = static_cast<unsigned int>(std::min<offset_t>(skip, piece.size()));
+      piece = piece.mid(skipped);
+      skip -= skipped;
+    }
+
+    if(!piece.isEmpty() && !consumer(piece))
+      break;
+
+    if(inflater && (!inflater->isValid() || inflater->isFinished()))
+      break;
+  }
+
+  file->seek(position);
+
+  if(!complete)
+    debug("DeferredData::decode() -- Failed to read the data.");
+  return complete;
+}
+
+bool DeferredData::isShared() const
+{
+  return d && d.use_count() > 1;
+}
+
+void DeferredData::detach() const
+{
+  if(d)
+    d->file = nullptr;
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_DEFERREDDATA_H
+#define TAGLIB_DEFERREDDATA_H
+
+#include <memory>
+
+#include <functional>
+
+#include "tbytevector.h"
+#include "taglib_export.h"
+#include "taglib.h"
+
+namespace TagLib {
+
+  class File;
+  class IOStream;
+
+  //! A reference to data in a file which is only read when it is needed
+
+  /*!
+   * Large binary payloads such as embedded pictures are not read while the
+   * tags are parsed if they exceed the limits set with
+   * IOStream::setMaxPayloadSize() or IOStream::setReadBudget().  The objects
+   * holding such payloads keep a DeferredData instead, which reads the data
+   * from the file when data() is called for the first time.  Copies share the
+   * loaded data.
+   *
+   * The data is read through the File which created the reference using
+   * File::deferData().  Before that file is modified, it loads all data which
+   * is still referenced, because the offsets are no longer valid afterwards.
+   * If the file is destroyed before the data is loaded, data() returns an
+   * empty ByteVector.
+   *
+   * Instead of loading the data into memory, it can also be streamed to
+   * another IOStream using writeTo(), e.g. a FileStream created for a file
+   * descriptor.
+   */
+  class TAGLIB_EXPORT DeferredData
+  {
+  public:
+    /*!
+     * The encodings of the data in the file, which are undone when it is
+     * read.
+     */
+    enum Encoding {
+      //! The data is stored as is.
+      Plain = 0x0000,
+      //! The data is unsynchronised as described in the ID3v2 standard.
+      Unsynchronised = 0x0001,
+      //! The data is compressed with zlib, inside of the unsynchronisation.
+      Compressed = 0x0002
+    };
+
+    /*!
+     * Constructs a null reference.
+     */
+    DeferredData();
+
+    /*!
+     * Make a shallow, implicitly shared, copy of \a other.
+     */
+    DeferredData(const DeferredData &other);
+
+    /*!
+     * Destroys this DeferredData instance.
+     */
+    ~DeferredData();
+
+    /*!
+     * Make a shallow, implicitly shared, copy of \a other.
+     */
+    DeferredData &operator=(const DeferredData &other);
+
+    /*!
+     * Exchanges the content of this DeferredData with the content of \a other.
+     */
+    void swap(DeferredData &other) noexcept;
+
+    /*!
+     * Returns \c true if this does not reference any data.
+     */
+    bool isNull() const;
+
+    /*!
+     * Returns \c true if the data has already been read from the file.
+     */
+    bool isLoaded() const;
+
+    /*!
+     * Returns the offset of the data inside the file.
+     */
+    offset_t offset() const;
+
+    /*!
+     * Returns the size of the data in the file.  This differs from the size
+     * of data() if the data is encoded.
+     */
+    offset_t size() const;
+
+    /*!
+     * Returns the encodings of the data in the file, a combination of
+     * Encoding values.
+     */
+    int encoding() const;
+
+    /*!
+     * Returns the data, reading it from the file if this has not been done
+     * yet.  The position of the file is not changed.
+     */
+    ByteVector data() const;
+
+    /*!
+     * Returns the first \a length bytes of the data, only reading as much of
+     * the file as needed.  The data is not kept.
+     */
+    ByteVector head(unsigned int length) const;
+
+    /*!
+     * Writes the data to \a sink at its current position.  If the data has
+     * not been loaded yet, it is streamed from the file in pieces, decoding
+     * it on the way, and is not kept.  Returns \c false if the data could
+     * not be read completely.
+     */
+    bool writeTo(IOStream *sink) const;
+
+  private:
+    friend class File;
+
+    DeferredData(File *file, offset_t offset, offset_t size, int encoding,
+                 offset_t skip, unsigned int maxLength);
+
+    /*!
+     * Reads the data from the file in pieces and passes them to \a consumer
+     * until it returns \c false.  Returns \c false if the data could not be
+     * read.
+     */
+    bool decode(const std::function<bool(const ByteVector &)> &consumer) const;
+
+    /*!
+     * Returns \c true if other copies than the one kept by the file exist.
+     */
+    bool isShared() const;
+
+    /*!
+     * Forgets the file, which is about to be destroyed.
+     */
+    void detach() const;
+
+    class DeferredDataPrivate;
+    TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
+    std::shared_ptr<DeferredDataPrivate> d;
+  };
+
+}  // namespace TagLib
+
+#endif
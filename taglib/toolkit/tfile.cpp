@@ -25,9 +25,14 @@
 
 #include "tfile.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "tfilestream.h"
 #include "tpropertymap.h"
 #include "tstring.h"
+#include "tdebug.h"
+#include "tarena.h"
 
 #ifdef _WIN32
 # include <windows.h>
@@ -58,6 +63,8 @@ public:
   {
     if(streamOwner)
       delete stream;
+    if(arena)
+      arena->release();
   }
 
   FilePrivate(const FilePrivate &) = delete;
@@ -66,8 +73,64 @@ public:
   IOStream *stream;
   bool streamOwner;
   bool valid { true };
+  offset_t bytesRead { 0 };
+  std::vector<DeferredData> deferredData;
+  Arena *arena { nullptr };
+};
+
+class File::WritePlan::WritePlanPrivate
+{
+public:
+  struct Edit {
+    offset_t start;
+    offset_t length;
+    ByteVector data;
+  };
+
+  // Sorted by start, edits with the same start keep the order they were
+  // added in.
+  std::vector<Edit> edits;
 };
 
+File::WritePlan::WritePlan() :
+  d(std::make_unique<WritePlanPrivate>())
+{
+}
+
+File::WritePlan::~WritePlan() = default;
+
+void File::WritePlan::replace(offset_t start, size_t length, const ByteVector &data)
+{
+  const auto it = std::upper_bound(
+    d->edits.begin(), d->edits.end(), start,
+    [](offset_t offset, const WritePlanPrivate::Edit &edit) { return offset < edit.start; });
+  d->edits.insert(it, {start, static_cast<offset_t>(length), data});
+}
+
+bool File::WritePlan::isEmpty() const
+{
+  return d->edits.empty();
+}
+
+offset_t File::WritePlan::newOffset(offset_t offset, bool afterInsertions) const
+{
+  offset_t result = offset;
+  for(const auto &edit : d->edits) {
+    if(edit.start > offset || (edit.start == offset && (!afterInsertions || edit.length > 0)))
+      break;
+    result += static_cast<offset_t>(edit.data.size()) - edit.length;
+  }
+  return result;
+}
+
+offset_t File::WritePlan::lengthDelta() const
+{
+  offset_t delta = 0;
+  for(const auto &edit : d->edits)
+    delta += static_cast<offset_t>(edit.data.size()) - edit.length;
+  return delta;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // public members
 ////////////////////////////////////////////////////////////////////////////////
@@ -80,9 +143,15 @@ File::File(FileName fileName) :
 File::File(IOStream *stream) :
   d(std::make_unique<FilePrivate>(stream, false))
 {
+  if(const unsigned int blockSize = stream ? stream->arenaBlockSize() : 0)
+    d->arena = new Arena(blockSize);
 }
 
-File::~File() = default;
+File::~File()
+{
+  for(const auto &data : d->deferredData)
+    data.detach();
+}
 
 FileName File::name() const
 {
@@ -119,13 +188,74 @@ bool File::setComplexProperties(const String &key, const List<VariantMap> &value
   return tag()->setComplexProperties(key, value);
 }
 
+bool File::saveAtomically()
+{
+  if(readOnly()) {
+    debug("File::saveAtomically() -- File is read only.");
+    return false;
+  }
+
+  if(!d->stream->beginAtomicWrite()) {
+    debug("File::saveAtomically() -- Stream does not support atomic writes.");
+    return false;
+  }
+
+  if(!save()) {
+    d->stream->rollbackAtomicWrite();
+    return false;
+  }
+
+  return d->stream->commitAtomicWrite();
+}
+
 ByteVector File::readBlock(size_t length)
 {
-  return d->stream->readBlock(length);
+  ByteVector data = d->stream->readBlock(length);
+  d->bytesRead += data.size();
+  return data;
+}
+
+ByteVector File::readView(size_t length)
+{
+  ByteVector data = d->stream->readView(length);
+  d->bytesRead += data.size();
+  return data;
+}
+
+bool File::deferPayload(offset_t length) const
+{
+  if(const offset_t maxSize = d->stream->maxPayloadSize();
+     maxSize > 0 && length > maxSize)
+    return true;
+
+  const offset_t budget = d->stream->readBudget();
+  return budget > 0 && d->bytesRead + length > budget;
+}
+
+bool File::lazyFrameParsing() const
+{
+  return d->stream->lazyFrameParsing();
+}
+
+DeferredData File::deferData(offset_t offset, offset_t size, int encoding,
+                             offset_t skip, unsigned int maxLength)
+{
+  // Drop the references which are not used anymore, so that files with
+  // many deferred payloads do not keep them all.
+
+  d->deferredData.erase(
+    std::remove_if(d->deferredData.begin(), d->deferredData.end(),
+                   [](const DeferredData &data) { return !data.isShared(); }),
+    d->deferredData.end());
+
+  DeferredData data(this, offset, size, encoding, skip, maxLength);
+  d->deferredData.push_back(data);
+  return data;
 }
 
 void File::writeBlock(const ByteVector &data)
 {
+  loadDeferredData();
   d->stream->writeBlock(data);
 }
 
@@ -170,21 +300,28 @@ offset_t File::find(const ByteVector &pattern, offset_t fromOffset, const ByteVe
   // and do things appropriately if a match (or partial match) is found.  We
   // then check for "before".  The order is important because it gives priority
   // to "real" matches.
+  //
+  // Most patterns are found near the start offset, so the search starts with
+  // a small buffer which then grows up to the I/O buffer size of the stream.
 
-  for(auto buffer = readBlock(bufferSize()); !buffer.isEmpty(); buffer = readBlock(bufferSize())) {
+  const unsigned int maxBufferLength = ioBufferSize();
+  unsigned int bufferLength = bufferSize();
+  unsigned int previousBufferLength = 0;
+
+  for(auto buffer = readBlock(bufferLength); !buffer.isEmpty(); buffer = readBlock(bufferLength)) {
 
     // (1) previous partial match
 
-    if(previousPartialMatch >= 0 && static_cast<int>(bufferSize()) > previousPartialMatch) {
-      if(const int patternOffset = bufferSize() - previousPartialMatch;
+    if(previousPartialMatch >= 0 && static_cast<int>(previousBufferLength) > previousPartialMatch) {
+      if(const int patternOffset = previousBufferLength - previousPartialMatch;
          buffer.containsAt(pattern, 0, patternOffset)) {
         seek(originalPosition);
-        return bufferOffset - bufferSize() + previousPartialMatch;
+        return bufferOffset - previousBufferLength + previousPartialMatch;
       }
     }
 
-    if(!before.isEmpty() && beforePreviousPartialMatch >= 0 && static_cast<int>(bufferSize()) > beforePreviousPartialMatch) {
-      if(const int beforeOffset = bufferSize() - beforePreviousPartialMatch;
+    if(!before.isEmpty() && beforePreviousPartialMatch >= 0 && static_cast<int>(previousBufferLength) > beforePreviousPartialMatch) {
+      if(const int beforeOffset = previousBufferLength - beforePreviousPartialMatch;
          buffer.containsAt(before, 0, beforeOffset)) {
         seek(originalPosition);
         return -1;
@@ -211,7 +348,9 @@ offset_t File::find(const ByteVector &pattern, offset_t fromOffset, const ByteVe
     if(!before.isEmpty())
       beforePreviousPartialMatch = buffer.endsWithPartialMatch(before);
 
-    bufferOffset += bufferSize();
+    bufferOffset += bufferLength;
+    previousBufferLength = bufferLength;
+    bufferLength = std::min(bufferLength * 2, maxBufferLength);
   }
 
   // Since we hit the end of the file, reset the status before continuing.
@@ -251,6 +390,7 @@ offset_t File::rfind(const ByteVector &pattern, offset_t fromOffset, const ByteV
   if(fromOffset == 0)
     fromOffset = length();
 
+  const offset_t maxBufferLength = ioBufferSize();
   offset_t bufferLength = bufferSize();
   offset_t bufferOffset = fromOffset + pattern.size();
 
@@ -286,6 +426,8 @@ offset_t File::rfind(const ByteVector &pattern, offset_t fromOffset, const ByteV
     }
 
     // TODO: (3) partial match
+
+    bufferLength = std::min(bufferLength * 2, maxBufferLength);
   }
 
   // Since we hit the end of the file, reset the status before continuing.
@@ -299,14 +441,124 @@ offset_t File::rfind(const ByteVector &pattern, offset_t fromOffset, const ByteV
 
 void File::insert(const ByteVector &data, offset_t start, size_t replace)
 {
+  loadDeferredData();
   d->stream->insert(data, start, replace);
 }
 
 void File::removeBlock(offset_t start, size_t length)
 {
+  loadDeferredData();
   d->stream->removeBlock(start, length);
 }
 
+bool File::applyWritePlan(const WritePlan &plan)
+{
+  if(readOnly()) {
+    debug("File::applyWritePlan() -- File is read only.");
+    return false;
+  }
+
+  const auto &edits = plan.d->edits;
+  if(edits.empty())
+    return true;
+
+  // A single modification is left to the stream, which may be able to move
+  // the data more efficiently.
+
+  if(edits.size() == 1) {
+    const auto &edit = edits.front();
+    if(edit.start < 0 || edit.length < 0 || edit.start + edit.length > length()) {
+      debug("File::applyWritePlan() -- Invalid region.");
+      return false;
+    }
+    insert(edit.data, edit.start, static_cast<size_t>(edit.length));
+    return true;
+  }
+
+  // Collect the unmodified segments of the file between the edits together
+  // with the distance they have to be moved.
+
+  struct Segment {
+    offset_t start;
+    offset_t length;
+    offset_t shift;
+  };
+
+  const offset_t originalLength = length();
+
+  std::vector<Segment> segments;
+  offset_t position = 0;
+  offset_t shift = 0;
+  for(const auto &edit : edits) {
+    if(edit.start < position || edit.length < 0 ||
+       edit.start + edit.length > originalLength) {
+      debug("File::applyWritePlan() -- Overlapping or invalid regions.");
+      return false;
+    }
+    if(edit.start > position)
+      segments.push_back({position, edit.start - position, shift});
+    shift += static_cast<offset_t>(edit.data.size()) - edit.length;
+    position = edit.start + edit.length;
+  }
+  if(position < originalLength)
+    segments.push_back({position, originalLength - position, shift});
+
+  // During an atomic write the stream only records the modifications, so
+  // they are applied one by one from the back, which keeps the offsets of
+  // the edits in front valid.
+
+  if(d->stream->isAtomicWriteActive()) {
+    for(auto it = edits.crbegin(); it != edits.crend(); ++it)
+      insert(it->data, it->start, static_cast<size_t>(it->length));
+    return true;
+  }
+
+  // Segments moving towards the beginning are moved first from front to
+  // back, then the segments moving towards the end from back to front.  This
+  // way no segment is overwritten before it has been moved.
+
+  const auto bufferLength = static_cast<offset_t>(ioBufferSize());
+
+  const auto moveSegment = [this, bufferLength](const Segment &segment) {
+    for(offset_t done = 0; done < segment.length;) {
+      const offset_t count = std::min(bufferLength, segment.length - done);
+      const offset_t offset = segment.shift < 0
+        ? segment.start + done
+        : segment.start + segment.length - done - count;
+      seek(offset);
+      const ByteVector buffer = readBlock(static_cast<size_t>(count));
+      seek(offset + segment.shift);
+      writeBlock(buffer);
+      done += count;
+    }
+  };
+
+  for(auto it = segments.cbegin(); it != segments.cend(); ++it) {
+    if(it->shift < 0)
+      moveSegment(*it);
+  }
+  for(auto it = segments.crbegin(); it != segments.crend(); ++it) {
+    if(it->shift > 0)
+      moveSegment(*it);
+  }
+
+  // Finally write the new data into the gaps.
+
+  shift = 0;
+  for(const auto &edit : edits) {
+    if(!edit.data.isEmpty()) {
+      seek(edit.start + shift);
+      writeBlock(edit.data);
+    }
+    shift += static_cast<offset_t>(edit.data.size()) - edit.length;
+  }
+
+  if(shift < 0)
+    truncate(originalLength + shift);
+
+  return true;
+}
+
 bool File::readOnly() const
 {
   return d->stream->readOnly();
@@ -329,6 +581,7 @@ void File::seek(offset_t offset, Position p)
 
 void File::truncate(offset_t length)
 {
+  loadDeferredData();
   d->stream->truncate(length);
 }
 
@@ -356,7 +609,36 @@ unsigned int File::bufferSize()
   return 1024;
 }
 
+unsigned int File::ioBufferSize() const
+{
+  return std::max(bufferSize(), d->stream->ioBufferSize());
+}
+
 void File::setValid(bool valid)
 {
   d->valid = valid;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+void File::loadDeferredData()
+{
+  if(d->deferredData.empty())
+    return;
+
+  // Loading may not modify the list, it only reads.
+
+  const std::vector<DeferredData> deferredData = std::move(d->deferredData);
+  d->deferredData.clear();
+  for(const auto &data : deferredData) {
+    if(data.isShared())
+      data.data();
+  }
+}
+
+Arena *File::arena() const
+{
+  return d->arena;
+}
@@ -28,6 +28,7 @@
 
 #include "tbytevector.h"
 #include "tiostream.h"
+#include "tdeferreddata.h"
 #include "taglib_export.h"
 #include "taglib.h"
 #include "tag.h"
@@ -38,6 +39,7 @@ namespace TagLib {
   class Tag;
   class AudioProperties;
   class PropertyMap;
+  class Arena;
 
   //! A file class with some useful methods for tag manipulation
 
@@ -79,6 +81,70 @@ namespace TagLib {
       DoNotDuplicate //!< Do not synchronize values between different tag types
     };
 
+    //! A set of modifications of several regions of a file
+
+    /*!
+     * Saving a file often changes several regions at once, e.g. a tag at the
+     * beginning and another one at the end.  Doing this with separate calls
+     * to insert() moves the rest of the file each time.  A WritePlan collects
+     * all modifications, with offsets referring to the file before any of them
+     * is done, so that applyWritePlan() can move each part of the file at
+     * most once.
+     *
+     * \see applyWritePlan()
+     */
+    class TAGLIB_EXPORT WritePlan
+    {
+    public:
+      /*!
+       * Constructs an empty write plan.
+       */
+      WritePlan();
+
+      /*!
+       * Destroys this WritePlan instance.
+       */
+      ~WritePlan();
+
+      WritePlan(const WritePlan &) = delete;
+      WritePlan &operator=(const WritePlan &) = delete;
+
+      /*!
+       * Replaces \a length bytes at \a start with \a data.  \a length may be
+       * zero to insert data, \a data may be empty to remove data.  Several
+       * modifications at the same offset are done in the order they were
+       * added.
+       */
+      void replace(offset_t start, size_t length, const ByteVector &data);
+
+      /*!
+       * Returns \c true if no modification was added.
+       */
+      bool isEmpty() const;
+
+      /*!
+       * Returns the offset which the data at \a offset in the original file
+       * will have after the plan has been applied.  \a offset must not be
+       * inside a replaced region.  For an insertion at \a offset, this is the
+       * offset of the inserted data, unless \a afterInsertions is \c true, in
+       * which case it is the offset of the original data following the
+       * inserted data.
+       */
+      offset_t newOffset(offset_t offset, bool afterInsertions = false) const;
+
+      /*!
+       * Returns the difference between the length of the file after and
+       * before applying the plan.
+       */
+      offset_t lengthDelta() const;
+
+    private:
+      friend class File;
+      class WritePlanPrivate;
+      TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
+      std::unique_ptr<WritePlanPrivate> d;
+    };
+
     /*!
      * Destroys this File instance.
      */
@@ -174,11 +240,72 @@ namespace TagLib {
      */
     virtual bool save() = 0;
 
+    /*!
+     * Saves the file like save(), but writes the new content of the file to a
+     * temporary file in one sequential pass, which then replaces the
+     * original file in a single rename.  Other readers never see a partially
+     * written file and a crash during saving leaves the original file intact.
+     * No data has to be shifted within the file, but this needs additional
+     * disk space for the copy.  Returns \c true if the save succeeds; if it
+     * fails, the original file is unchanged.
+     *
+     * To use the format specific save() variants in this way, pass the
+     * File an own FileStream and wrap the call with
+     * IOStream::beginAtomicWrite() and IOStream::commitAtomicWrite().
+     *
+     * \note This fails if the stream does not support atomic writes, which
+     * currently only FileStream does.
+     *
+     * \see IOStream::beginAtomicWrite()
+     */
+    bool saveAtomically();
+
     /*!
      * Reads a block of size \a length at the current get pointer.
      */
     ByteVector readBlock(size_t length);
 
+    /*!
+     * Reads a block of size \a length at the current get pointer, the
+     * returned data may be shared with a read buffer of the stream.
+     *
+     * \see IOStream::readView()
+     */
+    ByteVector readView(size_t length);
+
+    /*!
+     * Returns \c true if a binary payload of \a length bytes, e.g. the data
+     * of an embedded picture, should not be read now but only have its
+     * position recorded.  This is the case if it is larger than
+     * IOStream::maxPayloadSize() or if reading it would exceed
+     * IOStream::readBudget() given the bytes read from this file so far.
+     */
+    bool deferPayload(offset_t length) const;
+
+    /*!
+     * Returns \c true if the frames of tags should only be indexed while the
+     * tags are read and be parsed when they are accessed.
+     *
+     * \see IOStream::setLazyFrameParsing()
+     */
+    bool lazyFrameParsing() const;
+
+    /*!
+     * Returns a reference to the \a size bytes at \a offset in the file,
+     * which are only read when they are requested.  All references which are
+     * still in use are loaded before the file is modified.
+     *
+     * \a encoding is a combination of DeferredData::Encoding values which
+     * are undone when the data is read, the first \a skip bytes of the
+     * decoded data are dropped.  Compressed data is not read if it
+     * decompresses to more than \a maxLength bytes.
+     *
+     * \see deferPayload()
+     */
+    DeferredData deferData(offset_t offset, offset_t size,
+                           int encoding = DeferredData::Plain, offset_t skip = 0,
+                           unsigned int maxLength = 0xffffffff);
+
     /*!
      * Attempts to write the block \a data at the current get pointer.  If the
      * file is currently only opened read only -- i.e. readOnly() returns \c true --
@@ -240,6 +367,16 @@ namespace TagLib {
      */
     void removeBlock(offset_t start = 0, size_t length = 0);
 
+    /*!
+     * Applies all modifications of \a plan in a single pass, the data between
+     * the modified regions is moved at most once.  Returns \c false without
+     * changing the file if the file is read only or if modified regions of the
+     * plan overlap or lie beyond the end of the file.
+     *
+     * \see WritePlan
+     */
+    bool applyWritePlan(const WritePlan &plan);
+
     /*!
      * Returns \c true if the file is read only (or if the file can not be opened).
      */
@@ -317,7 +454,29 @@ namespace TagLib {
      */
     static unsigned int bufferSize();
 
+    /*!
+     * Returns the maximum buffer size used when scanning large parts of the
+     * file, which is never smaller than bufferSize().
+     *
+     * \see IOStream::ioBufferSize()
+     */
+    unsigned int ioBufferSize() const;
+
   private:
+    friend class Arena;
+
+    /*!
+     * Loads the data referenced by deferData() before the file is modified.
+     */
+    void loadDeferredData();
+
+    /*!
+     * Returns the arena used while the tags are parsed or nullptr.
+     *
+     * \see IOStream::setArenaBlockSize()
+     */
+    Arena *arena() const;
+
     class FilePrivate;
     TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
     std::unique_ptr<FilePrivate> d;
@@ -25,11 +25,23 @@
 
 #include "tfilestream.h"
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <algorithm>
+#include <vector>
+
 #ifdef _WIN32
+# include <atomic>
+# include <string>
 # include <windows.h>
 #else
 # include <climits>
 # include <cstdio>
+# include <cstdlib>
+# include <fcntl.h>
+# include <sys/stat.h>
 # include <unistd.h>
 #endif
 
@@ -40,6 +52,16 @@ using namespace TagLib;
 
 namespace
 {
+  // A part of the content of a file during an atomic write, either a range of
+  // the original file or data written since the write was started.
+
+  struct Piece {
+    // Offset in the original file, -1 for data.
+    offset_t source;
+    offset_t length;
+    ByteVector data;
+  };
+
 #ifdef _WIN32
 
   // Uses Win32 native API instead of POSIX API to reduce the resource consumption.
@@ -84,14 +106,19 @@ namespace
     CloseHandle(file);
   }
 
-  size_t readFile(FileHandle file, ByteVector &buffer)
+  size_t readFile(FileHandle file, char *data, size_t size)
   {
     DWORD length;
-    if(ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &length, nullptr))
+    if(ReadFile(file, data, static_cast<DWORD>(size), &length, nullptr))
       return static_cast<size_t>(length);
     return 0;
   }
 
+  size_t readFile(FileHandle file, ByteVector &buffer)
+  {
+    return readFile(file, buffer.data(), buffer.size());
+  }
+
   size_t writeFile(FileHandle file, const ByteVector &buffer)
   {
     DWORD length;
@@ -100,6 +127,86 @@ namespace
     return 0;
   }
 
+  bool seekFile(FileHandle file, offset_t offset, IOStream::Position p)
+  {
+    LARGE_INTEGER liOffset;
+    liOffset.QuadPart = offset;
+    return SetFilePointerEx(file, liOffset, nullptr, static_cast<DWORD>(p)) != 0;
+  }
+
+  using PathString = std::wstring;
+
+  // Creates an empty file next to \a path and returns it opened for reading
+  // and writing, its name is stored in \a tempPath.
+
+  FileHandle createTempFile(const FileName &path, [[maybe_unused]] FileHandle original,
+                            PathString &tempPath)
+  {
+    // The names contain the process ID and a counter.  A name may still be
+    // taken by a file left behind by a crash, then the next one is tried.
+
+    static std::atomic<unsigned int> counter { 0 };
+
+    for(int attempt = 0; attempt < 100; ++attempt) {
+      tempPath = path.wstr() + L".taglib-" + std::to_wstring(GetCurrentProcessId()) +
+                 L"-" + std::to_wstring(counter++);
+
+#if defined (PLATFORM_WINRT)
+      FileHandle file = CreateFile2(tempPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                    FILE_SHARE_READ, CREATE_NEW, nullptr);
+#else
+      FileHandle file = CreateFileW(tempPath.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                    FILE_SHARE_READ, nullptr, CREATE_NEW,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+#endif
+      if(file != InvalidFileHandle)
+        return file;
+      if(GetLastError() != ERROR_FILE_EXISTS)
+        break;
+    }
+
+    tempPath.clear();
+    return InvalidFileHandle;
+  }
+
+  // Writes the content described by \a pieces to the empty file \a target in
+  // one sequential pass.
+
+  bool writePieces(FileHandle original, FileHandle target, const std::vector<Piece> &pieces)
+  {
+    ByteVector buffer;
+    for(const auto &piece : pieces) {
+      if(piece.source < 0) {
+        if(writeFile(target, piece.data) != piece.data.size())
+          return false;
+        continue;
+      }
+      if(!seekFile(original, piece.source, IOStream::Beginning))
+        return false;
+      for(offset_t done = 0; done < piece.length;) {
+        buffer.resize(static_cast<unsigned int>(std::min<offset_t>(piece.length - done, 1024 * 1024)));
+        const size_t count = readFile(original, buffer);
+        if(count != buffer.size() || writeFile(target, buffer) != count)
+          return false;
+        done += count;
+      }
+    }
+    return true;
+  }
+
+  bool syncDirectory([[maybe_unused]] const PathString &path)
+  {
+    // MoveFileEx() with MOVEFILE_WRITE_THROUGH only returns once the file
+    // has been moved on disk.
+
+    return true;
+  }
+
+  void removeFile(const PathString &path)
+  {
+    DeleteFileW(path.c_str());
+  }
+
 #else   // _WIN32
 
   struct FileNameHandle : public std::string
@@ -127,9 +234,14 @@ namespace
     fclose(file);
   }
 
+  size_t readFile(FileHandle file, char *data, size_t size)
+  {
+    return fread(data, sizeof(char), size, file);
+  }
+
   size_t readFile(FileHandle file, ByteVector &buffer)
   {
-    return fread(buffer.data(), sizeof(char), buffer.size(), file);
+    return readFile(file, buffer.data(), buffer.size());
   }
 
   size_t writeFile(FileHandle file, const ByteVector &buffer)
@@ -137,7 +249,280 @@ namespace
     return fwrite(buffer.data(), sizeof(char), buffer.size(), file);
   }
 
+  bool seekFile(FileHandle file, offset_t offset, IOStream::Position p)
+  {
+    int whence;
+    switch(p) {
+    case IOStream::Beginning:
+      whence = SEEK_SET;
+      break;
+    case IOStream::Current:
+      whence = SEEK_CUR;
+      break;
+    case IOStream::End:
+      whence = SEEK_END;
+      break;
+    default:
+      return false;
+    }
+
+    return fseek(file, offset, whence) == 0;
+  }
+
+  // Copies \a length bytes from \a from in \a inFd to \a to in \a outFd,
+  // if both are the same file, the two ranges must not overlap.
+  // copy_file_range() lets the kernel or the file system (e.g. by sharing
+  // extents) do the copy without passing the data through user space.  If it
+  // is not available or fails, \a useKernelCopy is cleared and the remaining
+  // data is copied with pread() and pwrite().
+
+  bool copyRange(int inFd, offset_t from, int outFd, offset_t to, offset_t length,
+                 bool &useKernelCopy)
+  {
+#ifdef HAVE_COPY_FILE_RANGE
+    while(useKernelCopy && length > 0) {
+      off_t in = from;
+      off_t out = to;
+      const ssize_t count = copy_file_range(inFd, &in, outFd, &out, static_cast<size_t>(length), 0);
+      if(count <= 0) {
+        useKernelCopy = false;
+        break;
+      }
+      from += count;
+      to += count;
+      length -= count;
+    }
+#else
+    useKernelCopy = false;
+#endif
+
+    std::vector<char> buffer;
+    while(length > 0) {
+      buffer.resize(static_cast<size_t>(std::min<offset_t>(length, 1024 * 1024)));
+      const ssize_t count = pread(inFd, buffer.data(), buffer.size(), from);
+      if(count <= 0 || pwrite(outFd, buffer.data(), count, to) != count)
+        return false;
+      from += count;
+      to += count;
+      length -= count;
+    }
+    return true;
+  }
+
+  using PathString = std::string;
+
+  // Creates an empty file next to \a path with the same permissions and
+  // owner as \a original and returns it opened for reading and writing, its
+  // name is stored in \a tempPath.  Fails for symbolic links and files with
+  // several hard links, which would be broken by renaming the new file over
+  // the original.
+
+  FileHandle createTempFile(const PathString &path, FileHandle original, PathString &tempPath)
+  {
+    struct stat linkStatus;
+    struct stat status;
+    if(path.empty() || lstat(path.c_str(), &linkStatus) != 0 ||
+       !S_ISREG(linkStatus.st_mode) || linkStatus.st_nlink > 1 ||
+       fflush(original) != 0 || fstat(fileno(original), &status) != 0) {
+      return InvalidFileHandle;
+    }
+
+    constexpr char suffix[] = ".taglib-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.insert(name.end(), std::begin(suffix), std::end(suffix));
+
+    const int fd = mkstemp(name.data());
+    if(fd < 0)
+      return InvalidFileHandle;
+
+    tempPath = name.data();
+
+    struct stat tempStatus;
+    FileHandle file = InvalidFileHandle;
+    if(fstat(fd, &tempStatus) == 0 &&
+       ((tempStatus.st_uid == status.st_uid && tempStatus.st_gid == status.st_gid) ||
+        fchown(fd, status.st_uid, status.st_gid) == 0) &&
+       fchmod(fd, status.st_mode & 07777) == 0) {
+      file = fdopen(fd, "rb+");
+    }
+
+    if(file == InvalidFileHandle) {
+      close(fd);
+      unlink(tempPath.c_str());
+    }
+    return file;
+  }
+
+  // Writes the content described by \a pieces to the empty file \a target in
+  // one sequential pass.  The ranges of the original file are copied by the
+  // kernel if possible.
+
+  bool writePieces(FileHandle original, FileHandle target, const std::vector<Piece> &pieces)
+  {
+    const int inFd = fileno(original);
+    const int outFd = fileno(target);
+    bool useKernelCopy = true;
+
+    offset_t position = 0;
+    for(const auto &piece : pieces) {
+      if(piece.source >= 0) {
+        if(!copyRange(inFd, piece.source, outFd, position, piece.length, useKernelCopy))
+          return false;
+      }
+      else {
+        for(offset_t done = 0; done < piece.length;) {
+          const ssize_t count = pwrite(outFd, piece.data.data() + done,
+                                       static_cast<size_t>(piece.length - done), position + done);
+          if(count <= 0)
+            return false;
+          done += count;
+        }
+      }
+      position += piece.length;
+    }
+    return true;
+  }
+
+  // Flushes the directory entries of the directory containing \a path, so
+  // that a file renamed into it survives a crash.
+
+  bool syncDirectory(const PathString &path)
+  {
+    const auto slash = path.rfind('/');
+    const PathString directory = slash == PathString::npos ? PathString(".")
+                               : slash == 0 ? PathString("/") : path.substr(0, slash);
+
+    const int fd = open(directory.c_str(), O_RDONLY);
+    if(fd < 0)
+      return false;
+
+    const bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+  }
+
+  void removeFile(const PathString &path)
+  {
+    unlink(path.c_str());
+  }
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_FALLOCATE_RANGE)
+# define TAGLIB_HAVE_KERNEL_MOVE
+
+  // Moves the data from \a position to the end of the file \a delta bytes
+  // towards the end, leaving the gap with undefined content.  Returns
+  // \c false if not all of the data could be moved without shifting it
+  // through user space buffers.  The data between \a position and
+  // \a unmovedEnd then still has to be moved, all data behind it has
+  // already been moved.
+
+  bool insertRange(FileHandle file, offset_t position, offset_t delta,
+                   offset_t fileLength, [[maybe_unused]] unsigned int minimumChunk,
+                   offset_t &unmovedEnd)
+  {
+    unmovedEnd = fileLength;
+
+    if(position >= fileLength || delta <= 0 || fflush(file) != 0)
+      return false;
+
+    const int fd = fileno(file);
+
+#ifdef HAVE_FALLOCATE_RANGE
+    // Only works if position and delta are multiples of the file system block
+    // size and the file system supports it, which it checks itself.
+    if(fallocate(fd, FALLOC_FL_INSERT_RANGE, position, delta) == 0)
+      return true;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+    // The tail is moved backwards in chunks not larger than delta, so that the
+    // source and target of each copy do not overlap.  This only pays off if
+    // the chunks are not too small.
+
+    if(delta < minimumChunk)
+      return false;
+
+    constexpr offset_t maximumChunk = 64 * 1024 * 1024;
+    const offset_t chunk = std::min(delta, maximumChunk);
+    bool useKernelCopy = true;
+
+    while(unmovedEnd > position) {
+      const offset_t begin = std::max(position, unmovedEnd - chunk);
+      if(!copyRange(fd, begin, fd, begin + delta, unmovedEnd - begin, useKernelCopy)) {
+        debug("FileStream::insert() -- Failed to move data.");
+        return false;
+      }
+      unmovedEnd = begin;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Removes \a length bytes at \a position, moving the rest of the file to
+  // the front and truncating it.  Returns \c false if not all of the data
+  // could be moved without shifting it through user space buffers.  The data
+  // from \a unmovedStart to the end of the file then still has to be moved
+  // \a length bytes to the front, all data in front of it has already been
+  // moved, and the file has not been truncated.
+
+  bool collapseRange(FileHandle file, offset_t position, offset_t length,
+                     offset_t fileLength, [[maybe_unused]] unsigned int minimumChunk,
+                     offset_t &unmovedStart)
+  {
+    unmovedStart = position + length;
+
+    if(length <= 0 || position + length >= fileLength || fflush(file) != 0)
+      return false;
+
+    const int fd = fileno(file);
+
+#ifdef HAVE_FALLOCATE_RANGE
+    if(fallocate(fd, FALLOC_FL_COLLAPSE_RANGE, position, length) == 0)
+      return true;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+    if(length < minimumChunk)
+      return false;
+
+    constexpr offset_t maximumChunk = 64 * 1024 * 1024;
+    const offset_t chunk = std::min(length, maximumChunk);
+    bool useKernelCopy = true;
+
+    while(unmovedStart < fileLength) {
+      const offset_t end = std::min(fileLength, unmovedStart + chunk);
+      if(!copyRange(fd, unmovedStart, fd, unmovedStart - length, end - unmovedStart, useKernelCopy)) {
+        debug("FileStream::removeBlock() -- Failed to move data.");
+        return false;
+      }
+      unmovedStart = end;
+    }
+
+    if(ftruncate(fd, fileLength - length) != 0)
+      debug("FileStream::removeBlock() -- Couldn't truncate the file.");
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#endif  // HAVE_COPY_FILE_RANGE || HAVE_FALLOCATE_RANGE
+
 #endif  // _WIN32
+
+  // Returns the size of the buffer used to move \a bytesToMove bytes in
+  // insert() and removeBlock().  It grows with the amount of data, so that
+  // shifting a large file needs a bounded number of reads and writes, but is
+  // never smaller than \a minimumSize.
+
+  size_t moveBufferSize(unsigned int minimumSize, offset_t bytesToMove)
+  {
+    constexpr offset_t maximumSize = 4 * 1024 * 1024;
+    return static_cast<size_t>(std::clamp<offset_t>(
+      bytesToMove / 16, minimumSize, std::max<offset_t>(minimumSize, maximumSize)));
+  }
 }  // namespace
 
 class FileStream::FileStreamPrivate
@@ -148,9 +533,118 @@ public:
   {
   }
 
+  // Drops the read buffer used by readView(), must be called whenever the
+  // file is modified.
+
+  void invalidateReadBuffer()
+  {
+    readBuffer = ByteVector();
+    readBufferOffset = -1;
+  }
+
+  bool isAtomicWrite() const
+  {
+    return tempFile != InvalidFileHandle;
+  }
+
+  offset_t piecesLength() const
+  {
+    offset_t total = 0;
+    for(const auto &piece : pieces)
+      total += piece.length;
+    return total;
+  }
+
+  // Makes sure that a piece starts at \a offset and returns its index, or
+  // the number of pieces if \a offset is the end of the content.
+
+  size_t splitPieces(offset_t offset)
+  {
+    offset_t start = 0;
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      if(offset == start)
+        return i;
+      if(offset < start + pieces[i].length) {
+        const offset_t head = offset - start;
+        Piece tail { -1, pieces[i].length - head, ByteVector() };
+        if(pieces[i].source >= 0) {
+          tail.source = pieces[i].source + head;
+        }
+        else {
+          tail.data = pieces[i].data.mid(static_cast<unsigned int>(head));
+          pieces[i].data = pieces[i].data.mid(0, static_cast<unsigned int>(head));
+        }
+        pieces[i].length = head;
+        pieces.insert(pieces.begin() + i + 1, std::move(tail));
+        return i + 1;
+      }
+      start += pieces[i].length;
+    }
+    return pieces.size();
+  }
+
+  // Replaces \a length bytes of the content at \a offset with \a data,
+  // \a offset may be behind the end, the gap is then filled with zeros.
+
+  void replacePieces(offset_t offset, offset_t length, const ByteVector &data)
+  {
+    if(const offset_t total = piecesLength(); offset > total) {
+      pieces.push_back({ -1, offset - total, ByteVector(static_cast<unsigned int>(offset - total), '\0') });
+      length = 0;
+    }
+    else {
+      length = std::min(length, total - offset);
+    }
+
+    const size_t first = splitPieces(offset);
+    const size_t last = splitPieces(offset + length);
+    pieces.erase(pieces.begin() + first, pieces.begin() + last);
+    if(!data.isEmpty())
+      pieces.insert(pieces.begin() + first, { -1, static_cast<offset_t>(data.size()), data });
+  }
+
+  // Reads up to \a size bytes of the content at \a offset into \a data.
+
+  size_t readPieces(offset_t offset, char *data, size_t size)
+  {
+    size_t count = 0;
+    offset_t start = 0;
+    for(const auto &piece : pieces) {
+      if(count == size)
+        break;
+      if(offset + static_cast<offset_t>(count) < start + piece.length) {
+        const offset_t skip = offset + static_cast<offset_t>(count) - start;
+        const auto part = static_cast<size_t>(std::min<offset_t>(piece.length - skip, size - count));
+        if(piece.source >= 0) {
+          if(!seekFile(file, piece.source + skip, IOStream::Beginning) ||
+             readFile(file, data + count, part) != part)
+            break;
+        }
+        else {
+          std::copy_n(piece.data.data() + skip, part, data + count);
+        }
+        count += part;
+      }
+      start += piece.length;
+    }
+    return count;
+  }
+
   FileHandle file { InvalidFileHandle };
   FileNameHandle name;
   bool readOnly { true };
+
+  // During an atomic write, file is the original file, which is only read.
+  // The new content is described by pieces and written to tempFile by
+  // commitAtomicWrite().
+
+  FileHandle tempFile { InvalidFileHandle };
+  PathString tempName;
+  std::vector<Piece> pieces;
+  offset_t position { 0 };
+
+  ByteVector readBuffer;
+  offset_t readBufferOffset { -1 };
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -197,6 +691,8 @@ FileStream::FileStream(int fileDescriptor, bool openReadOnly) :
 
 FileStream::~FileStream()
 {
+  rollbackAtomicWrite();
+
   if(isOpen())
     closeFile(d->file);
 }
@@ -216,6 +712,15 @@ ByteVector FileStream::readBlock(size_t length)
   if(length == 0)
     return ByteVector();
 
+  if(d->isAtomicWrite()) {
+    length = static_cast<size_t>(std::clamp<offset_t>(
+      d->piecesLength() - d->position, 0, static_cast<offset_t>(length)));
+    ByteVector buffer(static_cast<unsigned int>(length));
+    buffer.resize(static_cast<unsigned int>(d->readPieces(d->position, buffer.data(), length)));
+    d->position += buffer.size();
+    return buffer;
+  }
+
   if(length > bufferSize()) {
     if(const auto streamLength = static_cast<size_t>(FileStream::length());
        length > streamLength) {
@@ -231,6 +736,32 @@ ByteVector FileStream::readBlock(size_t length)
   return buffer;
 }
 
+ByteVector FileStream::readView(size_t length)
+{
+  if(!isOpen()) {
+    debug("FileStream::readView() -- invalid file.");
+    return ByteVector();
+  }
+
+  if(length == 0 || length > bufferSize() || d->isAtomicWrite())
+    return readBlock(length);
+
+  // Serve the request from the read buffer if it is completely contained in
+  // it, otherwise refill the buffer starting at the current position.
+
+  const offset_t position = tell();
+  if(d->readBufferOffset < 0 || position < d->readBufferOffset ||
+     position + static_cast<offset_t>(length) > d->readBufferOffset + d->readBuffer.size()) {
+    d->readBuffer = readBlock(bufferSize());
+    d->readBufferOffset = position;
+  }
+
+  ByteVector v = d->readBuffer.mid(static_cast<unsigned int>(position - d->readBufferOffset),
+                                   static_cast<unsigned int>(length));
+  seek(position + v.size());
+  return v;
+}
+
 void FileStream::writeBlock(const ByteVector &data)
 {
   if(!isOpen()) {
@@ -243,6 +774,14 @@ void FileStream::writeBlock(const ByteVector &data)
     return;
   }
 
+  d->invalidateReadBuffer();
+
+  if(d->isAtomicWrite()) {
+    d->replacePieces(d->position, data.size(), data);
+    d->position += data.size();
+    return;
+  }
+
   writeFile(d->file, data);
 }
 
@@ -258,6 +797,12 @@ void FileStream::insert(const ByteVector &data, offset_t start, size_t replace)
     return;
   }
 
+  if(d->isAtomicWrite()) {
+    d->replacePieces(start, replace, data);
+    d->position = start + data.size();
+    return;
+  }
+
   if(data.size() == replace) {
     seek(start);
     writeBlock(data);
@@ -270,6 +815,51 @@ void FileStream::insert(const ByteVector &data, offset_t start, size_t replace)
     return;
   }
 
+#ifdef TAGLIB_HAVE_KERNEL_MOVE
+
+  // Let the kernel move the rest of the file if possible, then only the new
+  // data has to be written.
+
+  d->invalidateReadBuffer();
+
+  const offset_t fileLength = length();
+  const auto position = static_cast<offset_t>(start + replace);
+  const auto delta = static_cast<offset_t>(data.size() - replace);
+  offset_t unmovedEnd = fileLength;
+  if(insertRange(d->file, position, delta, fileLength, ioBufferSize(), unmovedEnd)) {
+    seek(start);
+    writeBlock(data);
+    return;
+  }
+
+  if(unmovedEnd < fileLength) {
+
+    // The kernel stopped part-way through, the rest of the data is moved
+    // backwards in user space before the new data is written.
+
+    const auto bufferLength = static_cast<offset_t>(
+      moveBufferSize(ioBufferSize(), unmovedEnd - position));
+
+    while(unmovedEnd > position) {
+      const offset_t begin = std::max(position, unmovedEnd - bufferLength);
+      seek(begin);
+      const ByteVector buffer = readBlock(static_cast<size_t>(unmovedEnd - begin));
+      if(static_cast<offset_t>(buffer.size()) != unmovedEnd - begin) {
+        debug("FileStream::insert() -- Failed to move data.");
+        return;
+      }
+      seek(begin + delta);
+      writeBlock(buffer);
+      unmovedEnd = begin;
+    }
+
+    seek(start);
+    writeBlock(data);
+    return;
+  }
+
+#endif
+
   // Woohoo!  Faster (about 20%) than id3lib at last.  I had to get hardcore
   // and avoid TagLib's high level API for rendering just copying parts of
   // the file that don't contain tag data.
@@ -278,9 +868,10 @@ void FileStream::insert(const ByteVector &data, offset_t start, size_t replace)
 
   // First, make sure that we're working with a buffer that is longer than
   // the *difference* in the tag sizes.  We want to avoid overwriting parts
-  // that aren't yet in memory, so this is necessary.
+  // that aren't yet in memory, so this is necessary.  The buffer also grows
+  // with the amount of data which has to be moved.
 
-  size_t bufferLength = bufferSize();
+  size_t bufferLength = moveBufferSize(ioBufferSize(), length() - (start + replace));
 
   while(data.size() - replace > bufferLength)
     bufferLength += bufferSize();
@@ -321,9 +912,12 @@ void FileStream::insert(const ByteVector &data, offset_t start, size_t replace)
 
     writePosition += buffer.size();
 
-    // Make the current buffer the data that we read in the beginning.
+    // Make the current buffer the data that we read in the beginning.  The
+    // buffers are swapped rather than assigned, so that the next read does
+    // not have to detach a shared copy.
 
-    buffer = aboutToOverwrite;
+    buffer.swap(aboutToOverwrite);
+    aboutToOverwrite.resize(static_cast<unsigned int>(bufferLength));
   }
 }
 
@@ -334,10 +928,35 @@ void FileStream::removeBlock(offset_t start, size_t length)
     return;
   }
 
-  unsigned int bufferLength = bufferSize();
+  d->invalidateReadBuffer();
+
+  if(d->isAtomicWrite()) {
+    d->replacePieces(start, length, ByteVector());
+    d->position = start;
+    return;
+  }
+
+  // The data from readPosition to the end of the file has to be moved to
+  // writePosition.
 
   offset_t readPosition = start + length;
-  offset_t writePosition = start;
+
+#ifdef TAGLIB_HAVE_KERNEL_MOVE
+
+  // If the kernel stops part-way through, the rest of the data is moved in
+  // user space.
+
+  if(collapseRange(d->file, start, length, FileStream::length(), ioBufferSize(), readPosition)) {
+    seek(start);
+    return;
+  }
+
+#endif
+
+  offset_t writePosition = readPosition - length;
+
+  const auto bufferLength = static_cast<unsigned int>(
+    moveBufferSize(ioBufferSize(), FileStream::length() - readPosition));
 
   ByteVector buffer(bufferLength);
 
@@ -381,39 +1000,30 @@ void FileStream::seek(offset_t offset, Position p)
     return;
   }
 
-#ifdef _WIN32
-
   if(p != Beginning && p != Current && p != End) {
     debug("FileStream::seek() -- Invalid Position value.");
     return;
   }
 
-  LARGE_INTEGER liOffset;
-  liOffset.QuadPart = offset;
+  if(d->isAtomicWrite()) {
+    if(p == Current)
+      offset += d->position;
+    else if(p == End)
+      offset += d->piecesLength();
+    if(offset >= 0)
+      d->position = offset;
+    return;
+  }
+
+#ifdef _WIN32
 
-  if(!SetFilePointerEx(d->file, liOffset, nullptr, static_cast<DWORD>(p))) {
+  if(!seekFile(d->file, offset, p)) {
     debug("FileStream::seek() -- Failed to set the file pointer.");
   }
 
 #else
 
-  int whence;
-  switch(p) {
-  case Beginning:
-    whence = SEEK_SET;
-    break;
-  case Current:
-    whence = SEEK_CUR;
-    break;
-  case End:
-    whence = SEEK_END;
-    break;
-  default:
-    debug("FileStream::seek() -- Invalid Position value.");
-    return;
-  }
-
-  fseek(d->file, offset, whence);
+  seekFile(d->file, offset, p);
 
 #endif
 }
@@ -433,6 +1043,9 @@ void FileStream::clear()
 
 offset_t FileStream::tell() const
 {
+  if(d->isAtomicWrite())
+    return d->position;
+
 #ifdef _WIN32
 
   const LARGE_INTEGER zero = {};
@@ -459,6 +1072,9 @@ offset_t FileStream::length()
     return 0;
   }
 
+  if(d->isAtomicWrite())
+    return d->piecesLength();
+
 #ifdef _WIN32
 
   LARGE_INTEGER fileSize;
@@ -484,12 +1100,145 @@ offset_t FileStream::length()
 #endif
 }
 
+bool FileStream::beginAtomicWrite()
+{
+  if(!isOpen()) {
+    debug("FileStream::beginAtomicWrite() -- invalid file.");
+    return false;
+  }
+
+  if(readOnly()) {
+    debug("FileStream::beginAtomicWrite() -- read only file.");
+    return false;
+  }
+
+  if(d->isAtomicWrite())
+    return true;
+
+  const offset_t position = tell();
+  const offset_t fileLength = length();
+
+  const FileHandle temp = createTempFile(d->name, d->file, d->tempName);
+  if(temp == InvalidFileHandle) {
+    debug("FileStream::beginAtomicWrite() -- Could not create a temporary file.");
+    d->tempName.clear();
+    return false;
+  }
+
+  d->invalidateReadBuffer();
+  d->tempFile = temp;
+  d->pieces.clear();
+  if(fileLength > 0)
+    d->pieces.push_back({ 0, fileLength, ByteVector() });
+  d->position = position;
+  setAtomicWriteActive(true);
+
+  return true;
+}
+
+bool FileStream::commitAtomicWrite()
+{
+  if(!d->isAtomicWrite()) {
+    debug("FileStream::commitAtomicWrite() -- no atomic write in progress.");
+    return false;
+  }
+
+  d->invalidateReadBuffer();
+
+  const offset_t position = d->position;
+  const bool written = writePieces(d->file, d->tempFile, d->pieces);
+
+#ifdef _WIN32
+
+  // Windows does not allow to replace a file which is still open, so both
+  // files are closed and the new one is opened again afterwards.
+
+  const bool flushed = written && FlushFileBuffers(d->tempFile) != 0;
+  closeFile(d->tempFile);
+  closeFile(d->file);
+
+  const bool replaced = flushed &&
+    MoveFileExW(d->tempName.c_str(), d->name.wstr().c_str(),
+                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+  if(!replaced)
+    removeFile(d->tempName);
+
+  d->file = openFile(d->name, false);
+  if(d->file == InvalidFileHandle)
+    debug("FileStream::commitAtomicWrite() -- Could not reopen the file.");
+
+#else
+
+  // The new file becomes the file itself by renaming it.
+
+  const bool replaced = written && fsync(fileno(d->tempFile)) == 0 &&
+                        rename(d->tempName.c_str(), d->name.c_str()) == 0;
+  if(replaced) {
+    closeFile(d->file);
+    d->file = d->tempFile;
+  }
+  else {
+    closeFile(d->tempFile);
+    removeFile(d->tempName);
+  }
+
+#endif
+
+  if(replaced && !syncDirectory(d->tempName))
+    debug("FileStream::commitAtomicWrite() -- Could not flush the directory.");
+
+  d->tempFile = InvalidFileHandle;
+  d->tempName.clear();
+  d->pieces.clear();
+  setAtomicWriteActive(false);
+
+  if(isOpen())
+    seek(position);
+
+  if(!replaced)
+    debug("FileStream::commitAtomicWrite() -- Could not replace the file.");
+
+  return replaced;
+}
+
+void FileStream::rollbackAtomicWrite()
+{
+  if(!d->isAtomicWrite())
+    return;
+
+  d->invalidateReadBuffer();
+
+  const offset_t position = d->position;
+
+  closeFile(d->tempFile);
+  removeFile(d->tempName);
+
+  d->tempFile = InvalidFileHandle;
+  d->tempName.clear();
+  d->pieces.clear();
+  setAtomicWriteActive(false);
+
+  seek(position);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // protected members
 ////////////////////////////////////////////////////////////////////////////////
 
 void FileStream::truncate(offset_t length)
 {
+  d->invalidateReadBuffer();
+
+  if(d->isAtomicWrite()) {
+    // Extending the content fills the gap with zeros.
+
+    if(const offset_t total = d->piecesLength(); length < total)
+      d->replacePieces(length, total - length, ByteVector());
+    else if(length > total)
+      d->replacePieces(length, 0, ByteVector());
+    return;
+  }
+
 #ifdef _WIN32
 
   const offset_t currentPos = tell();
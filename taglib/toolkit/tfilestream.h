@@ -71,6 +71,14 @@ namespace TagLib {
      */
     ByteVector readBlock(size_t length) override;
 
+    /*!
+     * Reads a block of size \a length at the current get pointer.  Small
+     * blocks are served from an internal read buffer without copying.
+     *
+     * \see IOStream::readView()
+     */
+    ByteVector readView(size_t length) override;
+
     /*!
      * Attempts to write the block \a data at the current get pointer.  If the
      * file is currently only opened read only -- i.e. readOnly() returns \c true --
@@ -139,6 +147,39 @@ namespace TagLib {
      */
     void truncate(offset_t length) override;
 
+    /*!
+     * Creates an empty temporary file next to the file, named after it with a
+     * ".taglib-" suffix, and only records all further modifications in
+     * memory.  Reads return the modified content, taking the unmodified parts
+     * from the original file.  The original file is left untouched until
+     * commitAtomicWrite() writes the new content to the temporary file and
+     * renames it over the original, so other readers never see a partially
+     * written file and a crash can not corrupt it.
+     *
+     * Returns \c false if the file is read only, was opened from a file
+     * descriptor, is a symbolic link or has several hard links, or if the
+     * temporary file can not be created with the same permissions and owner.
+     *
+     * \note If the stream is destroyed before commitAtomicWrite() is called,
+     * the temporary file is removed and the modifications are lost.
+     */
+    bool beginAtomicWrite() override;
+
+    /*!
+     * Writes the content recorded since beginAtomicWrite() to the temporary
+     * file in one sequential pass, flushes it to disk and renames it over the
+     * original file, the stream then continues to operate on the new file.
+     * Returns \c false if the original file could not be replaced, in which
+     * case the temporary file is removed and the original file is kept.
+     */
+    bool commitAtomicWrite() override;
+
+    /*!
+     * Removes the temporary file created by beginAtomicWrite() and discards
+     * the recorded modifications.
+     */
+    void rollbackAtomicWrite() override;
+
   protected:
 
     /*!
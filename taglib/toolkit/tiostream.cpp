@@ -25,6 +25,8 @@
 
 #include "tiostream.h"
 
+#include <algorithm>
+
 #ifdef _WIN32
 # include <windows.h>
 # include "tstring.h"
@@ -80,16 +82,109 @@ String FileName::toString() const
 
 class IOStream::IOStreamPrivate
 {
+public:
+  unsigned int ioBufferSize { 64 * 1024 };
+  offset_t maxPayloadSize { 0 };
+  offset_t readBudget { 0 };
+  unsigned int arenaBlockSize { 0 };
+  bool lazyFrameParsing { false };
+  bool atomicWriteActive { false };
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 // public members
 ////////////////////////////////////////////////////////////////////////////////
 
-IOStream::IOStream() = default;
+IOStream::IOStream() :
+  d(std::make_unique<IOStreamPrivate>())
+{
+}
 
 IOStream::~IOStream() = default;
 
+ByteVector IOStream::readView(size_t length)
+{
+  return readBlock(length);
+}
+
 void IOStream::clear()
 {
 }
+
+bool IOStream::beginAtomicWrite()
+{
+  return false;
+}
+
+bool IOStream::commitAtomicWrite()
+{
+  return false;
+}
+
+void IOStream::rollbackAtomicWrite()
+{
+}
+
+bool IOStream::isAtomicWriteActive() const
+{
+  return d->atomicWriteActive;
+}
+
+unsigned int IOStream::ioBufferSize() const
+{
+  return d->ioBufferSize;
+}
+
+void IOStream::setIOBufferSize(unsigned int size)
+{
+  d->ioBufferSize = std::max(size, 1024U);
+}
+
+offset_t IOStream::maxPayloadSize() const
+{
+  return d->maxPayloadSize;
+}
+
+void IOStream::setMaxPayloadSize(offset_t size)
+{
+  d->maxPayloadSize = std::max<offset_t>(size, 0);
+}
+
+offset_t IOStream::readBudget() const
+{
+  return d->readBudget;
+}
+
+void IOStream::setReadBudget(offset_t budget)
+{
+  d->readBudget = std::max<offset_t>(budget, 0);
+}
+
+unsigned int IOStream::arenaBlockSize() const
+{
+  return d->arenaBlockSize;
+}
+
+void IOStream::setArenaBlockSize(unsigned int size)
+{
+  d->arenaBlockSize = size > 0 ? std::max(size, 4096U) : 0;
+}
+
+bool IOStream::lazyFrameParsing() const
+{
+  return d->lazyFrameParsing;
+}
+
+void IOStream::setLazyFrameParsing(bool lazy)
+{
+  d->lazyFrameParsing = lazy;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// protected members
+////////////////////////////////////////////////////////////////////////////////
+
+void IOStream::setAtomicWriteActive(bool active)
+{
+  d->atomicWriteActive = active;
+}
@@ -165,6 +165,179 @@ namespace TagLib {
      */
     virtual void truncate(offset_t length) = 0;
 
+    /*!
+     * Starts writing to a temporary copy of the stream, so that the
+     * modifications done until commitAtomicWrite() become visible all at once
+     * or not at all.  Returns \c false if the stream does not support this,
+     * the default implementation always does.
+     *
+     * \see commitAtomicWrite()
+     * \see rollbackAtomicWrite()
+     */
+    virtual bool beginAtomicWrite();
+
+    /*!
+     * Replaces the original data with the modified copy started by
+     * beginAtomicWrite().  Returns \c true on success, otherwise the original
+     * data is kept.
+     */
+    virtual bool commitAtomicWrite();
+
+    /*!
+     * Discards the modifications done since beginAtomicWrite().
+     */
+    virtual void rollbackAtomicWrite();
+
+    /*!
+     * Returns \c true between beginAtomicWrite() and commitAtomicWrite() or
+     * rollbackAtomicWrite().  The modifications are then only recorded until
+     * they are committed, so that insert() and removeBlock() are cheap.
+     *
+     * \see beginAtomicWrite()
+     */
+    bool isAtomicWriteActive() const;
+
+    /*!
+     * Reads a block of size \a length at the current get pointer like
+     * readBlock(), but the returned vector may share its data with a buffer
+     * held by the stream instead of being a fresh copy.  This is meant for
+     * parsing small headers, where it avoids an allocation and a copy for
+     * each read.
+     *
+     * The returned vector is implicitly shared, so it stays valid and
+     * unchanged even if the stream is modified or destroyed later.
+     *
+     * The default implementation calls readBlock().
+     */
+    virtual ByteVector readView(size_t length);
+
+    /*!
+     * Returns the maximum size of the buffers used when large parts of the
+     * stream are scanned or moved, e.g. by File::find() or insert().  Scans
+     * start with small reads and grow them up to this size.  The default is
+     * 64 KiB.
+     *
+     * \see setIOBufferSize()
+     */
+    unsigned int ioBufferSize() const;
+
+    /*!
+     * Sets the maximum size of the buffers used when large parts of the
+     * stream are scanned or moved to \a size bytes.  Larger values reduce the
+     * number of system calls on fast or remote file systems, smaller values
+     * reduce the memory used.  Values below 1024 bytes are raised to 1024.
+     *
+     * \see ioBufferSize()
+     */
+    void setIOBufferSize(unsigned int size);
+
+    /*!
+     * Returns the size above which binary payloads such as embedded pictures
+     * are not read while the tags are parsed.  The default is 0, meaning that
+     * all payloads are read.
+     *
+     * \see setMaxPayloadSize()
+     * \see File::deferPayload()
+     */
+    offset_t maxPayloadSize() const;
+
+    /*!
+     * Sets the size above which binary payloads such as embedded pictures are
+     * not read while the tags are parsed to \a size bytes, 0 disables the
+     * limit.  The objects holding skipped payloads keep a DeferredData
+     * instead, which reads the payload when it is requested or before the
+     * file is modified, see e.g. ID3v2::AttachedPictureFrame::isDataDeferred().
+     *
+     * This must be set before the File is created to have an effect.
+     *
+     * \see maxPayloadSize()
+     * \see setReadBudget()
+     */
+    void setMaxPayloadSize(offset_t size);
+
+    /*!
+     * Returns the number of bytes which a File may read before all further
+     * binary payloads are skipped.  The default is 0, meaning no limit.
+     *
+     * \see setReadBudget()
+     * \see File::deferPayload()
+     */
+    offset_t readBudget() const;
+
+    /*!
+     * Sets the number of bytes which a File may read before all further
+     * binary payloads are skipped to \a budget, 0 disables the budget.  A
+     * payload is skipped if reading it would exceed the budget, the tags and
+     * audio properties are always read completely.  Together with
+     * setMaxPayloadSize() this keeps reading the metadata of files with large
+     * embedded pictures cheap, e.g. when indexing a music library.
+     *
+     * This must be set before the File is created to have an effect.
+     *
+     * \see readBudget()
+     * \see setMaxPayloadSize()
+     */
+    void setReadBudget(offset_t budget);
+
+    /*!
+     * Returns the size of the blocks of the per-file arena used while the
+     * tags are parsed.  The default is 0, meaning that no arena is used.
+     *
+     * \see setArenaBlockSize()
+     */
+    unsigned int arenaBlockSize() const;
+
+    /*!
+     * Sets the size of the blocks of the per-file arena to \a size bytes, 0
+     * disables the arena.  With an arena the many small objects created while
+     * the tags are parsed, e.g. frames, strings and byte vectors, are taken
+     * from a few large blocks instead of being allocated one by one, which
+     * is considerably faster when many files are scanned.  The blocks are
+     * freed together with the File.  Values which are still referenced after
+     * the File is destroyed keep the blocks alive until they are released.
+     * Values below 4096 bytes are raised to 4096.
+     *
+     * This must be set before the File is created to have an effect.
+     *
+     * \see arenaBlockSize()
+     */
+    void setArenaBlockSize(unsigned int size);
+
+    /*!
+     * Returns \c true if the frames of tags are only parsed when they are
+     * accessed.  The default is \c false.
+     *
+     * \see setLazyFrameParsing()
+     */
+    bool lazyFrameParsing() const;
+
+    /*!
+     * If \a lazy is \c true, tags which consist of many frames only record
+     * the position and ID of each frame while they are read.  The frames are
+     * parsed when they are accessed for the first time, e.g. by
+     * ID3v2::Tag::frameList() or title(), so that reading a few values from
+     * a large tag does not decode all of its frames.  Functions which need
+     * all frames, e.g. ID3v2::Tag::frameListMap(), properties() or
+     * rendering the tag, parse the remaining frames.  This is currently
+     * supported for ID3v2.4 tags read with the default
+     * ID3v2::FrameFactory.
+     *
+     * This must be set before the File is created to have an effect.
+     *
+     * \see lazyFrameParsing()
+     */
+    void setLazyFrameParsing(bool lazy);
+
+  protected:
+    /*!
+     * Sets whether an atomic write is in progress to \a active.  Streams
+     * implementing beginAtomicWrite() call this when the write starts and
+     * ends.
+     *
+     * \see isAtomicWriteActive()
+     */
+    void setAtomicWriteActive(bool active);
+
   private:
     class IOStreamPrivate;
     TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
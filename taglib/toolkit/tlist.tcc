@@ -175,6 +175,11 @@ List<T> &List<T>::append(const T &item)
 template <class T>
 List<T> &List<T>::append(const List<T> &l)
 {
+  // The items may not be inserted from the list they are inserted into.
+
+  if(&l == this)
+    return append(List<T>(l));
+
   detach();
   d->list.insert(d->list.end(), l.begin(), l.end());
   return *this;
@@ -191,6 +196,9 @@ List<T> &List<T>::prepend(const T &item)
 template <class T>
 List<T> &List<T>::prepend(const List<T> &l)
 {
+  if(&l == this)
+    return prepend(List<T>(l));
+
   detach();
   d->list.insert(d->list.begin(), l.begin(), l.end());
   return *this;
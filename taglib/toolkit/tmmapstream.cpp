@@ -0,0 +1,314 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "tmmapstream.h"
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tstring.h"
+#include "tdebug.h"
+
+using namespace TagLib;
+
+namespace
+{
+#ifdef _WIN32
+
+  using FileNameHandle = FileName;
+
+  // Maps the whole file read only, returns nullptr and sets size to zero on
+  // failure.  An empty file is opened but not mapped.
+
+  const char *mapFile(const FileName &path, offset_t &size, bool &opened)
+  {
+    size = 0;
+    opened = false;
+
+#if defined (PLATFORM_WINRT)
+    HANDLE file = CreateFile2(path.wstr().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              OPEN_EXISTING, nullptr);
+#else
+    HANDLE file = CreateFileW(path.wstr().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, 0, nullptr);
+#endif
+    if(file == INVALID_HANDLE_VALUE)
+      return nullptr;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) ||
+       static_cast<unsigned long long>(fileSize.QuadPart) > SIZE_MAX) {
+      CloseHandle(file);
+      return nullptr;
+    }
+
+    if(fileSize.QuadPart == 0) {
+      CloseHandle(file);
+      opened = true;
+      return nullptr;
+    }
+
+#if defined (PLATFORM_WINRT)
+    HANDLE mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+#else
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+#endif
+    CloseHandle(file);
+    if(!mapping)
+      return nullptr;
+
+#if defined (PLATFORM_WINRT)
+    void *data = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+#else
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#endif
+    CloseHandle(mapping);
+    if(!data)
+      return nullptr;
+
+    size = fileSize.QuadPart;
+    opened = true;
+    return static_cast<const char *>(data);
+  }
+
+  void unmapFile(const char *data, offset_t)
+  {
+    UnmapViewOfFile(data);
+  }
+
+#else   // _WIN32
+
+  struct FileNameHandle : public std::string
+  {
+    FileNameHandle(FileName name) : std::string(name) {}
+    operator FileName () const { return c_str(); }
+  };
+
+  // Maps the whole file read only, returns nullptr and sets size to zero on
+  // failure.  An empty file is opened but not mapped.
+
+  const char *mapFile(const FileName &path, offset_t &size, bool &opened)
+  {
+    size = 0;
+    opened = false;
+
+    const int fd = open(path, O_RDONLY);
+    if(fd < 0)
+      return nullptr;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+       static_cast<unsigned long long>(st.st_size) > SIZE_MAX) {
+      close(fd);
+      return nullptr;
+    }
+
+    if(st.st_size == 0) {
+      close(fd);
+      opened = true;
+      return nullptr;
+    }
+
+    void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps a reference to the file, the descriptor is not needed
+    // anymore.
+
+    close(fd);
+    if(data == MAP_FAILED)
+      return nullptr;
+
+    size = st.st_size;
+    opened = true;
+    return static_cast<const char *>(data);
+  }
+
+  void unmapFile(const char *data, offset_t size)
+  {
+    munmap(const_cast<char *>(data), static_cast<size_t>(size));
+  }
+
+#endif  // _WIN32
+}  // namespace
+
+class MmapStream::MmapStreamPrivate
+{
+public:
+  MmapStreamPrivate(const FileName &fileName) :
+    name(fileName)
+  {
+  }
+
+  FileNameHandle name;
+  const char *data { nullptr };
+  offset_t size { 0 };
+  offset_t position { 0 };
+  bool opened { false };
+  // The data returned by the last readView() which was not within the
+  // previous one.
+  ByteVector window;
+  offset_t windowOffset { -1 };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// public members
+////////////////////////////////////////////////////////////////////////////////
+
+MmapStream::MmapStream(FileName fileName) :
+  d(std::make_unique<MmapStreamPrivate>(fileName))
+{
+  d->data = mapFile(fileName, d->size, d->opened);
+
+  if(!d->opened)
+# ifdef _WIN32
+    debug("Could not map file " + fileName.toString());
+# else
+    debug("Could not map file " + String(static_cast<const char *>(d->name)));
+# endif
+}
+
+MmapStream::~MmapStream()
+{
+  if(d->data)
+    unmapFile(d->data, d->size);
+}
+
+FileName MmapStream::name() const
+{
+  return d->name;
+}
+
+ByteVector MmapStream::readBlock(size_t length)
+{
+  if(!isOpen()) {
+    debug("MmapStream::readBlock() -- invalid file.");
+    return ByteVector();
+  }
+
+  if(length == 0 || d->position < 0 || d->position >= d->size)
+    return ByteVector();
+
+  if(const auto available = static_cast<size_t>(d->size - d->position);
+     length > available) {
+    length = available;
+  }
+
+  ByteVector v(d->data + d->position, static_cast<unsigned int>(length));
+  d->position += v.size();
+  return v;
+}
+
+ByteVector MmapStream::readView(size_t length)
+{
+  if(length == 0 || d->position < 0 || d->position >= d->size)
+    return readBlock(length);
+
+  // A ByteVector always owns its data, so it cannot refer to the mapping.
+  // Only the requested bytes are copied, reads of a part of them share it.
+
+  if(d->windowOffset < 0 || d->position < d->windowOffset ||
+     d->position + static_cast<offset_t>(length) > d->windowOffset + d->window.size()) {
+    const auto windowLength = static_cast<unsigned int>(
+      std::min<offset_t>(length, d->size - d->position));
+    d->window = ByteVector(d->data + d->position, windowLength);
+    d->windowOffset = d->position;
+  }
+
+  ByteVector v = d->window.mid(static_cast<unsigned int>(d->position - d->windowOffset),
+                               static_cast<unsigned int>(length));
+  d->position += v.size();
+  return v;
+}
+
+void MmapStream::writeBlock(const ByteVector &)
+{
+  debug("MmapStream::writeBlock() -- read only file.");
+}
+
+void MmapStream::insert(const ByteVector &, offset_t, size_t)
+{
+  debug("MmapStream::insert() -- read only file.");
+}
+
+void MmapStream::removeBlock(offset_t, size_t)
+{
+  debug("MmapStream::removeBlock() -- read only file.");
+}
+
+bool MmapStream::readOnly() const
+{
+  return true;
+}
+
+bool MmapStream::isOpen() const
+{
+  return d->opened;
+}
+
+void MmapStream::seek(offset_t offset, Position p)
+{
+  if(!isOpen()) {
+    debug("MmapStream::seek() -- invalid file.");
+    return;
+  }
+
+  switch(p) {
+  case Beginning:
+    d->position = offset;
+    break;
+  case Current:
+    d->position += offset;
+    break;
+  case End:
+    d->position = d->size + offset;
+    break;
+  default:
+    debug("MmapStream::seek() -- Invalid Position value.");
+    break;
+  }
+}
+
+void MmapStream::clear()
+{
+}
+
+offset_t MmapStream::tell() const
+{
+  return d->position;
+}
+
+offset_t MmapStream::length()
+{
+  return d->size;
+}
+
+void MmapStream::truncate(offset_t)
+{
+  debug("MmapStream::truncate() -- read only file.");
+}
@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_MMAPSTREAM_H
+#define TAGLIB_MMAPSTREAM_H
+
+#include "tbytevector.h"
+#include "tiostream.h"
+#include "taglib_export.h"
+#include "taglib.h"
+
+namespace TagLib {
+
+  //! Read-only I/O stream with data from a memory mapped file.
+
+  /*!
+   * This maps the whole file into memory and serves readBlock(), seek() and
+   * tell() directly from the mapping, so reading does not involve any system
+   * calls once the file is open.  It is intended for bulk read-only access,
+   * e.g. scanning a music library.
+   *
+   * The stream is always read only, all modifying methods do nothing.  To
+   * save tags, use a FileStream instead.
+   *
+   * \note The file must not be truncated by another process while it is
+   * mapped, as accessing pages beyond the end of the file results in a bus
+   * error on most systems.
+   */
+
+  class TAGLIB_EXPORT MmapStream : public IOStream
+  {
+  public:
+    /*!
+     * Construct a MmapStream object and map the \a fileName.  \a fileName
+     * should be a C-string in the local file system encoding.
+     */
+    MmapStream(FileName fileName);
+
+    /*!
+     * Destroys this MmapStream instance and unmaps the file.
+     */
+    ~MmapStream() override;
+
+    MmapStream(const MmapStream &) = delete;
+    MmapStream &operator=(const MmapStream &) = delete;
+
+    /*!
+     * Returns the file name in the local file system encoding.
+     */
+    FileName name() const override;
+
+    /*!
+     * Reads a block of size \a length at the current get pointer.
+     */
+    ByteVector readBlock(size_t length) override;
+
+    /*!
+     * Reads a block of size \a length at the current get pointer.  The
+     * data is copied out of the mapping like by readBlock(), but a later
+     * read of a part of it, e.g. after seeking back, shares the copy.
+     *
+     * \see IOStream::readView()
+     */
+    ByteVector readView(size_t length) override;
+
+    /*!
+     * Does nothing, the stream is read only.
+     */
+    void writeBlock(const ByteVector &data) override;
+
+    /*!
+     * Does nothing, the stream is read only.
+     */
+    void insert(const ByteVector &data, offset_t start = 0, size_t replace = 0) override;
+
+    /*!
+     * Does nothing, the stream is read only.
+     */
+    void removeBlock(offset_t start = 0, size_t length = 0) override;
+
+    /*!
+     * Returns \c true.
+     */
+    bool readOnly() const override;
+
+    /*!
+     * Returns \c true if the file could be opened and mapped.
+     */
+    bool isOpen() const override;
+
+    /*!
+     * Move the I/O pointer to \a offset in the file from position \a p.  This
+     * defaults to seeking from the beginning of the file.
+     *
+     * \see Position
+     */
+    void seek(offset_t offset, Position p = Beginning) override;
+
+    /*!
+     * Does nothing.
+     */
+    void clear() override;
+
+    /*!
+     * Returns the current offset within the file.
+     */
+    offset_t tell() const override;
+
+    /*!
+     * Returns the length of the file.
+     */
+    offset_t length() override;
+
+    /*!
+     * Does nothing, the stream is read only.
+     */
+    void truncate(offset_t length) override;
+
+  private:
+    class MmapStreamPrivate;
+    TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
+    std::unique_ptr<MmapStreamPrivate> d;
+  };
+
+}  // namespace TagLib
+
+#endif
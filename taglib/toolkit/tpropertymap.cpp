@@ -25,6 +25,7 @@
 
 #include "tpropertymap.h"
 
+#include <algorithm>
 #include <utility>
 
 using namespace TagLib;
@@ -63,20 +64,17 @@ PropertyMap::~PropertyMap() = default;
 
 bool PropertyMap::insert(const String &key, const StringList &values)
 {
-  String realKey = key.upper();
-  auto result = SimplePropertyMap::find(realKey);
-  if(result == end())
-    SimplePropertyMap::insert(realKey, values);
+  const String realKey = key.upper();
+  if(auto it = SimplePropertyMap::find(realKey); it != end())
+    it->second.append(values);
   else
-    SimplePropertyMap::operator[](realKey).append(values);
+    SimplePropertyMap::insert(realKey, values);
   return true;
 }
 
 bool PropertyMap::replace(const String &key, const StringList &values)
 {
-  String realKey = key.upper();
-  SimplePropertyMap::erase(realKey);
-  SimplePropertyMap::insert(realKey, values);
+  SimplePropertyMap::insert(key.upper(), values);
   return true;
 }
 
@@ -98,7 +96,10 @@ bool PropertyMap::contains(const String &key) const
 bool PropertyMap::contains(const PropertyMap &other) const
 {
   return std::all_of(other.begin(), other.end(),
-    [this](const auto &o) { return contains(o.first) && (*this)[o.first] == o.second; });
+    [this](const auto &o) {
+      auto it = find(o.first);
+      return it != end() && it->second == o.second;
+    });
 }
 
 PropertyMap &PropertyMap::erase(const String &key)
@@ -140,17 +141,8 @@ StringList &PropertyMap::operator[](const String &key)
 
 bool PropertyMap::operator==(const PropertyMap &other) const
 {
-  for(const auto &[property, val] : other) {
-    if(auto thisFind = find(property);
-       thisFind == end() || thisFind->second != val)
-      return false;
-  }
-  for(const auto &[property, val] : *this) {
-    if(auto otherFind = other.find(property);
-       otherFind == other.end() || otherFind->second != val)
-      return false;
-  }
-  return d->unsupported == other.d->unsupported;
+  return SimplePropertyMap::operator==(other) &&
+         d->unsupported == other.d->unsupported;
 }
 
 bool PropertyMap::operator!=(const PropertyMap &other) const
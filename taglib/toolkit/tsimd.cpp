@@ -0,0 +1,825 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "tsimd.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+# if defined(__GNUC__) || defined(_MSC_VER)
+#  define TAGLIB_SIMD_X86
+# endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+# define TAGLIB_SIMD_NEON
+#endif
+
+#if defined(TAGLIB_SIMD_X86)
+# include <immintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  define TAGLIB_TARGET(isa)
+# else
+#  define TAGLIB_TARGET(isa) __attribute__((target(isa)))
+# endif
+#elif defined(TAGLIB_SIMD_NEON)
+# ifdef _MSC_VER
+#  include <intrin.h>
+#  include <arm64_neon.h>
+# else
+#  include <arm_neon.h>
+# endif
+#endif
+
+using namespace TagLib;
+
+namespace
+{
+  using FindFunction = const char *(*)(const char *, const char *, const char *, size_t);
+  using FindFrameSyncFunction = const char *(*)(const char *, const char *);
+  using AsciiLengthFunction = size_t (*)(const char *, const char *);
+  using WidenFunction = void (*)(const char *, size_t, wchar_t *);
+  using NarrowAsciiFunction = size_t (*)(const wchar_t *, size_t, char *);
+
+  // The vectorized search compares the first and the last byte of the
+  // pattern at many positions at once, only the candidates where both match
+  // are checked completely.
+
+  inline bool matchesInner(const char *candidate, const char *pattern, size_t patternSize)
+  {
+    return patternSize <= 2 ||
+           memcmp(candidate + 1, pattern + 1, patternSize - 2) == 0;
+  }
+
+  inline bool isFrameSyncAt(const char *p)
+  {
+    const auto b1 = static_cast<unsigned char>(p[0]);
+    const auto b2 = static_cast<unsigned char>(p[1]);
+    return b1 == 0xFF && b2 != 0xFF && (b2 & 0xE0) == 0xE0;
+  }
+
+#if defined(TAGLIB_SIMD_X86)
+
+  inline unsigned int lowestBit(unsigned int mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+  }
+
+  inline unsigned int highestBit(unsigned int mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return index;
+#else
+    return 31 - static_cast<unsigned int>(__builtin_clz(mask));
+#endif
+  }
+
+  bool cpuSupportsSse2()
+  {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+  }
+
+  bool cpuSupportsAvx2()
+  {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+      return false;
+
+    // The operating system has to save the AVX registers.
+
+    __cpuid(info, 1);
+    if((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 ||
+       (_xgetbv(0) & 6) != 6) {
+      return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+  }
+
+  TAGLIB_TARGET("sse2")
+  const char *findSse2(const char *begin, const char *end,
+                       const char *pattern, size_t patternSize)
+  {
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last  = _mm_set1_epi8(pattern[patternSize - 1]);
+
+    const char *p = begin;
+    for(; static_cast<size_t>(end - p) >= patternSize + 15; p += 16) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const __m128i b = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(p + patternSize - 1));
+      auto mask = static_cast<unsigned int>(_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+      while(mask != 0) {
+        const char *candidate = p + lowestBit(mask);
+        if(matchesInner(candidate, pattern, patternSize))
+          return candidate;
+        mask &= mask - 1;
+      }
+    }
+
+    return Simd::findScalar(p, end, pattern, patternSize);
+  }
+
+  TAGLIB_TARGET("sse2")
+  const char *rfindSse2(const char *begin, const char *end,
+                        const char *pattern, size_t patternSize)
+  {
+    const auto size = static_cast<size_t>(end - begin);
+    if(size < patternSize + 15)
+      return Simd::rfindScalar(begin, end, pattern, patternSize);
+
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last  = _mm_set1_epi8(pattern[patternSize - 1]);
+
+    // i is the first of the 16 start positions checked in each step.
+
+    size_t i = size - patternSize - 15;
+    while(true) {
+      const char *p = begin + i;
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const __m128i b = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(p + patternSize - 1));
+      auto mask = static_cast<unsigned int>(_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+      while(mask != 0) {
+        const unsigned int bit = highestBit(mask);
+        if(matchesInner(p + bit, pattern, patternSize))
+          return p + bit;
+        mask &= ~(1U << bit);
+      }
+      if(i < 16)
+        break;
+      i -= 16;
+    }
+
+    return Simd::rfindScalar(begin, begin + i + patternSize - 1, pattern, patternSize);
+  }
+
+  TAGLIB_TARGET("avx2")
+  const char *findAvx2(const char *begin, const char *end,
+                       const char *pattern, size_t patternSize)
+  {
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last  = _mm256_set1_epi8(pattern[patternSize - 1]);
+
+    const char *p = begin;
+    for(; static_cast<size_t>(end - p) >= patternSize + 31; p += 32) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+      const __m256i b = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(p + patternSize - 1));
+      auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+      while(mask != 0) {
+        const char *candidate = p + lowestBit(mask);
+        if(matchesInner(candidate, pattern, patternSize))
+          return candidate;
+        mask &= mask - 1;
+      }
+    }
+
+    // The SSE2 code is not VEX encoded, so the upper halves of the AVX
+    // registers have to be cleared to avoid a costly state transition.
+    // Compilers do not always do it before a tail call.
+
+    _mm256_zeroupper();
+    return findSse2(p, end, pattern, patternSize);
+  }
+
+  TAGLIB_TARGET("avx2")
+  const char *rfindAvx2(const char *begin, const char *end,
+                        const char *pattern, size_t patternSize)
+  {
+    const auto size = static_cast<size_t>(end - begin);
+    if(size < patternSize + 31)
+      return rfindSse2(begin, end, pattern, patternSize);
+
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last  = _mm256_set1_epi8(pattern[patternSize - 1]);
+
+    size_t i = size - patternSize - 31;
+    while(true) {
+      const char *p = begin + i;
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+      const __m256i b = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(p + patternSize - 1));
+      auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+      while(mask != 0) {
+        const unsigned int bit = highestBit(mask);
+        if(matchesInner(p + bit, pattern, patternSize))
+          return p + bit;
+        mask &= ~(1U << bit);
+      }
+      if(i < 32)
+        break;
+      i -= 32;
+    }
+
+    _mm256_zeroupper();
+    return rfindSse2(begin, begin + i + patternSize - 1, pattern, patternSize);
+  }
+
+  // A frame sync is a 0xFF byte followed by a byte matching 111xxxxx which
+  // is not 0xFF.  Each bit of the mask is set if a frame sync starts at the
+  // according byte of the block at p, p[16] has to be readable.
+
+  TAGLIB_TARGET("sse2")
+  inline unsigned int frameSyncMaskSse2(const char *p)
+  {
+    const __m128i ff = _mm_set1_epi8(static_cast<char>(0xFF));
+    const __m128i e0 = _mm_set1_epi8(static_cast<char>(0xE0));
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+    const __m128i syncs = _mm_and_si128(
+      _mm_cmpeq_epi8(a, ff), _mm_cmpeq_epi8(_mm_and_si128(b, e0), e0));
+    return static_cast<unsigned int>(
+      _mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi8(b, ff), syncs)));
+  }
+
+  TAGLIB_TARGET("avx2")
+  inline unsigned int frameSyncMaskAvx2(const char *p)
+  {
+    const __m256i ff = _mm256_set1_epi8(static_cast<char>(0xFF));
+    const __m256i e0 = _mm256_set1_epi8(static_cast<char>(0xE0));
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+    const __m256i syncs = _mm256_and_si256(
+      _mm256_cmpeq_epi8(a, ff), _mm256_cmpeq_epi8(_mm256_and_si256(b, e0), e0));
+    return static_cast<unsigned int>(
+      _mm256_movemask_epi8(_mm256_andnot_si256(_mm256_cmpeq_epi8(b, ff), syncs)));
+  }
+
+  TAGLIB_TARGET("sse2")
+  const char *findFrameSyncSse2(const char *begin, const char *end)
+  {
+    const char *p = begin;
+    for(; end - p >= 17; p += 16) {
+      if(const unsigned int mask = frameSyncMaskSse2(p); mask != 0)
+        return p + lowestBit(mask);
+    }
+    return Simd::findFrameSyncScalar(p, end);
+  }
+
+  TAGLIB_TARGET("sse2")
+  const char *rfindFrameSyncSse2(const char *begin, const char *end)
+  {
+    if(end - begin < 17)
+      return Simd::rfindFrameSyncScalar(begin, end);
+
+    auto i = static_cast<size_t>(end - begin - 17);
+    while(true) {
+      if(const unsigned int mask = frameSyncMaskSse2(begin + i); mask != 0)
+        return begin + i + highestBit(mask);
+      if(i < 16)
+        break;
+      i -= 16;
+    }
+    return Simd::rfindFrameSyncScalar(begin, begin + i + 1);
+  }
+
+  TAGLIB_TARGET("avx2")
+  const char *findFrameSyncAvx2(const char *begin, const char *end)
+  {
+    const char *p = begin;
+    for(; end - p >= 33; p += 32) {
+      if(const unsigned int mask = frameSyncMaskAvx2(p); mask != 0)
+        return p + lowestBit(mask);
+    }
+    _mm256_zeroupper();
+    return findFrameSyncSse2(p, end);
+  }
+
+  TAGLIB_TARGET("avx2")
+  const char *rfindFrameSyncAvx2(const char *begin, const char *end)
+  {
+    if(end - begin < 33)
+      return rfindFrameSyncSse2(begin, end);
+
+    auto i = static_cast<size_t>(end - begin - 33);
+    while(true) {
+      if(const unsigned int mask = frameSyncMaskAvx2(begin + i); mask != 0)
+        return begin + i + highestBit(mask);
+      if(i < 32)
+        break;
+      i -= 32;
+    }
+    _mm256_zeroupper();
+    return rfindFrameSyncSse2(begin, begin + i + 1);
+  }
+
+  // The text kernels handle 16 or 32 characters at once and leave the rest,
+  // and a block containing a non-ASCII character, to the scalar versions.
+
+  TAGLIB_TARGET("sse2")
+  size_t asciiLengthSse2(const char *begin, const char *end)
+  {
+    const char *p = begin;
+    for(; end - p >= 16; p += 16) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      if(const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(a)); mask != 0)
+        return static_cast<size_t>(p - begin) + lowestBit(mask);
+    }
+    return static_cast<size_t>(p - begin) + Simd::asciiLengthScalar(p, end);
+  }
+
+  TAGLIB_TARGET("avx2")
+  size_t asciiLengthAvx2(const char *begin, const char *end)
+  {
+    const char *p = begin;
+    for(; end - p >= 32; p += 32) {
+      const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+      if(const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(a)); mask != 0)
+        return static_cast<size_t>(p - begin) + lowestBit(mask);
+    }
+    _mm256_zeroupper();
+    return static_cast<size_t>(p - begin) + asciiLengthSse2(p, end);
+  }
+
+  TAGLIB_TARGET("sse2")
+  void widenSse2(const char *src, size_t length, wchar_t *dst)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; length - i >= 16; i += 16) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+      const __m128i lo = _mm_unpacklo_epi8(a, zero);
+      const __m128i hi = _mm_unpackhi_epi8(a, zero);
+      auto out = reinterpret_cast<__m128i *>(dst + i);
+      if constexpr(sizeof(wchar_t) == 2) {
+        _mm_storeu_si128(out, lo);
+        _mm_storeu_si128(out + 1, hi);
+      }
+      else {
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+      }
+    }
+    Simd::widenScalar(src + i, length - i, dst + i);
+  }
+
+  TAGLIB_TARGET("avx2")
+  void widenAvx2(const char *src, size_t length, wchar_t *dst)
+  {
+    size_t i = 0;
+    for(; length - i >= 16; i += 16) {
+      auto out = reinterpret_cast<__m256i *>(dst + i);
+      if constexpr(sizeof(wchar_t) == 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_si256(out, _mm256_cvtepu8_epi16(a));
+      }
+      else {
+        const __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i + 8));
+        _mm256_storeu_si256(out, _mm256_cvtepu8_epi32(a));
+        _mm256_storeu_si256(out + 1, _mm256_cvtepu8_epi32(b));
+      }
+    }
+    _mm256_zeroupper();
+    Simd::widenScalar(src + i, length - i, dst + i);
+  }
+
+  // Packing across the lanes of AVX2 registers needs extra permutations, so
+  // this is used for both instruction sets.
+
+  TAGLIB_TARGET("sse2")
+  size_t narrowAsciiSse2(const wchar_t *src, size_t length, char *dst)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for(; length - i >= 16; i += 16) {
+      auto in = reinterpret_cast<const __m128i *>(src + i);
+      __m128i bytes;
+      if constexpr(sizeof(wchar_t) == 2) {
+        const __m128i a = _mm_loadu_si128(in);
+        const __m128i b = _mm_loadu_si128(in + 1);
+        const __m128i high = _mm_and_si128(_mm_or_si128(a, b),
+                                           _mm_set1_epi16(static_cast<short>(0xFF80)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF)
+          break;
+        bytes = _mm_packus_epi16(a, b);
+      }
+      else {
+        const __m128i a = _mm_loadu_si128(in);
+        const __m128i b = _mm_loadu_si128(in + 1);
+        const __m128i c = _mm_loadu_si128(in + 2);
+        const __m128i d = _mm_loadu_si128(in + 3);
+        const __m128i high = _mm_and_si128(
+          _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)),
+          _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF)
+          break;
+        bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), bytes);
+    }
+    return i + Simd::narrowAsciiScalar(src + i, length - i, dst + i);
+  }
+
+#elif defined(TAGLIB_SIMD_NEON)
+
+  // NEON has no movemask instruction, narrowing the comparison result
+  // yields a 64 bit mask with four bits for each byte instead.
+
+  inline uint64_t compareMask(const char *p, size_t patternSize,
+                              uint8x16_t first, uint8x16_t last)
+  {
+    const uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+    const uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(p + patternSize - 1));
+    const uint8x16_t eq = vandq_u8(vceqq_u8(a, first), vceqq_u8(b, last));
+    return vget_lane_u64(vreinterpret_u64_u8(
+      vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+  }
+
+  inline unsigned int lowestByte(uint64_t mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return index / 4;
+#else
+    return static_cast<unsigned int>(__builtin_ctzll(mask)) / 4;
+#endif
+  }
+
+  inline unsigned int highestByte(uint64_t mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, mask);
+    return index / 4;
+#else
+    return (63 - static_cast<unsigned int>(__builtin_clzll(mask))) / 4;
+#endif
+  }
+
+  const char *findNeon(const char *begin, const char *end,
+                       const char *pattern, size_t patternSize)
+  {
+    const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(pattern[0]));
+    const uint8x16_t last  = vdupq_n_u8(static_cast<uint8_t>(pattern[patternSize - 1]));
+
+    const char *p = begin;
+    for(; static_cast<size_t>(end - p) >= patternSize + 15; p += 16) {
+      uint64_t mask = compareMask(p, patternSize, first, last);
+      while(mask != 0) {
+        const unsigned int index = lowestByte(mask);
+        if(matchesInner(p + index, pattern, patternSize))
+          return p + index;
+        mask &= ~(UINT64_C(0xF) << (index * 4));
+      }
+    }
+
+    return Simd::findScalar(p, end, pattern, patternSize);
+  }
+
+  const char *rfindNeon(const char *begin, const char *end,
+                        const char *pattern, size_t patternSize)
+  {
+    const auto size = static_cast<size_t>(end - begin);
+    if(size < patternSize + 15)
+      return Simd::rfindScalar(begin, end, pattern, patternSize);
+
+    const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(pattern[0]));
+    const uint8x16_t last  = vdupq_n_u8(static_cast<uint8_t>(pattern[patternSize - 1]));
+
+    size_t i = size - patternSize - 15;
+    while(true) {
+      const char *p = begin + i;
+      uint64_t mask = compareMask(p, patternSize, first, last);
+      while(mask != 0) {
+        const unsigned int index = highestByte(mask);
+        if(matchesInner(p + index, pattern, patternSize))
+          return p + index;
+        mask &= ~(UINT64_C(0xF) << (index * 4));
+      }
+      if(i < 16)
+        break;
+      i -= 16;
+    }
+
+    return Simd::rfindScalar(begin, begin + i + patternSize - 1, pattern, patternSize);
+  }
+
+  inline uint64_t frameSyncMask(const char *p)
+  {
+    const uint8x16_t ff = vdupq_n_u8(0xFF);
+    const uint8x16_t e0 = vdupq_n_u8(0xE0);
+    const uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+    const uint8x16_t b = vld1q_u8(reinterpret_cast<const uint8_t *>(p + 1));
+    const uint8x16_t syncs = vbicq_u8(
+      vandq_u8(vceqq_u8(a, ff), vceqq_u8(vandq_u8(b, e0), e0)), vceqq_u8(b, ff));
+    return vget_lane_u64(vreinterpret_u64_u8(
+      vshrn_n_u16(vreinterpretq_u16_u8(syncs), 4)), 0);
+  }
+
+  const char *findFrameSyncNeon(const char *begin, const char *end)
+  {
+    const char *p = begin;
+    for(; end - p >= 17; p += 16) {
+      if(const uint64_t mask = frameSyncMask(p); mask != 0)
+        return p + lowestByte(mask);
+    }
+    return Simd::findFrameSyncScalar(p, end);
+  }
+
+  const char *rfindFrameSyncNeon(const char *begin, const char *end)
+  {
+    if(end - begin < 17)
+      return Simd::rfindFrameSyncScalar(begin, end);
+
+    auto i = static_cast<size_t>(end - begin - 17);
+    while(true) {
+      if(const uint64_t mask = frameSyncMask(begin + i); mask != 0)
+        return begin + i + highestByte(mask);
+      if(i < 16)
+        break;
+      i -= 16;
+    }
+    return Simd::rfindFrameSyncScalar(begin, begin + i + 1);
+  }
+
+  // The text kernels handle 16 characters at once and leave the rest, and a
+  // block containing a non-ASCII character, to the scalar versions.
+
+  size_t asciiLengthNeon(const char *begin, const char *end)
+  {
+    const uint8x16_t limit = vdupq_n_u8(0x80);
+    const char *p = begin;
+    for(; end - p >= 16; p += 16) {
+      const uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+      const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(vcgeq_u8(a, limit)), 4)), 0);
+      if(mask != 0)
+        return static_cast<size_t>(p - begin) + lowestByte(mask);
+    }
+    return static_cast<size_t>(p - begin) + Simd::asciiLengthScalar(p, end);
+  }
+
+  void widenNeon(const char *src, size_t length, wchar_t *dst)
+  {
+    size_t i = 0;
+    for(; length - i >= 16; i += 16) {
+      const uint8x16_t a = vld1q_u8(reinterpret_cast<const uint8_t *>(src + i));
+      const uint16x8_t lo = vmovl_u8(vget_low_u8(a));
+      const uint16x8_t hi = vmovl_u8(vget_high_u8(a));
+      if constexpr(sizeof(wchar_t) == 2) {
+        auto out = reinterpret_cast<uint16_t *>(dst + i);
+        vst1q_u16(out, lo);
+        vst1q_u16(out + 8, hi);
+      }
+      else {
+        auto out = reinterpret_cast<uint32_t *>(dst + i);
+        vst1q_u32(out, vmovl_u16(vget_low_u16(lo)));
+        vst1q_u32(out + 4, vmovl_u16(vget_high_u16(lo)));
+        vst1q_u32(out + 8, vmovl_u16(vget_low_u16(hi)));
+        vst1q_u32(out + 12, vmovl_u16(vget_high_u16(hi)));
+      }
+    }
+    Simd::widenScalar(src + i, length - i, dst + i);
+  }
+
+  size_t narrowAsciiNeon(const wchar_t *src, size_t length, char *dst)
+  {
+    size_t i = 0;
+    for(; length - i >= 16; i += 16) {
+      uint8x16_t bytes;
+      if constexpr(sizeof(wchar_t) == 2) {
+        auto in = reinterpret_cast<const uint16_t *>(src + i);
+        const uint16x8_t a = vld1q_u16(in);
+        const uint16x8_t b = vld1q_u16(in + 8);
+        const uint16x8_t high = vcgtq_u16(vorrq_u16(a, b), vdupq_n_u16(0x7F));
+        if(vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(high)), 0) != 0)
+          break;
+        bytes = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+      }
+      else {
+        auto in = reinterpret_cast<const uint32_t *>(src + i);
+        const uint32x4_t a = vld1q_u32(in);
+        const uint32x4_t b = vld1q_u32(in + 4);
+        const uint32x4_t c = vld1q_u32(in + 8);
+        const uint32x4_t d = vld1q_u32(in + 12);
+        const uint32x4_t high = vcgtq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d)),
+                                          vdupq_n_u32(0x7F));
+        if(vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(high)), 0) != 0)
+          break;
+        const uint16x8_t ab = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+        const uint16x8_t cd = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+        bytes = vcombine_u8(vmovn_u16(ab), vmovn_u16(cd));
+      }
+      vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), bytes);
+    }
+    return i + Simd::narrowAsciiScalar(src + i, length - i, dst + i);
+  }
+
+#endif
+
+  struct Kernels
+  {
+    FindFunction find;
+    FindFunction rfind;
+    FindFrameSyncFunction findFrameSync;
+    FindFrameSyncFunction rfindFrameSync;
+    AsciiLengthFunction asciiLength;
+    WidenFunction widen;
+    NarrowAsciiFunction narrowAscii;
+    const char *name;
+  };
+
+  Kernels selectKernels()
+  {
+#if defined(TAGLIB_SIMD_X86)
+    if(cpuSupportsAvx2()) {
+      return {
+        findAvx2, rfindAvx2, findFrameSyncAvx2, rfindFrameSyncAvx2,
+        asciiLengthAvx2, widenAvx2, narrowAsciiSse2, "avx2"
+      };
+    }
+    if(cpuSupportsSse2()) {
+      return {
+        findSse2, rfindSse2, findFrameSyncSse2, rfindFrameSyncSse2,
+        asciiLengthSse2, widenSse2, narrowAsciiSse2, "sse2"
+      };
+    }
+#elif defined(TAGLIB_SIMD_NEON)
+    return {
+      findNeon, rfindNeon, findFrameSyncNeon, rfindFrameSyncNeon,
+      asciiLengthNeon, widenNeon, narrowAsciiNeon, "neon"
+    };
+#endif
+    return {
+      Simd::findScalar, Simd::rfindScalar,
+      Simd::findFrameSyncScalar, Simd::rfindFrameSyncScalar,
+      Simd::asciiLengthScalar, Simd::widenScalar, Simd::narrowAsciiScalar, "none"
+    };
+  }
+
+  const Kernels &kernels()
+  {
+    static const Kernels selected = selectKernels();
+    return selected;
+  }
+}  // namespace
+
+const char *Simd::instructionSet()
+{
+  return kernels().name;
+}
+
+const char *Simd::find(const char *begin, const char *end,
+                       const char *pattern, size_t patternSize)
+{
+  return kernels().find(begin, end, pattern, patternSize);
+}
+
+const char *Simd::rfind(const char *begin, const char *end,
+                        const char *pattern, size_t patternSize)
+{
+  return kernels().rfind(begin, end, pattern, patternSize);
+}
+
+const char *Simd::findFrameSync(const char *begin, const char *end)
+{
+  return kernels().findFrameSync(begin, end);
+}
+
+const char *Simd::rfindFrameSync(const char *begin, const char *end)
+{
+  return kernels().rfindFrameSync(begin, end);
+}
+
+size_t Simd::asciiLength(const char *begin, const char *end)
+{
+  return kernels().asciiLength(begin, end);
+}
+
+void Simd::widen(const char *src, size_t length, wchar_t *dst)
+{
+  kernels().widen(src, length, dst);
+}
+
+size_t Simd::narrowAscii(const wchar_t *src, size_t length, char *dst)
+{
+  return kernels().narrowAscii(src, length, dst);
+}
+
+const char *Simd::findScalar(const char *begin, const char *end,
+                             const char *pattern, size_t patternSize)
+{
+  if(static_cast<size_t>(end - begin) < patternSize)
+    return nullptr;
+
+  const char *const lastStart = end - patternSize;
+  for(const char *p = begin; p <= lastStart; ++p) {
+    if(*p == *pattern && memcmp(p + 1, pattern + 1, patternSize - 1) == 0)
+      return p;
+  }
+
+  return nullptr;
+}
+
+const char *Simd::rfindScalar(const char *begin, const char *end,
+                              const char *pattern, size_t patternSize)
+{
+  if(static_cast<size_t>(end - begin) < patternSize)
+    return nullptr;
+
+  for(const char *p = end - patternSize; ; --p) {
+    if(*p == *pattern && memcmp(p + 1, pattern + 1, patternSize - 1) == 0)
+      return p;
+    if(p == begin)
+      break;
+  }
+
+  return nullptr;
+}
+
+const char *Simd::findFrameSyncScalar(const char *begin, const char *end)
+{
+  for(const char *p = begin; end - p >= 2; ++p) {
+    if(isFrameSyncAt(p))
+      return p;
+  }
+
+  return nullptr;
+}
+
+const char *Simd::rfindFrameSyncScalar(const char *begin, const char *end)
+{
+  if(end - begin < 2)
+    return nullptr;
+
+  for(const char *p = end - 2; ; --p) {
+    if(isFrameSyncAt(p))
+      return p;
+    if(p == begin)
+      break;
+  }
+
+  return nullptr;
+}
+
+size_t Simd::asciiLengthScalar(const char *begin, const char *end)
+{
+  const char *p = begin;
+  while(p != end && static_cast<unsigned char>(*p) < 0x80)
+    ++p;
+  return static_cast<size_t>(p - begin);
+}
+
+void Simd::widenScalar(const char *src, size_t length, wchar_t *dst)
+{
+  for(size_t i = 0; i < length; ++i)
+    dst[i] = static_cast<unsigned char>(src[i]);
+}
+
+size_t Simd::narrowAsciiScalar(const wchar_t *src, size_t length, char *dst)
+{
+  size_t i = 0;
+  for(; i < length && static_cast<unsigned int>(src[i]) < 0x80; ++i)
+    dst[i] = static_cast<char>(src[i]);
+  return i;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#ifndef TAGLIB_SIMD_H
+#define TAGLIB_SIMD_H
+
+// THIS FILE IS NOT A PART OF THE TAGLIB API
+
+#ifndef DO_NOT_DOCUMENT  // tell Doxygen not to document this header
+
+#include <cstddef>
+
+namespace TagLib {
+
+  namespace Simd {
+
+    /*!
+     * Returns the name of the instruction set used by the functions in this
+     * namespace: "avx2", "sse2", "neon" or "none".  It is selected once at
+     * runtime based on the capabilities of the CPU.
+     */
+    const char *instructionSet();
+
+    /*!
+     * Returns a pointer to the first occurrence of the \a patternSize bytes
+     * at \a pattern in the range from \a begin to \a end, or a null pointer if
+     * it is not found.  \a patternSize must not be zero.
+     */
+    const char *find(const char *begin, const char *end,
+                     const char *pattern, size_t patternSize);
+
+    /*!
+     * Returns a pointer to the last occurrence of the \a patternSize bytes
+     * at \a pattern in the range from \a begin to \a end, or a null pointer if
+     * it is not found.  \a patternSize must not be zero.
+     */
+    const char *rfind(const char *begin, const char *end,
+                      const char *pattern, size_t patternSize);
+
+    /*!
+     * Returns a pointer to the first MPEG frame sync in the range from
+     * \a begin to \a end, i.e. a 0xFF byte followed by a byte with the three
+     * most significant bits set which is not 0xFF itself, or a null pointer if
+     * there is none.  Both bytes have to be inside the range.
+     *
+     * \see MPEG::isFrameSync()
+     */
+    const char *findFrameSync(const char *begin, const char *end);
+
+    /*!
+     * Returns a pointer to the last MPEG frame sync in the range from
+     * \a begin to \a end, or a null pointer if there is none.
+     *
+     * \see findFrameSync()
+     */
+    const char *rfindFrameSync(const char *begin, const char *end);
+
+    /*!
+     * Returns the number of bytes before the first non-ASCII byte in the
+     * range from \a begin to \a end.
+     */
+    size_t asciiLength(const char *begin, const char *end);
+
+    /*!
+     * Converts \a length Latin-1 (or ASCII) characters from \a src to
+     * \c wchar_t values at \a dst.
+     */
+    void widen(const char *src, size_t length, wchar_t *dst);
+
+    /*!
+     * Converts the leading ASCII characters of the \a length characters at
+     * \a src to bytes at \a dst and returns their number.  The conversion
+     * stops at the first character which is not ASCII.
+     */
+    size_t narrowAscii(const wchar_t *src, size_t length, char *dst);
+
+    /*!
+     * Scalar versions of the functions above, used for short ranges and as
+     * the reference for the vectorized implementations.
+     */
+    const char *findScalar(const char *begin, const char *end,
+                           const char *pattern, size_t patternSize);
+    const char *rfindScalar(const char *begin, const char *end,
+                            const char *pattern, size_t patternSize);
+    const char *findFrameSyncScalar(const char *begin, const char *end);
+    const char *rfindFrameSyncScalar(const char *begin, const char *end);
+    size_t asciiLengthScalar(const char *begin, const char *end);
+    void widenScalar(const char *src, size_t length, wchar_t *dst);
+    size_t narrowAsciiScalar(const wchar_t *src, size_t length, char *dst);
+
+  }  // namespace Simd
+}  // namespace TagLib
+
+#endif
+
+#endif
@@ -25,12 +25,18 @@
 
 #include "tstring.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <climits>
+#include <cstring>
 #include <iostream>
+#include <thread>
 #include <utf8.h>
 
 #include "tdebug.h"
+#include "tarena.h"
+#include "tsimd.h"
 #include "tstringlist.h"
 #include "tutils.h"
 
@@ -45,31 +51,201 @@ namespace
                                                            : String::UTF16BE;
   }
 
+  // States of the UTF-16 copy of a string held in UTF-8.
+  enum WideState { WideMissing, WideConverting, WideReady };
+
+  bool isAsciiText(const char *s, size_t length)
+  {
+    return Simd::asciiLength(s, s + length) == length;
+  }
+
+  // Returns the number of UTF-16 code units needed for valid UTF-8 text.
+  size_t utf16Length(const std::string &s)
+  {
+    size_t length = 0;
+    for(char c : s) {
+      const auto b = static_cast<unsigned char>(c);
+      if((b & 0xc0) != 0x80)
+        length += b >= 0xf0 ? 2 : 1;
+    }
+    return length;
+  }
+
+  // Output iterator which only counts the UTF-16 code units written to it,
+  // used to check UTF-8 text without converting it.
+  class UTF16Counter
+  {
+  public:
+    explicit UTF16Counter(size_t &count) : count(&count) {}
+    UTF16Counter &operator*() { return *this; }
+    UTF16Counter &operator++() { return *this; }
+    UTF16Counter operator++(int) { return *this; }
+
+    template <typename T>
+    UTF16Counter &operator=(T)
+    {
+      ++*count;
+      return *this;
+    }
+
+  private:
+    size_t *count;
+  };
+
+  // Reads a code point from valid UTF-8 text.
+  template <typename Iterator>
+  unsigned int nextCodePoint(Iterator &it)
+  {
+    const auto lead = static_cast<unsigned char>(*it++);
+    if(lead < 0x80)
+      return lead;
+
+    int trailing = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : 1;
+    unsigned int c = lead & (0x3f >> trailing);
+    while(trailing-- > 0)
+      c = (c << 6) | (static_cast<unsigned char>(*it++) & 0x3f);
+    return c;
+  }
+
+  // Compares valid UTF-8 text with UTF-16 text in the order of the UTF-16
+  // code units, without converting either of them.
+  int compareUTF8ToUTF16(const std::string &s8, const std::wstring &s16)
+  {
+    auto it8 = s8.cbegin();
+    auto it16 = s16.cbegin();
+    unsigned int trail = 0;
+
+    while((trail != 0 || it8 != s8.cend()) && it16 != s16.cend()) {
+      unsigned int c = trail;
+      if(trail != 0) {
+        trail = 0;
+      }
+      else if(c = nextCodePoint(it8); c > 0xffff) {
+        trail = 0xdc00 + ((c - 0x10000) & 0x3ff);
+        c = 0xd800 + ((c - 0x10000) >> 10);
+      }
+
+      if(const auto c16 = static_cast<unsigned int>(*it16++); c != c16)
+        return c < c16 ? -1 : 1;
+    }
+
+    const bool more8 = trail != 0 || it8 != s8.cend();
+    const bool more16 = it16 != s16.cend();
+    return more8 == more16 ? 0 : more8 ? 1 : -1;
+  }
+
+  // Compares valid UTF-8 texts in the order of their UTF-16 code units.  This
+  // only differs from the byte order in placing the supplementary characters
+  // (lead bytes 0xF0 to 0xF4) before U+E000 to U+FFFF (lead bytes 0xEE and
+  // 0xEF), which are not encoded with surrogates.
+  bool lessUTF8(const std::string &s1, const std::string &s2)
+  {
+    const auto [it1, it2] = std::mismatch(s1.cbegin(), s1.cend(), s2.cbegin(), s2.cend());
+    if(it2 == s2.cend())
+      return false;
+    if(it1 == s1.cend())
+      return true;
+
+    const auto rank = [](char c) {
+      const auto b = static_cast<unsigned int>(static_cast<unsigned char>(c));
+      return b == 0xee || b == 0xef ? b + 0x10 : b;
+    };
+    return rank(*it1) < rank(*it2);
+  }
+
+  // Writes a code point as UTF-8 and returns the end of the written bytes.
+  char *writeUTF8(char *out, unsigned int c)
+  {
+    if(c < 0x80) {
+      *out++ = static_cast<char>(c);
+    }
+    else if(c < 0x800) {
+      *out++ = static_cast<char>(0xc0 | (c >> 6));
+      *out++ = static_cast<char>(0x80 | (c & 0x3f));
+    }
+    else if(c < 0x10000) {
+      *out++ = static_cast<char>(0xe0 | (c >> 12));
+      *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+      *out++ = static_cast<char>(0x80 | (c & 0x3f));
+    }
+    else {
+      *out++ = static_cast<char>(0xf0 | (c >> 18));
+      *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+      *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+      *out++ = static_cast<char>(0x80 | (c & 0x3f));
+    }
+    return out;
+  }
+
   // Converts a Latin-1 string into UTF-16(without BOM/CPU byte order)
   // and copies it to the internal buffer.
   void copyFromLatin1(std::wstring &data, const char *s, size_t length)
   {
     data.resize(length);
-
-    for(size_t i = 0; i < length; ++i)
-      data[i] = static_cast<unsigned char>(s[i]);
+    Simd::widen(s, length, data.data());
   }
 
-  // Converts a UTF-8 string into UTF-16(without BOM/CPU byte order)
-  // and copies it to the internal buffer.
-  void copyFromUTF8(std::wstring &data, const char *s, size_t length)
+  // Converts valid UTF-8 text with length UTF-16 code units into
+  // UTF-16(without BOM/CPU byte order) and copies it to the internal buffer.
+  // Runs of ASCII characters are converted by the vectorized kernels.
+  void copyFromUTF8(std::wstring &data, const std::string &s, size_t length)
   {
     data.resize(length);
 
-    try {
-      const std::wstring::iterator dstEnd = utf8::utf8to16(s, s + length, data.begin());
-      data.resize(dstEnd - data.begin());
+    wchar_t *out = data.data();
+    const char *p = s.data();
+    const char *const end = p + s.size();
+    while(p != end) {
+      if(static_cast<unsigned char>(*p) < 0x80) {
+        const size_t ascii = Simd::asciiLength(p, end);
+        Simd::widen(p, ascii, out);
+        p += ascii;
+        out += ascii;
+      }
+      else if(const unsigned int c = nextCodePoint(p); c > 0xffff) {
+        *out++ = static_cast<wchar_t>(0xd800 + ((c - 0x10000) >> 10));
+        *out++ = static_cast<wchar_t>(0xdc00 + ((c - 0x10000) & 0x3ff));
+      }
+      else {
+        *out++ = static_cast<wchar_t>(c);
+      }
     }
-    catch(const utf8::exception &e) {
-      const String message(e.what());
-      debug("String::copyFromUTF8() - UTF8-CPP error: " + message);
-      data.clear();
+  }
+
+  // Converts UTF-16 text into UTF-8, returns an empty vector if it contains
+  // unpaired surrogates.  Runs of ASCII characters are converted by the
+  // vectorized kernels.
+  ByteVector utf16ToUTF8(const std::wstring &s)
+  {
+    // A UTF-16 code unit takes up to three bytes, a surrogate pair four.
+
+    ByteVector v(static_cast<unsigned int>(s.size() * 3), 0);
+
+    char *out = v.data();
+    const wchar_t *p = s.data();
+    const wchar_t *const end = p + s.size();
+    while(p != end) {
+      const size_t ascii = Simd::narrowAscii(p, static_cast<size_t>(end - p), out);
+      p += ascii;
+      out += ascii;
+      if(p == end)
+        break;
+
+      unsigned int c = static_cast<unsigned short>(*p++);
+      if(c >= 0xd800 && c < 0xe000) {
+        const unsigned int trail = p != end ? static_cast<unsigned short>(*p) : 0;
+        if(c >= 0xdc00 || trail < 0xdc00 || trail >= 0xe000) {
+          debug("String::data() - Invalid UTF-16 string.");
+          return ByteVector();
+        }
+        c = 0x10000 + ((c - 0xd800) << 10) + (trail - 0xdc00);
+        ++p;
+      }
+      out = writeUTF8(out, c);
     }
+
+    v.resize(static_cast<unsigned int>(out - v.data()));
+    return v;
   }
 
   // Helper functions to read a UTF-16 character from an array.
@@ -134,38 +310,181 @@ namespace
 
 namespace TagLib {
 
+  // Allocated with Arena::makeShared(), so that the strings created while a
+  // file is parsed are taken from its arena.
+
   class String::StringPrivate
   {
   public:
+    static std::shared_ptr<StringPrivate> create()
+    {
+      return Arena::makeShared<StringPrivate>();
+    }
+
+    /*!
+     * Returns the number of UTF-16 code units.
+     */
+    size_t size() const
+    {
+      return utf8Native ? utf16Size : data.size();
+    }
+
+    /*!
+     * Returns true if the text is held in UTF-8 and only contains ASCII.
+     */
+    bool isStoredAscii() const
+    {
+      return utf8Native && utf16Size == utf8.size();
+    }
+
+    /*!
+     * Stores valid UTF-8 text with \a length UTF-16 code units.
+     */
+    void assignUTF8(std::string s, size_t length)
+    {
+      utf8 = std::move(s);
+      utf16Size = length;
+      utf8Native = true;
+      data.clear();
+      wideState.store(utf8.empty() ? WideReady : WideMissing, std::memory_order_relaxed);
+    }
+
+    /*!
+     * Checks and stores UTF-8 text without converting it.
+     */
+    void setUTF8(const char *s, size_t length)
+    {
+      // Only the text after the leading ASCII characters needs to be
+      // checked character by character.
+
+      const size_t ascii = Simd::asciiLength(s, s + length);
+      size_t units = ascii;
+      try {
+        utf8::utf8to16(s + ascii, s + length, UTF16Counter(units));
+      }
+      catch(const utf8::exception &e) {
+        const String message(e.what());
+        debug("String::copyFromUTF8() - UTF8-CPP error: " + message);
+        return;
+      }
+
+      assignUTF8(std::string(s, length), units);
+    }
+
+    /*!
+     * Stores Latin-1 text, in UTF-8 if it only contains ASCII.
+     */
+    void setLatin1(const char *s, size_t length)
+    {
+      if(isAsciiText(s, length))
+        assignUTF8(std::string(s, length), length);
+      else
+        copyFromLatin1(wideForWrite(), s, length);
+    }
+
+    /*!
+     * Appends valid UTF-8 text with \a length UTF-16 code units to the UTF-8
+     * text.  This must only be called on unshared data held in UTF-8.
+     */
+    void appendUTF8(const char *s, size_t bytes, size_t length)
+    {
+      utf8.append(s, bytes);
+      utf16Size += length;
+      data.clear();
+      wideState.store(utf8.empty() ? WideReady : WideMissing, std::memory_order_relaxed);
+    }
+
+    /*!
+     * Shrinks the string to the characters before the first null.
+     */
+    void truncateAtNull()
+    {
+      if(!utf8Native)
+        data.resize(::wcslen(data.c_str()));
+      else if(const auto pos = utf8.find('\0'); pos != std::string::npos)
+        assignUTF8(utf8.substr(0, pos), utf16Length(utf8.substr(0, pos)));
+    }
+
+    /*!
+     * Returns the text in UTF-16, which is converted from UTF-8 on first use.
+     */
+    const std::wstring &wide() const;
+
+    /*!
+     * Returns the text in UTF-16 to be modified, dropping the UTF-8 text.
+     * This must only be called on unshared data.
+     */
+    std::wstring &wideForWrite();
+
     /*!
      * Stores string in UTF-16. The byte order depends on the CPU endian.
+     * If the string is held in UTF-8, this is only a copy made by wide().
+     */
+    mutable std::wstring data;
+
+    /*!
+     * Stores string in UTF-8 if utf8Native is true.
      */
-    std::wstring data;
+    std::string utf8;
+    size_t utf16Size { 0 };
+    bool utf8Native { true };
+    mutable std::atomic<int> wideState { WideReady };
 
     /*!
      * This is only used to hold the most recent value of toCString().
      */
     std::string cstring;
-};
+  };
+
+  const std::wstring &String::StringPrivate::wide() const
+  {
+    if(wideState.load(std::memory_order_acquire) == WideReady)
+      return data;
+
+    // A shared string may be read by several threads at once, the first one
+    // converts it and the others wait until it is done.
+
+    if(int expected = WideMissing;
+       wideState.compare_exchange_strong(expected, WideConverting, std::memory_order_acquire)) {
+      copyFromUTF8(data, utf8, utf16Size);
+      wideState.store(WideReady, std::memory_order_release);
+    }
+    else {
+      while(wideState.load(std::memory_order_acquire) != WideReady)
+        std::this_thread::yield();
+    }
+    return data;
+  }
+
+  std::wstring &String::StringPrivate::wideForWrite()
+  {
+    if(utf8Native) {
+      wide();
+      std::string().swap(utf8);
+      utf16Size = 0;
+      utf8Native = false;
+    }
+    return data;
+  }
 
 ////////////////////////////////////////////////////////////////////////////////
 // public members
 ////////////////////////////////////////////////////////////////////////////////
 
 String::String() :
-  d(std::make_shared<StringPrivate>())
+  d(emptyPrivate())
 {
 }
 
 String::String(const String &) = default;
 
 String::String(const std::string &s, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(t == Latin1)
-    copyFromLatin1(d->data, s.c_str(), s.length());
+    d->setLatin1(s.c_str(), s.length());
   else if(t == String::UTF8)
-    copyFromUTF8(d->data, s.c_str(), s.length());
+    d->setUTF8(s.c_str(), s.length());
   else {
     debug("String::String() -- std::string should not contain UTF16.");
   }
@@ -177,10 +496,10 @@ String::String(const std::wstring &s) :
 }
 
 String::String(const std::wstring &s, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(t == UTF16 || t == UTF16BE || t == UTF16LE) {
-    copyFromUTF16(d->data, s.c_str(), s.length(), t);
+    copyFromUTF16(d->wideForWrite(), s.c_str(), s.length(), t);
   }
   else {
     debug("String::String() -- std::wstring should not contain Latin1 or UTF-8.");
@@ -193,11 +512,11 @@ String::String(const wchar_t *s) :
 }
 
 String::String(const wchar_t *s, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(s) {
     if(t == UTF16 || t == UTF16BE || t == UTF16LE) {
-      copyFromUTF16(d->data, s, ::wcslen(s), t);
+      copyFromUTF16(d->wideForWrite(), s, ::wcslen(s), t);
     }
     else {
       debug("String::String() -- const wchar_t * should not contain Latin1 or UTF-8.");
@@ -206,13 +525,13 @@ String::String(const wchar_t *s, Type t) :
 }
 
 String::String(const char *s, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(s) {
     if(t == Latin1)
-      copyFromLatin1(d->data, s, ::strlen(s));
+      d->setLatin1(s, ::strlen(s));
     else if(t == String::UTF8)
-      copyFromUTF8(d->data, s, ::strlen(s));
+      d->setUTF8(s, ::strlen(s));
     else {
       debug("String::String() -- const char * should not contain UTF16.");
     }
@@ -220,42 +539,42 @@ String::String(const char *s, Type t) :
 }
 
 String::String(wchar_t c, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(t == UTF16 || t == UTF16BE || t == UTF16LE)
-    copyFromUTF16(d->data, &c, 1, t);
+    copyFromUTF16(d->wideForWrite(), &c, 1, t);
   else {
     debug("String::String() -- wchar_t should not contain Latin1 or UTF-8.");
   }
 }
 
 String::String(char c, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(t == Latin1)
-    copyFromLatin1(d->data, &c, 1);
+    d->setLatin1(&c, 1);
   else if(t == String::UTF8)
-    copyFromUTF8(d->data, &c, 1);
+    d->setUTF8(&c, 1);
   else {
     debug("String::String() -- char should not contain UTF16.");
   }
 }
 
 String::String(const ByteVector &v, Type t) :
-  d(std::make_shared<StringPrivate>())
+  d(StringPrivate::create())
 {
   if(v.isEmpty())
     return;
 
   if(t == Latin1)
-    copyFromLatin1(d->data, v.data(), v.size());
+    d->setLatin1(v.data(), v.size());
   else if(t == UTF8)
-    copyFromUTF8(d->data, v.data(), v.size());
+    d->setUTF8(v.data(), v.size());
   else
-    copyFromUTF16(d->data, v.data(), v.size() / 2, t);
+    copyFromUTF16(d->wideForWrite(), v.data(), v.size() / 2, t);
 
   // If we hit a null in the ByteVector, shrink the string again.
-  d->data.resize(::wcslen(d->data.c_str()));
+  d->truncateAtNull();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -264,66 +583,87 @@ String::~String() = default;
 
 std::string String::to8Bit(bool unicode) const
 {
+  if(d->utf8Native && (unicode || d->isStoredAscii()))
+    return d->utf8;
+
   const ByteVector v = data(unicode ? UTF8 : Latin1);
   return std::string(v.data(), v.size());
 }
 
 std::wstring String::toWString() const
 {
-  return d->data;
+  return d->wide();
 }
 
 const char *String::toCString(bool unicode) const
 {
+  // The private data of empty strings is shared and may not be modified.
+
+  if(isEmpty())
+    return "";
+
+  // Text held in UTF-8 is returned as is, also as Latin1 if it is ASCII.
+
+  if(d->utf8Native && (unicode || d->isStoredAscii()))
+    return d->utf8.c_str();
+
   d->cstring = to8Bit(unicode);
   return d->cstring.c_str();
 }
 
 const wchar_t *String::toCWString() const
 {
-  return d->data.c_str();
+  return d->wide().c_str();
 }
 
 String::Iterator String::begin()
 {
   detach();
-  return d->data.begin();
+  return d->wideForWrite().begin();
 }
 
 String::ConstIterator String::begin() const
 {
-  return d->data.begin();
+  return d->wide().begin();
 }
 
 String::ConstIterator String::cbegin() const
 {
-  return d->data.cbegin();
+  return d->wide().cbegin();
 }
 
 String::Iterator String::end()
 {
   detach();
-  return d->data.end();
+  return d->wideForWrite().end();
 }
 
 String::ConstIterator String::end() const
 {
-  return d->data.end();
+  return d->wide().end();
 }
 
 String::ConstIterator String::cend() const
 {
-  return d->data.cend();
+  return d->wide().cend();
 }
 
 int String::find(const String &s, int offset) const
 {
-  return static_cast<int>(d->data.find(s.d->data, offset));
+  // In ASCII text the byte offsets are the same as the character offsets.
+
+  if(d->isStoredAscii() && s.d->utf8Native)
+    return static_cast<int>(d->utf8.find(s.d->utf8, offset));
+
+  return static_cast<int>(d->wide().find(s.d->wide(), offset));
 }
 
 int String::rfind(const String &s, int offset) const
 {
-  return static_cast<int>(d->data.rfind(s.d->data, offset));
+  if(d->isStoredAscii() && s.d->utf8Native)
+    return static_cast<int>(d->utf8.rfind(s.d->utf8, offset));
+
+  return static_cast<int>(d->wide().rfind(s.d->wide(), offset));
 }
 
 StringList String::split(const String &separator) const
@@ -346,6 +686,9 @@ bool String::startsWith(const String &s) const
   if(s.length() > length())
     return false;
 
+  if(d->utf8Native && s.d->utf8Native)
+    return d->utf8.compare(0, s.d->utf8.size(), s.d->utf8) == 0;
+
   return substr(0, s.length()) == s;
 }
 
@@ -353,13 +696,32 @@ String String::substr(unsigned int position, unsigned int n) const
 {
   if(position == 0 && n >= size())
     return *this;
-  return String(d->data.substr(position, n));
+
+  if(d->isStoredAscii()) {
+    std::string text = d->utf8.substr(position, n);
+    const size_t length = text.size();
+
+    String s;
+    s.d = StringPrivate::create();
+    s.d->assignUTF8(std::move(text), length);
+    return s;
+  }
+
+  return String(d->wide().substr(position, n));
 }
 
 String &String::append(const String &s)
 {
+  // Appending to an empty string just shares the other one.
+
+  if(isEmpty())
+    return *this = s;
+
   detach();
-  d->data += s.d->data;
+  if(d->utf8Native && s.d->utf8Native)
+    d->appendUTF8(s.d->utf8.data(), s.d->utf8.size(), s.d->utf16Size);
+  else
+    d->wideForWrite() += s.d->wide();
   return *this;
 }
 
@@ -371,22 +733,46 @@ String & String::clear()
 
 String String::upper() const
 {
-  String s;
-  s.d->data.reserve(size());
+  // Only ASCII letters are converted, so that text held in UTF-8 can be
+  // converted byte by byte, and strings without any are shared.
+
+  const auto isLower = [](auto c) { return c >= 'a' && c <= 'z'; };
+
+  if(d->utf8Native) {
+    if(std::none_of(d->utf8.begin(), d->utf8.end(), isLower))
+      return *this;
+
+    std::string text(d->utf8);
+    for(char &c : text) {
+      if(isLower(c))
+        c = static_cast<char>(c + 'A' - 'a');
+    }
+
+    String s;
+    s.d = StringPrivate::create();
+    s.d->assignUTF8(std::move(text), d->utf16Size);
+    return s;
+  }
+
+  if(std::none_of(d->data.begin(), d->data.end(), isLower))
+    return *this;
+
+  std::wstring data;
+  data.reserve(size());
 
   for(wchar_t c : *this) {
-    if(c >= 'a' && c <= 'z')
-      s.d->data.push_back(c + 'A' - 'a');
+    if(isLower(c))
+      data.push_back(c + 'A' - 'a');
     else
-      s.d->data.push_back(c);
+      data.push_back(c);
   }
 
-  return s;
+  return String(data);
 }
 
 unsigned int String::size() const
 {
-  return static_cast<unsigned int>(d->data.size());
+  return static_cast<unsigned int>(d->size());
 }
 
 unsigned int String::length() const
@@ -396,7 +782,7 @@ unsigned int String::length() const
 
 bool String::isEmpty() const
 {
-  return d->data.empty();
+  return d->size() == 0;
 }
 
 ByteVector String::data(Type t) const
@@ -405,6 +791,9 @@ ByteVector String::data(Type t) const
   {
   case Latin1:
     {
+      if(d->isStoredAscii())
+        return ByteVector(d->utf8.data(), size());
+
       ByteVector v(size(), 0);
       char *p = v.data();
 
@@ -416,19 +805,10 @@ ByteVector String::data(Type t) const
     }
   case UTF8:
     {
-      ByteVector v(size() * 4, 0);
+      if(d->utf8Native)
+        return ByteVector(d->utf8.data(), static_cast<unsigned int>(d->utf8.size()));
 
-      try {
-        const auto dstEnd = utf8::utf16to8(begin(), end(), v.begin());
-        v.resize(static_cast<unsigned int>(dstEnd - v.begin()));
-      }
-      catch(const utf8::exception &e) {
-        const String message(e.what());
-        debug("String::data() - UTF8-CPP error: " + message);
-        v.clear();
-      }
-
-      return v;
+      return utf16ToUTF8(d->data);
     }
   case UTF16:
     {
@@ -481,7 +861,7 @@ ByteVector String::data(Type t) const
 
 int String::toInt(bool *ok) const
 {
-  const wchar_t *beginPtr = d->data.c_str();
+  const wchar_t *beginPtr = d->wide().c_str();
   wchar_t *endPtr;
   errno = 0;
   const long value = ::wcstol(beginPtr, &endPtr, 10);
@@ -497,7 +877,7 @@ int String::toInt(bool *ok) const
 
 long long String::toLongLong(bool *ok, int base) const
 {
-  const wchar_t *beginPtr = d->data.c_str();
+  const wchar_t *beginPtr = d->wide().c_str();
   wchar_t *endPtr;
   errno = 0;
   const long long value = ::wcstoll(beginPtr, &endPtr, base);
@@ -509,7 +889,7 @@ long long String::toLongLong(bool *ok, int base) const
 
 unsigned long long String::toULongLong(bool *ok, int base) const
 {
-  const wchar_t *beginPtr = d->data.c_str();
+  const wchar_t *beginPtr = d->wide().c_str();
   wchar_t *endPtr;
   errno = 0;
   const unsigned long long value = ::wcstoull(beginPtr, &endPtr, base);
@@ -522,6 +902,25 @@ unsigned long long String::toULongLong(bool *ok, int base) const
 String String::stripWhiteSpace() const
 {
   static const wchar_t *WhiteSpaceChars = L"\t\n\f\r ";
+  static const char *WhiteSpaceChars8 = "\t\n\f\r ";
+
+  if(d->utf8Native) {
+    // Only ASCII characters are stripped, which take a byte each.
+
+    const size_t pos1 = d->utf8.find_first_not_of(WhiteSpaceChars8);
+    if(pos1 == std::string::npos)
+      return String();
+
+    const size_t pos2 = d->utf8.find_last_not_of(WhiteSpaceChars8);
+    if(pos1 == 0 && pos2 == d->utf8.size() - 1)
+      return *this;
+
+    String s;
+    s.d = StringPrivate::create();
+    s.d->assignUTF8(d->utf8.substr(pos1, pos2 - pos1 + 1),
+                    d->utf16Size - (d->utf8.size() - (pos2 - pos1 + 1)));
+    return s;
+  }
 
   const size_t pos1 = d->data.find_first_not_of(WhiteSpaceChars);
   if(pos1 == std::wstring::npos)
@@ -533,11 +932,18 @@ String String::stripWhiteSpace() const
 
 bool String::isLatin1() const
 {
+  if(d->utf8Native)
+    return std::none_of(d->utf8.begin(), d->utf8.end(),
+                        [](char c) { return static_cast<unsigned char>(c) > 0xc3; });
+
   return std::none_of(this->begin(), this->end(), [](auto c) { return c >= 256; });
 }
 
 bool String::isAscii() const
 {
+  if(d->utf8Native)
+    return d->isStoredAscii();
+
   return std::none_of(this->begin(), this->end(), [](auto c) { return c >= 128; });
 }
 
@@ -559,17 +965,28 @@ String String::fromULongLong(unsigned long long n) // static
 wchar_t &String::operator[](int i)
 {
   detach();
-  return d->data[i];
+  return d->wideForWrite()[i];
 }
 
 const wchar_t &String::operator[](int i) const
 {
-  return d->data[i];
+  return d->wide()[i];
 }
 
 bool String::operator==(const String &s) const
 {
-  return d == s.d || d->data == s.d->data;
+  if(d == s.d)
+    return true;
+  if(d->size() != s.d->size())
+    return false;
+
+  if(d->utf8Native && s.d->utf8Native)
+    return d->utf8 == s.d->utf8;
+  if(d->utf8Native)
+    return compareUTF8ToUTF16(d->utf8, s.d->data) == 0;
+  if(s.d->utf8Native)
+    return compareUTF8ToUTF16(s.d->utf8, d->data) == 0;
+  return d->data == s.d->data;
 }
 
 bool String::operator!=(const String &s) const
@@ -583,6 +1000,14 @@ bool String::operator==(const char *s) const
     return isEmpty();
   }
 
+  if(d->utf8Native) {
+    for(auto it = d->utf8.cbegin(); it != d->utf8.cend(); ++s) {
+      if(*s == '\0' || nextCodePoint(it) != static_cast<unsigned char>(*s))
+        return false;
+    }
+    return *s == '\0';
+  }
+
   const wchar_t *p = toCWString();
 
   while(*p != L'\0' || *s != '\0') {
@@ -603,7 +1028,7 @@ bool String::operator==(const wchar_t *s) const
     return isEmpty();
   }
 
-  return d->data == s;
+  return d->wide() == s;
 }
 
 bool String::operator!=(const wchar_t *s) const
@@ -613,10 +1038,7 @@ bool String::operator!=(const wchar_t *s) const
 
 String &String::operator+=(const String &s)
 {
-  detach();
-
-  d->data += s.d->data;
-  return *this;
+  return append(s);
 }
 
 String &String::operator+=(const wchar_t *s)
@@ -624,7 +1046,7 @@ String &String::operator+=(const wchar_t *s)
   if(s) {
     detach();
 
-    d->data += s;
+    d->wideForWrite() += s;
   }
   return *this;
 }
@@ -634,8 +1056,14 @@ String &String::operator+=(const char *s)
   if(s) {
     detach();
 
-    for(int i = 0; s[i] != 0; i++)
-      d->data += static_cast<unsigned char>(s[i]);
+    if(const size_t length = ::strlen(s); d->utf8Native && isAsciiText(s, length)) {
+      d->appendUTF8(s, length, length);
+    }
+    else {
+      std::wstring &data = d->wideForWrite();
+      for(size_t i = 0; i < length; i++)
+        data += static_cast<unsigned char>(s[i]);
+    }
   }
   return *this;
 }
@@ -644,7 +1072,10 @@ String &String::operator+=(wchar_t c)
 {
   detach();
 
-  d->data += c;
+  if(const char ascii = static_cast<char>(c); d->utf8Native && static_cast<unsigned int>(c) < 0x80)
+    d->appendUTF8(&ascii, 1, 1);
+  else
+    d->wideForWrite() += c;
   return *this;
 }
 
@@ -652,7 +1083,10 @@ String &String::operator+=(char c)
 {
   detach();
 
-  d->data += static_cast<unsigned char>(c);
+  if(d->utf8Native && static_cast<unsigned char>(c) < 0x80)
+    d->appendUTF8(&c, 1, 1);
+  else
+    d->wideForWrite() += static_cast<unsigned char>(c);
   return *this;
 }
 
@@ -709,6 +1143,12 @@ void String::swap(String &s) noexcept
 
 bool String::operator<(const String &s) const
 {
+  if(d->utf8Native && s.d->utf8Native)
+    return lessUTF8(d->utf8, s.d->utf8);
+  if(d->utf8Native)
+    return compareUTF8ToUTF16(d->utf8, s.d->data) < 0;
+  if(s.d->utf8Native)
+    return compareUTF8ToUTF16(s.d->utf8, d->data) > 0;
   return d->data < s.d->data;
 }
 
@@ -718,8 +1158,28 @@ bool String::operator<(const String &s) const
 
 void String::detach()
 {
-  if(d.use_count() > 1)
-    String(d->data.c_str()).swap(*this);
+  if(d.use_count() > 1) {
+    auto copy = StringPrivate::create();
+    if(d->utf8Native)
+      copy->assignUTF8(d->utf8, d->utf16Size);
+    else
+      copy->wideForWrite() = d->data;
+    d = std::move(copy);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// private members
+////////////////////////////////////////////////////////////////////////////////
+
+const std::shared_ptr<String::StringPrivate> &String::emptyPrivate()
+{
+  // Shared by the default constructed strings of a thread, so that creating
+  // them neither allocates nor contends with other threads.  It is never
+  // modified, as detach() copies it first.
+
+  static thread_local const auto empty = std::make_shared<StringPrivate>();
+  return empty;
 }
 
 }  // namespace TagLib
@@ -65,10 +65,13 @@ namespace TagLib {
   //! A \e wide string class suitable for unicode.
 
   /*!
-   * This is an implicitly shared \e wide string.  For storage it uses
-   * std::wstring, but as this is an <i>implementation detail</i> this of
-   * course could change.  Strings are stored internally as UTF-16 (without
-   * BOM/CPU byte order)
+   * This is an implicitly shared \e wide string.  Strings created from UTF-8
+   * or ASCII text are stored in UTF-8 and only converted to UTF-16 (without
+   * BOM/CPU byte order) when they are accessed as such, e.g. through the
+   * iterators or toCWString(), so that returning them as UTF-8 needs no
+   * conversion.  Other strings are stored internally as UTF-16 in a
+   * std::wstring.  As this is an <i>implementation detail</i> this of course
+   * could change.
    *
    * The use of implicit sharing means that copying a string is cheap, the only
    * \e cost comes into play when the copy is modified.  Prior to that the string
@@ -213,12 +216,12 @@ namespace TagLib {
      * The returned string is still owned by this String and should not be deleted
      * by the user.
      *
-     * The returned pointer remains valid until this String instance is destroyed
-     * or toCString() is called again.
+     * The returned pointer remains valid until this String instance is
+     * modified or destroyed, or toCString() is called again.
      *
-     * \warning This however has the side effect that the returned string will remain
-     * in memory <b>in addition to</b> other memory that is consumed by this
-     * String instance.  So, this method should not be used on large strings or
+     * \warning Unless the string is stored in UTF-8, this however has the side
+     * effect that the returned string will remain in memory <b>in addition
+     * to</b> other memory that is consumed by this String instance.  So, this method should not be used on large strings or
      * where memory is critical.  Consider using to8Bit() instead to avoid it.
      *
      * \see to8Bit()
@@ -236,8 +239,8 @@ namespace TagLib {
      * The returned pointer remains valid until this String instance is destroyed
      * or any other method of this String is called.
      *
-     * \note This returns a pointer to the String's internal data without any
-     * conversions.
+     * \note This returns a pointer to the String's internal data.  A string
+     * stored in UTF-8 is converted once and keeps the converted data.
      *
      * \see toWString()
      */
@@ -541,6 +544,12 @@ namespace TagLib {
 
   private:
     class StringPrivate;
+
+    /*!
+     * Returns the private data shared by all empty strings.
+     */
+    static const std::shared_ptr<StringPrivate> &emptyPrivate();
+
     TAGLIB_MSVC_SUPPRESS_WARNING_NEEDS_TO_HAVE_DLL_INTERFACE
     std::shared_ptr<StringPrivate> d;
   };
@@ -115,3 +115,112 @@ ByteVector zlib::decompress([[maybe_unused]] const ByteVector &data)
 {
   return decompress(data, UINT_MAX);
 }
+
+class zlib::Inflater::InflaterPrivate
+{
+public:
+#ifdef HAVE_ZLIB
+  z_stream stream {};
+#endif
+  unsigned int maxLength { UINT_MAX };
+  bool valid { false };
+  bool finished { false };
+};
+
+zlib::Inflater::Inflater(unsigned int maxLength) :
+  d(std::make_unique<InflaterPrivate>())
+{
+  d->maxLength = maxLength;
+
+#ifdef HAVE_ZLIB
+
+  d->valid = inflateInit(&d->stream) == Z_OK;
+  if(!d->valid)
+    debug("zlib::Inflater::Inflater() - Failed to initialize zlib.");
+
+#endif
+}
+
+zlib::Inflater::~Inflater()
+{
+#ifdef HAVE_ZLIB
+
+  if(d->valid)
+    inflateEnd(&d->stream);
+
+#endif
+}
+
+ByteVector zlib::Inflater::decompress([[maybe_unused]] const ByteVector &data)
+{
+#ifdef HAVE_ZLIB
+
+  if(!d->valid || d->finished)
+    return ByteVector();
+
+  ByteVector inData = data;
+
+  d->stream.avail_in = inData.size();
+  d->stream.next_in  = reinterpret_cast<Bytef *>(inData.data());
+
+  ByteVector outData;
+
+  do {
+    constexpr unsigned int chunkSize = 1024;
+    const size_t offset = outData.size();
+    outData.resize(outData.size() + chunkSize);
+
+    d->stream.avail_out = static_cast<uInt>(chunkSize);
+    d->stream.next_out  = reinterpret_cast<Bytef *>(outData.data() + offset);
+
+    const int result = inflate(&d->stream, Z_NO_FLUSH);
+    if(result == Z_STREAM_ERROR ||
+       result == Z_NEED_DICT ||
+       result == Z_DATA_ERROR ||
+       result == Z_MEM_ERROR)
+    {
+      inflateEnd(&d->stream);
+      d->valid = false;
+
+      debug("zlib::Inflater::decompress() - Error reading compressed stream.");
+      return ByteVector();
+    }
+
+    outData.resize(outData.size() - d->stream.avail_out);
+
+    if(d->stream.total_out > d->maxLength) {
+      inflateEnd(&d->stream);
+      d->valid = false;
+
+      debug("zlib::Inflater::decompress() - Too long compressed stream.");
+      outData.resize(static_cast<unsigned int>(
+        outData.size() - (d->stream.total_out - d->maxLength)));
+      break;
+    }
+
+    if(result == Z_STREAM_END) {
+      d->finished = true;
+      break;
+    }
+    if(result == Z_BUF_ERROR)
+      break;
+  } while(d->stream.avail_out == 0 || d->stream.avail_in > 0);
+
+  return outData;
+
+#else
+
+  return ByteVector();
+
+#endif
+}
+
+bool zlib::Inflater::isValid() const
+{
+  return d->valid;
+}
+
+bool zlib::Inflater::isFinished() const
+{
+  return d->finished;
+}
@@ -26,6 +26,8 @@
 #ifndef TAGLIB_TZLIB_H
 #define TAGLIB_TZLIB_H
 
+#include <memory>
+
 #include "tbytevector.h"
 
 // THIS FILE IS NOT A PART OF THE TAGLIB API
@@ -51,6 +53,45 @@ namespace TagLib {
       */
      ByteVector decompress(const ByteVector &data, unsigned int maxLength);
 
+     /*!
+      * Decompresses a zlib stream which is passed in pieces.
+      */
+     class Inflater
+     {
+     public:
+       /*!
+        * Constructs an inflater for a stream which decompresses to at most
+        * \a maxLength bytes.
+        */
+       explicit Inflater(unsigned int maxLength = 0xffffffff);
+       ~Inflater();
+       Inflater(const Inflater &) = delete;
+       Inflater &operator=(const Inflater &) = delete;
+
+       /*!
+        * Decompresses the next piece \a data of the stream and returns the
+        * data which could be decompressed so far.  Returns an empty
+        * ByteVector and sets isValid() to \c false on errors.  If the
+        * decompressed data exceeds the maximum length, it is cut there and
+        * isValid() is set to \c false as well.
+        */
+       ByteVector decompress(const ByteVector &data);
+
+       /*!
+        * Returns \c false if the stream is broken or zlib is not available.
+        */
+       bool isValid() const;
+
+       /*!
+        * Returns \c true if the end of the stream has been reached.
+        */
+       bool isFinished() const;
+
+     private:
+       class InflaterPrivate;
+       std::unique_ptr<InflaterPrivate> d;
+     };
+
   }  // namespace zlib
 }  // namespace TagLib
 
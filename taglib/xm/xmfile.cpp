@@ -26,6 +26,7 @@
 #include "xmfile.h"
 
 #include <algorithm>
+#include <list>
 #include <utility>
 #include <numeric>
 
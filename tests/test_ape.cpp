@@ -29,6 +29,7 @@
 #include "tstringlist.h"
 #include "tbytevectorlist.h"
 #include "tpropertymap.h"
+#include "tfilestream.h"
 #include "apetag.h"
 #include "id3v1tag.h"
 #include "apefile.h"
@@ -50,6 +51,7 @@ class TestAPE : public CppUnit::TestFixture
   CPPUNIT_TEST(testFuzzedFile2);
   CPPUNIT_TEST(testStripAndProperties);
   CPPUNIT_TEST(testRepeatedSave);
+  CPPUNIT_TEST(testDeferredBinaryItem);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -234,6 +236,43 @@ public:
     }
   }
 
+  void testDeferredBinaryItem()
+  {
+    ScopedFileCopy copy("mac-399", ".ape");
+
+    const ByteVector coverData = deferredPayload();
+    {
+      APE::File f(copy.fileName().c_str());
+      f.APETag(true)->setTitle("Title");
+      f.APETag()->setItem("COVER ART (FRONT)",
+        APE::Item("COVER ART (FRONT)", ByteVector("cover.jpg\0", 10) + coverData, true));
+      f.APETag()->setArtist("Artist");
+      f.save();
+    }
+
+    // Save without requesting the value, it is read before it is moved.
+    saveWithDeferredPayloads<APE::File>(copy.fileName(),
+      [](APE::File &f, FileStream &) {
+        CPPUNIT_ASSERT_EQUAL(String("Title"), f.tag()->title());
+        CPPUNIT_ASSERT_EQUAL(String("Artist"), f.tag()->artist());
+        const APE::Item item = f.APETag()->itemListMap()["COVER ART (FRONT)"];
+        CPPUNIT_ASSERT_EQUAL(APE::Item::Binary, item.type());
+        CPPUNIT_ASSERT(!item.isEmpty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<int>(8 + 17 + 1 + 10 + 5000), item.size());
+      },
+      [&](APE::File &f) {
+        const APE::Item item = f.APETag()->itemListMap()["COVER ART (FRONT)"];
+        CPPUNIT_ASSERT_EQUAL(ByteVector("cover.jpg\0", 10) + coverData, item.binaryData());
+      });
+    {
+      FileStream stream(copy.fileName().c_str());
+      stream.setMaxPayloadSize(1024);
+      APE::File f(&stream);
+      const APE::Item item = f.APETag()->itemListMap()["COVER ART (FRONT)"];
+      CPPUNIT_ASSERT_EQUAL(ByteVector("cover.jpg\0", 10) + coverData, item.binaryData());
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestAPE);
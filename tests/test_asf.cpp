@@ -23,12 +23,14 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <map>
 #include <string>
 #include <cstdio>
 
 #include "tstringlist.h"
 #include "tbytevectorlist.h"
 #include "tpropertymap.h"
+#include "tfilestream.h"
 #include "tag.h"
 #include "asffile.h"
 #include <cppunit/extensions/HelperMacros.h>
@@ -50,6 +52,7 @@ class TestASF : public CppUnit::TestFixture
   CPPUNIT_TEST(testSaveLargeValue);
   CPPUNIT_TEST(testSavePicture);
   CPPUNIT_TEST(testSaveMultiplePictures);
+  CPPUNIT_TEST(testDeferredPicture);
   CPPUNIT_TEST(testProperties);
   CPPUNIT_TEST(testPropertiesAllSupported);
   CPPUNIT_TEST(testPropertiesRealFile);
@@ -232,6 +235,46 @@ public:
     }
   }
 
+  void testDeferredPicture()
+  {
+    ScopedFileCopy copy("silence-1", ".wma");
+    string newname = copy.fileName();
+
+    const ByteVector pictureData = deferredPayload();
+    {
+      ASF::File f(newname.c_str());
+      ASF::Picture picture;
+      picture.setMimeType("image/jpeg");
+      picture.setType(ASF::Picture::FrontCover);
+      picture.setDescription("description");
+      picture.setPicture(pictureData);
+      f.tag()->setAttribute("WM/Picture", picture);
+      f.save();
+    }
+    saveWithDeferredPayloads<ASF::File>(newname,
+      [](ASF::File &f, FileStream &) {
+        ASF::Picture picture = f.tag()->attribute("WM/Picture").front().toPicture();
+        CPPUNIT_ASSERT(picture.isValid());
+        CPPUNIT_ASSERT(picture.isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(String("image/jpeg"), picture.mimeType());
+        CPPUNIT_ASSERT_EQUAL(String("description"), picture.description());
+        CPPUNIT_ASSERT_EQUAL(9 + (10 + 11) * 2 + 5000, picture.dataSize());
+      },
+      [&](ASF::File &f) {
+        ASF::Picture picture = f.tag()->attribute("WM/Picture").front().toPicture();
+        CPPUNIT_ASSERT_EQUAL(pictureData, picture.picture());
+      });
+    {
+      FileStream stream(newname.c_str());
+      stream.setMaxPayloadSize(1024);
+      ASF::File f(&stream);
+      ASF::Picture picture = f.tag()->attribute("WM/Picture").front().toPicture();
+      CPPUNIT_ASSERT(picture.isDataDeferred());
+      CPPUNIT_ASSERT_EQUAL(pictureData, picture.picture());
+      CPPUNIT_ASSERT(!picture.isDataDeferred());
+    }
+  }
+
   void testSaveMultiplePictures()
   {
     ScopedFileCopy copy("silence-1", ".wma");
@@ -44,6 +44,7 @@ class TestByteVector : public CppUnit::TestFixture
   CPPUNIT_TEST(testRfind1);
   CPPUNIT_TEST(testRfind2);
   CPPUNIT_TEST(testRfind3);
+  CPPUNIT_TEST(testFindLongData);
   CPPUNIT_TEST(testToHex);
   CPPUNIT_TEST(testIntegerConversion);
   CPPUNIT_TEST(testFloatingPointConversion);
@@ -55,6 +56,7 @@ class TestByteVector : public CppUnit::TestFixture
   CPPUNIT_TEST(testAppend2);
   CPPUNIT_TEST(testBase64);
   CPPUNIT_TEST(testEmpty);
+  CPPUNIT_TEST(testInlineStorage);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -174,6 +176,86 @@ public:
     CPPUNIT_ASSERT_EQUAL(1, ByteVector(".OggS....").rfind('O'));
   }
 
+  static int referenceFind(const ByteVector &data, const ByteVector &pattern,
+                           unsigned int offset, int byteAlign)
+  {
+    const int last = static_cast<int>(data.size()) - static_cast<int>(pattern.size());
+    for(int i = static_cast<int>(offset); i <= last; i += byteAlign) {
+      if(data.containsAt(pattern, i))
+        return i;
+    }
+    return -1;
+  }
+
+  static int referenceRfind(const ByteVector &data, const ByteVector &pattern,
+                            unsigned int offset, int byteAlign)
+  {
+    if(offset > 0) {
+      offset = data.size() - offset - pattern.size();
+      if(offset >= data.size())
+        offset = 0;
+    }
+    const int last = static_cast<int>(data.size()) - static_cast<int>(pattern.size())
+                     - static_cast<int>(offset);
+    for(int i = last; i >= 0; i -= byteAlign) {
+      if(data.containsAt(pattern, i))
+        return i;
+    }
+    return -1;
+  }
+
+  void testFindLongData()
+  {
+    // Long enough for the vectorized search, with a small alphabet so that
+    // there are many partial matches.
+
+    unsigned int seed = 12345;
+    const auto next = [&seed] {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 16) & 0x7fff;
+    };
+
+    for(int round = 0; round < 300; ++round) {
+      ByteVector data(next() % 200);
+      for(auto &c : data)
+        c = static_cast<char>('a' + next() % 3);
+
+      const unsigned int patternSize = 1 + next() % 6;
+      ByteVector pattern(patternSize);
+      if(data.size() > patternSize && next() % 2 == 0) {
+        pattern = data.mid(next() % (data.size() - patternSize), patternSize);
+      }
+      else {
+        for(auto &c : pattern)
+          c = static_cast<char>('a' + next() % 3);
+      }
+
+      const unsigned int offset = next() % (data.size() + 2);
+      const int byteAlign = 1 + static_cast<int>(next() % 10);
+
+      CPPUNIT_ASSERT_EQUAL(referenceFind(data, pattern, offset, byteAlign),
+                           data.find(pattern, offset, byteAlign));
+      CPPUNIT_ASSERT_EQUAL(referenceRfind(data, pattern, offset, byteAlign),
+                           data.rfind(pattern, offset, byteAlign));
+      CPPUNIT_ASSERT_EQUAL(referenceFind(data, pattern.mid(0, 1), offset, byteAlign),
+                           data.find(pattern[0], offset, byteAlign));
+    }
+
+    ByteVector large(100000U, 'x');
+    CPPUNIT_ASSERT_EQUAL(-1, large.find("OggS"));
+    large[70001] = 'O';
+    large[70002] = 'g';
+    large[70003] = 'g';
+    large[70004] = 'S';
+    large[90000] = 'O';
+    CPPUNIT_ASSERT_EQUAL(70001, large.find("OggS"));
+    CPPUNIT_ASSERT_EQUAL(70001, large.rfind("OggS"));
+    CPPUNIT_ASSERT_EQUAL(-1, large.find("OggS", 70002));
+    CPPUNIT_ASSERT_EQUAL(90000, large.rfind('O'));
+    CPPUNIT_ASSERT_EQUAL(-1, large.find("OggS", 0, 2));
+    CPPUNIT_ASSERT_EQUAL(70001, large.find("OggS", 1, 2));
+  }
+
   void testToHex()
   {
     ByteVector v("\xf0\xe1\xd2\xc3\xb4\xa5\x96\x87\x78\x69\x5a\x4b\x3c\x2d\x1e\x0f", 16);
@@ -702,6 +784,46 @@ public:
     CPPUNIT_ASSERT_EQUAL(empty.toBase64(), empty);
   }
 
+  void testInlineStorage()
+  {
+    // Short vectors are copied, long ones shared until they are modified.
+    ByteVector v1("0123456789abcdef");
+    ByteVector v2 = v1;
+    v2[0] = 'x';
+    CPPUNIT_ASSERT_EQUAL(ByteVector("0123456789abcdef"), v1);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("x123456789abcdef"), v2);
+
+    // Growing beyond the inline capacity keeps the contents.
+    v1.append('g');
+    CPPUNIT_ASSERT_EQUAL(ByteVector("0123456789abcdefg"), v1);
+    v1.resize(20, 'z');
+    CPPUNIT_ASSERT_EQUAL(ByteVector("0123456789abcdefgzzz"), v1);
+    v1.resize(3);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("012"), v1);
+    v1.resize(5, 'y');
+    CPPUNIT_ASSERT_EQUAL(ByteVector("012yy"), v1);
+
+    ByteVector v3(4, 'a');
+    v3.resize(2);
+    v3.resize(4, 'b');
+    CPPUNIT_ASSERT_EQUAL(ByteVector("aabb"), v3);
+
+    // Short slices of long vectors are copied, long ones shared.
+    const ByteVector v4 = ByteVector("0123456789abcdefghijklmnopqrstuvwxyz");
+    ByteVector v5 = v4.mid(10, 4);
+    ByteVector v6 = v4.mid(10, 20);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("abcd"), v5);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("abcdefghijklmnopqrst"), v6);
+    v5[0] = 'A';
+    v6[0] = 'B';
+    CPPUNIT_ASSERT_EQUAL(ByteVector("Abcd"), v5);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("Bbcdefghijklmnopqrst"), v6);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("0123456789abcdefghijklmnopqrstuvwxyz"), v4);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("cde"), v6.mid(1, 4).mid(1));
+    CPPUNIT_ASSERT_EQUAL('t', *v6.rbegin());
+    CPPUNIT_ASSERT_EQUAL(20L, static_cast<long>(v6.rend() - v6.rbegin()));
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestByteVector);
@@ -23,7 +23,11 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <filesystem>
+
 #include "tfile.h"
+#include "tfilestream.h"
+#include "tbytevectorstream.h"
 #include "plainfile.h"
 #include <cppunit/extensions/HelperMacros.h>
 #include "utils.h"
@@ -37,8 +41,29 @@ class TestFile : public CppUnit::TestFixture
   CPPUNIT_TEST(testRFindInSmallFile);
   CPPUNIT_TEST(testSeek);
   CPPUNIT_TEST(testTruncate);
+  CPPUNIT_TEST(testReadView);
+  CPPUNIT_TEST(testIOBufferSize);
+  CPPUNIT_TEST(testInsertRemoveLarge);
+  CPPUNIT_TEST(testInsertRemoveBlockAligned);
+  CPPUNIT_TEST(testFindAcrossGrowingBuffers);
+  CPPUNIT_TEST(testAtomicWrite);
+  CPPUNIT_TEST(testAtomicWriteRollback);
+  CPPUNIT_TEST(testWritePlan);
+  CPPUNIT_TEST(testWritePlanInvalid);
   CPPUNIT_TEST_SUITE_END();
 
+  static int countTempFiles(const std::string &name)
+  {
+    const std::filesystem::path path(name);
+    const std::string prefix = path.filename().string() + ".taglib-";
+    int count = 0;
+    for(const auto &entry : std::filesystem::directory_iterator(path.parent_path())) {
+      if(entry.path().filename().string().compare(0, prefix.size(), prefix) == 0)
+        ++count;
+    }
+    return count;
+  }
+
 public:
 
   void testFindInSmallFile()
@@ -139,6 +164,294 @@ public:
     }
   }
 
+  void testReadView()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    PlainFile f(name.c_str());
+    f.seek(0);
+    const ByteVector block = f.readBlock(100);
+
+    f.seek(0);
+    const ByteVector v1 = f.readView(4);
+    const ByteVector v2 = f.readView(96);
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(100), f.tell());
+    CPPUNIT_ASSERT_EQUAL(block.mid(0, 4), v1);
+    CPPUNIT_ASSERT_EQUAL(block.mid(4, 96), v2);
+
+    f.seek(2);
+    f.writeBlock(ByteVector("xy", 2));
+    f.seek(0);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("Ogxy", 4), f.readView(4));
+    CPPUNIT_ASSERT_EQUAL(block.mid(0, 4), v1);
+
+    f.seek(-2, File::End);
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(2), f.readView(10).size());
+    CPPUNIT_ASSERT_EQUAL(f.length(), f.tell());
+  }
+
+  void testIOBufferSize()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    FileStream stream(copy.fileName().c_str());
+    CPPUNIT_ASSERT_EQUAL(65536U, stream.ioBufferSize());
+    stream.setIOBufferSize(1 << 20);
+    CPPUNIT_ASSERT_EQUAL(1048576U, stream.ioBufferSize());
+    stream.setIOBufferSize(10);
+    CPPUNIT_ASSERT_EQUAL(1024U, stream.ioBufferSize());
+  }
+
+  void testInsertRemoveLarge()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    ByteVector content(3U * 1024 * 1024);
+    for(unsigned int i = 0; i < content.size(); ++i)
+      content[i] = static_cast<char>(i * 7 + i / 251);
+
+    {
+      FileStream stream(name.c_str());
+      stream.seek(0);
+      stream.writeBlock(content);
+      stream.truncate(content.size());
+
+      const ByteVector inserted(100000U, 'x');
+      stream.insert(inserted, 10, 20);
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(content.size() + 100000 - 20), stream.length());
+      stream.seek(0);
+      CPPUNIT_ASSERT_EQUAL(content.mid(0, 10) + inserted + content.mid(30),
+                           stream.readBlock(content.size() + 100000));
+
+      stream.removeBlock(10, 100000);
+      stream.seek(0);
+      CPPUNIT_ASSERT_EQUAL(content.mid(0, 10) + content.mid(30),
+                           stream.readBlock(content.size()));
+    }
+  }
+
+  void testInsertRemoveBlockAligned()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    ByteVector content(1024U * 1024);
+    for(unsigned int i = 0; i < content.size(); ++i)
+      content[i] = static_cast<char>(i % 251);
+
+    FileStream stream(name.c_str());
+    stream.seek(0);
+    stream.writeBlock(content);
+    stream.truncate(content.size());
+
+    // Offsets and sizes which are multiples of typical file system block
+    // sizes, so that the tail can be moved by the file system if supported.
+
+    const ByteVector inserted(256U * 1024, 'x');
+    stream.insert(inserted, 8192, 0);
+    stream.seek(0);
+    CPPUNIT_ASSERT_EQUAL(content.mid(0, 8192) + inserted + content.mid(8192),
+                         stream.readBlock(content.size() + inserted.size()));
+
+    stream.removeBlock(8192, inserted.size());
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(content.size()), stream.length());
+    stream.seek(0);
+    CPPUNIT_ASSERT_EQUAL(content, stream.readBlock(content.size()));
+  }
+
+  void testAtomicWrite()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    {
+      FileStream stream(name.c_str());
+      stream.writeBlock(ByteVector("0123456789", 10));
+      stream.truncate(10);
+    }
+    {
+      FileStream stream(name.c_str());
+      stream.seek(4);
+      CPPUNIT_ASSERT(stream.beginAtomicWrite());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(4), stream.tell());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(10), stream.length());
+
+      stream.insert(ByteVector("abc", 3), 2, 1);
+      stream.removeBlock(9, 3);
+      stream.seek(0);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("01abc3456", 9), stream.readBlock(100));
+
+      // Modifications within and behind the recorded data.
+
+      stream.seek(3);
+      stream.writeBlock(ByteVector("BC3", 3));
+      stream.seek(2, IOStream::End);
+      stream.writeBlock(ByteVector("z", 1));
+      stream.truncate(13);
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(13), stream.length());
+      stream.seek(-13, IOStream::End);
+      CPPUNIT_ASSERT_EQUAL(ByteVector("01aBC3456\0\0z\0", 13), stream.readBlock(100));
+      stream.truncate(9);
+      stream.seek(3);
+      stream.writeBlock(ByteVector("bc", 2));
+
+      // The original file is untouched until the write is committed.
+
+      CPPUNIT_ASSERT_EQUAL(ByteVector("0123456789", 10), PlainFile(name.c_str()).readAll());
+      CPPUNIT_ASSERT_EQUAL(1, countTempFiles(name));
+
+      CPPUNIT_ASSERT(stream.commitAtomicWrite());
+      CPPUNIT_ASSERT_EQUAL(0, countTempFiles(name));
+      CPPUNIT_ASSERT_EQUAL(ByteVector("01abc3456", 9), PlainFile(name.c_str()).readAll());
+
+      // The stream keeps working on the new file.
+
+      stream.seek(0, IOStream::End);
+      stream.writeBlock(ByteVector("x", 1));
+      CPPUNIT_ASSERT(!stream.commitAtomicWrite());
+    }
+    CPPUNIT_ASSERT_EQUAL(ByteVector("01abc3456x", 10), PlainFile(name.c_str()).readAll());
+
+    ByteVector data("0123456789", 10);
+    ByteVectorStream memoryStream(data);
+    CPPUNIT_ASSERT(!memoryStream.beginAtomicWrite());
+  }
+
+  void testAtomicWriteRollback()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    const ByteVector original = PlainFile(name.c_str()).readAll();
+    {
+      FileStream stream(name.c_str());
+      CPPUNIT_ASSERT(stream.beginAtomicWrite());
+      stream.insert(ByteVector(5000U, 'x'), 100, 0);
+      stream.rollbackAtomicWrite();
+      CPPUNIT_ASSERT_EQUAL(0, countTempFiles(name));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(original.size()), stream.length());
+
+      // Destroying the stream discards an uncommitted write.
+
+      CPPUNIT_ASSERT(stream.beginAtomicWrite());
+      stream.truncate(0);
+    }
+    CPPUNIT_ASSERT_EQUAL(0, countTempFiles(name));
+    CPPUNIT_ASSERT_EQUAL(original, PlainFile(name.c_str()).readAll());
+    {
+      FileStream stream(name.c_str(), true);
+      CPPUNIT_ASSERT(!stream.beginAtomicWrite());
+    }
+  }
+
+  void testWritePlan()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+
+    ByteVector content(300000U);
+    for(unsigned int i = 0; i < content.size(); ++i)
+      content[i] = static_cast<char>(i % 253);
+
+    {
+      PlainFile file(name.c_str());
+      file.seek(0);
+      file.writeBlock(content);
+      file.truncate(content.size());
+    }
+    {
+      // Segments are moved in both directions.
+
+      PlainFile file(name.c_str());
+      File::WritePlan plan;
+      plan.replace(content.size(), 0, ByteVector("tail", 4));
+      plan.replace(10, 100, ByteVector(5000U, 'a'));
+      plan.replace(150000, 70000, ByteVector("b", 1));
+      plan.replace(250000, 0, ByteVector(80000U, 'c'));
+      plan.replace(250000, 10, ByteVector());
+      CPPUNIT_ASSERT(!plan.isEmpty());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(4 + 4900 - 69999 + 80000 - 10),
+                           plan.lengthDelta());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(5), plan.newOffset(5));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(10), plan.newOffset(10));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(120000 + 4900), plan.newOffset(120000));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(250000 + 4900 - 69999),
+                           plan.newOffset(250000));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(250000 + 4900 - 69999 + 80000),
+                           plan.newOffset(250000, true));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(content.size() + 4900 - 69999 + 80000 - 10 + 4),
+                           plan.newOffset(content.size(), true));
+      CPPUNIT_ASSERT(file.applyWritePlan(plan));
+
+      const ByteVector expected = content.mid(0, 10) + ByteVector(5000U, 'a') +
+        content.mid(110, 150000 - 110) + ByteVector("b", 1) +
+        content.mid(220000, 30000) + ByteVector(80000U, 'c') +
+        content.mid(250010) + ByteVector("tail", 4);
+      CPPUNIT_ASSERT_EQUAL(expected, file.readAll());
+      content = expected;
+    }
+    {
+      // All segments are moved towards the beginning.
+
+      PlainFile file(name.c_str());
+      File::WritePlan plan;
+      plan.replace(0, 1000, ByteVector("x", 1));
+      plan.replace(100000, 20000, ByteVector("y", 1));
+      plan.replace(content.size() - 4, 4, ByteVector());
+      CPPUNIT_ASSERT(file.applyWritePlan(plan));
+
+      const ByteVector expected = ByteVector("x", 1) + content.mid(1000, 99000) +
+        ByteVector("y", 1) + content.mid(120000, content.size() - 120004);
+      CPPUNIT_ASSERT_EQUAL(expected, file.readAll());
+    }
+  }
+
+  void testWritePlanInvalid()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    PlainFile file(name.c_str());
+    const ByteVector original = file.readAll();
+
+    File::WritePlan overlapping;
+    overlapping.replace(0, 10, ByteVector("a", 1));
+    overlapping.replace(5, 10, ByteVector("b", 1));
+    CPPUNIT_ASSERT(!file.applyWritePlan(overlapping));
+
+    File::WritePlan beyondEnd;
+    beyondEnd.replace(0, 1, ByteVector("a", 1));
+    beyondEnd.replace(original.size() - 1, 2, ByteVector("b", 1));
+    CPPUNIT_ASSERT(!file.applyWritePlan(beyondEnd));
+
+    CPPUNIT_ASSERT(file.applyWritePlan(File::WritePlan()));
+    CPPUNIT_ASSERT_EQUAL(original, file.readAll());
+  }
+
+  void testFindAcrossGrowingBuffers()
+  {
+    ScopedFileCopy copy("empty", ".ogg");
+    std::string name = copy.fileName();
+    {
+      PlainFile file(name.c_str());
+      file.seek(0);
+      ByteVector content(200000U, 'a');
+      content[3070] = 'x';
+      content[3071] = 'y';
+      content[3072] = 'z';
+      content[150000] = 'q';
+      file.writeBlock(content);
+      file.truncate(content.size());
+    }
+    {
+      PlainFile file(name.c_str());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(3070), file.find("xyz"));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(150000), file.find("q"));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(-1), file.find("q", 0, "xyz"));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(3070), file.rfind("xyz"));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(150000), file.rfind("q"));
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(0), file.tell());
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestFile);
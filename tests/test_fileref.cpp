@@ -107,7 +107,10 @@ class TestFileRef : public CppUnit::TestFixture
   CPPUNIT_TEST(testUnsupported);
   CPPUNIT_TEST(testAudioProperties);
   CPPUNIT_TEST(testDefaultFileExtensions);
+  CPPUNIT_TEST(testExtensionCase);
   CPPUNIT_TEST(testFileResolver);
+  CPPUNIT_TEST(testSaveAtomically);
+  CPPUNIT_TEST(testProbe);
 #ifdef TAGLIB_WITH_ASF
   CPPUNIT_TEST(testASF);
 #endif
@@ -480,6 +483,129 @@ public:
 #endif
   }
 
+  void testExtensionCase()
+  {
+    ScopedFileCopy copy("xing", ".Mp3");
+    FileRef f(copy.fileName().c_str());
+    CPPUNIT_ASSERT(dynamic_cast<MPEG::File *>(f.file()));
+  }
+
+  void testSaveAtomically()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string newname = copy.fileName();
+    {
+      FileRef f(newname.c_str());
+      CPPUNIT_ASSERT(!f.isNull());
+      f.tag()->setArtist("atomic artist");
+      f.tag()->setTitle(String(std::string(10000, 't')));
+      CPPUNIT_ASSERT(f.saveAtomically());
+      CPPUNIT_ASSERT_EQUAL(String("atomic artist"), f.tag()->artist());
+
+      // The file can be saved again after the first save replaced it.
+
+      f.tag()->setAlbum("atomic album");
+      CPPUNIT_ASSERT(f.saveAtomically());
+    }
+    {
+      FileRef f(newname.c_str());
+      CPPUNIT_ASSERT(!f.isNull());
+      CPPUNIT_ASSERT_EQUAL(String("atomic artist"), f.tag()->artist());
+      CPPUNIT_ASSERT_EQUAL(String(std::string(10000, 't')), f.tag()->title());
+      CPPUNIT_ASSERT_EQUAL(String("atomic album"), f.tag()->album());
+      CPPUNIT_ASSERT(f.audioProperties());
+      CPPUNIT_ASSERT_EQUAL(2, f.audioProperties()->lengthInSeconds());
+    }
+    {
+      FileRef f(newname.c_str(), true, AudioProperties::Average, FileRef::StreamType::Mmap);
+      CPPUNIT_ASSERT(!f.isNull());
+      f.tag()->setArtist("read only");
+      CPPUNIT_ASSERT(!f.saveAtomically());
+    }
+  }
+
+  void testProbe()
+  {
+    using Type = FileRef::FileType;
+    using Confidence = FileRef::ProbeConfidence;
+
+    const struct {
+      const char *fileName;
+      Type type;
+      Confidence confidence;
+    } files[] = {
+      { "xing.mp3", Type::MPEG, Confidence::Low },
+      { "ape-id3v1.mp3", Type::MPEG, Confidence::Medium },
+      { "ape-id3v2.mp3", Type::MPEG, Confidence::Medium },
+      { "empty1s.aac", Type::MPEG, Confidence::Low },
+      { "empty.ogg", Type::OggVorbis, Confidence::High },
+      { "empty_flac.oga", Type::OggFLAC, Confidence::High },
+      { "empty.spx", Type::OggSpeex, Confidence::High },
+      { "correctness_gain_silent_output.opus", Type::OggOpus, Confidence::High },
+      { "no-tags.flac", Type::FLAC, Confidence::High },
+      { "click.mpc", Type::MPC, Confidence::High },
+      { "click.wv", Type::WavPack, Confidence::High },
+      { "mac-399.ape", Type::APE, Confidence::High },
+      { "empty.tta", Type::TrueAudio, Confidence::Medium },
+      { "no-tags.m4a", Type::MP4, Confidence::High },
+      { "silence-1.wma", Type::ASF, Confidence::High },
+      { "empty.aiff", Type::AIFF, Confidence::High },
+      { "empty.wav", Type::WAV, Confidence::High },
+      { "rf64.wav", Type::WAV, Confidence::High },
+      { "test.mod", Type::Mod, Confidence::Low },
+      { "test.s3m", Type::S3M, Confidence::High },
+      { "test.it", Type::IT, Confidence::High },
+      { "test.xm", Type::XM, Confidence::High },
+      { "empty10ms.dsf", Type::DSF, Confidence::High },
+      { "empty10ms.dff", Type::DSDIFF, Confidence::High },
+      { "2sec-silence.shn", Type::Shorten, Confidence::High },
+      { "no-tags.mka", Type::Matroska, Confidence::High },
+      { "no-extension", Type::Unknown, Confidence::None },
+      { "unsupported-extension.xx", Type::Unknown, Confidence::None },
+    };
+
+    for(const auto &file : files) {
+      FileStream stream(TEST_FILE_PATH_C(file.fileName), true);
+      stream.seek(7);
+      const FileRef::ProbeResult result = FileRef::probe(&stream);
+      CPPUNIT_ASSERT_MESSAGE(file.fileName, result.type == file.type);
+      CPPUNIT_ASSERT_MESSAGE(file.fileName, result.confidence == file.confidence);
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(7), stream.tell());
+    }
+
+    CPPUNIT_ASSERT(FileRef::probe(nullptr).type == FileRef::FileType::Unknown);
+
+    // Only the strict ProTracker IDs at offset 1080 are accepted.
+    const struct {
+      const char *id;
+      Type type;
+    } modIds[] = {
+      { "M.K.", Type::Mod },
+      { "M!K!", Type::Mod },
+      { "6CHN", Type::Mod },
+      { "16CH", Type::Mod },
+      { "32CH", Type::Mod },
+      { "0CHN", Type::Unknown },
+      { "09CH", Type::Unknown },
+      { "33CH", Type::Unknown },
+      { "xxCH", Type::Unknown },
+      { "ABCN", Type::Unknown },
+      { "FLT4", Type::Unknown },
+      { "TDZ4", Type::Unknown },
+    };
+
+    for(const auto &modId : modIds) {
+      ByteVector data(1080, 0);
+      data.append(modId.id);
+      data.resize(2048, 0);
+      ByteVectorStream stream(data);
+      const FileRef::ProbeResult result = FileRef::probe(&stream);
+      CPPUNIT_ASSERT_MESSAGE(modId.id, result.type == modId.type);
+      CPPUNIT_ASSERT_MESSAGE(modId.id, result.confidence ==
+        (modId.type == Type::Mod ? Confidence::Low : Confidence::None));
+    }
+  }
+
   void testFileResolver()
   {
     {
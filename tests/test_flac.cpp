@@ -29,6 +29,7 @@
 #include "tstringlist.h"
 #include "tpropertymap.h"
 #include "tbytevectorstream.h"
+#include "tfilestream.h"
 #include "tag.h"
 #include "flacfile.h"
 #include "xiphcomment.h"
@@ -47,6 +48,7 @@ class TestFLAC : public CppUnit::TestFixture
   CPPUNIT_TEST(testSignature);
   CPPUNIT_TEST(testMultipleCommentBlocks);
   CPPUNIT_TEST(testReadPicture);
+  CPPUNIT_TEST(testDeferredPicture);
   CPPUNIT_TEST(testAddPicture);
   CPPUNIT_TEST(testReplacePicture);
   CPPUNIT_TEST(testRemoveAllPictures);
@@ -125,6 +127,57 @@ public:
     CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(150), pic->data().size());
   }
 
+  void testDeferredPicture()
+  {
+    ScopedFileCopy copy("silence-44-s", ".flac");
+    string newname = copy.fileName();
+
+    const ByteVector pictureData = deferredPayload();
+    {
+      FLAC::File f(newname.c_str());
+      auto newpic = new FLAC::Picture();
+      newpic->setType(FLAC::Picture::BackCover);
+      newpic->setMimeType("image/jpeg");
+      newpic->setDescription("Back");
+      newpic->setWidth(10);
+      newpic->setData(pictureData);
+      f.addPicture(newpic);
+      f.save();
+    }
+    saveWithDeferredPayloads<FLAC::File>(newname,
+      [&](FLAC::File &f, FileStream &stream) {
+        List<FLAC::Picture *> lst = f.pictureList();
+        CPPUNIT_ASSERT_EQUAL(2U, lst.size());
+        CPPUNIT_ASSERT(!lst[0]->isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(150U, lst[0]->data().size());
+
+        FLAC::Picture *pic = lst[1];
+        CPPUNIT_ASSERT(pic->isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(FLAC::Picture::BackCover, pic->type());
+        CPPUNIT_ASSERT_EQUAL(String("image/jpeg"), pic->mimeType());
+        CPPUNIT_ASSERT_EQUAL(String("Back"), pic->description());
+        CPPUNIT_ASSERT_EQUAL(10, pic->width());
+        CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(5000), pic->deferredDataSize());
+
+        stream.seek(pic->deferredDataOffset());
+        CPPUNIT_ASSERT_EQUAL(pictureData, stream.readBlock(5000));
+      },
+      [&](FLAC::File &f) {
+        List<FLAC::Picture *> lst = f.pictureList();
+        CPPUNIT_ASSERT_EQUAL(2U, lst.size());
+        CPPUNIT_ASSERT_EQUAL(pictureData, lst[1]->data());
+      });
+    {
+      FileStream stream(newname.c_str());
+      stream.setMaxPayloadSize(1024);
+      FLAC::File f(&stream);
+      FLAC::Picture *pic = f.pictureList()[1];
+      CPPUNIT_ASSERT(pic->isDataDeferred());
+      CPPUNIT_ASSERT_EQUAL(pictureData, pic->data());
+      CPPUNIT_ASSERT(!pic->isDataDeferred());
+    }
+  }
+
   void testAddPicture()
   {
     ScopedFileCopy copy("silence-44-s", ".flac");
@@ -29,7 +29,10 @@
 
 #include "tpropertymap.h"
 #include "tzlib.h"
+#include "tfilestream.h"
+#include "tbytevectorstream.h"
 #include "id3v2tag.h"
+#include "id3v2synchdata.h"
 #include "mpegfile.h"
 #include "id3v2frame.h"
 #include "uniquefileidentifierframe.h"
@@ -141,6 +144,14 @@ class TestID3v2 : public CppUnit::TestFixture
   CPPUNIT_TEST(testDuplicateTags);
   CPPUNIT_TEST(testParseTOCFrameWithManyChildren);
   CPPUNIT_TEST(testInvalidID3v2Version);
+  CPPUNIT_TEST(testDeferredPicture);
+  CPPUNIT_TEST(testDeferredCompressedPicture);
+  CPPUNIT_TEST(testDeferredUnsynchronisedPicture);
+  CPPUNIT_TEST(testArena);
+  CPPUNIT_TEST(testLazyFrameParsing);
+  CPPUNIT_TEST(testLazyFrameParsingMatchesEager);
+  CPPUNIT_TEST(testRenderUnmodifiedFrames);
+  CPPUNIT_TEST(testFrameListLookup);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -1766,6 +1777,403 @@ public:
     CPPUNIT_ASSERT_EQUAL(invalidRevisionHeader.tagSize(), 0U);
   }
 
+  void testDeferredPicture()
+  {
+    const ByteVector pictureData = deferredPayload();
+
+    for(auto version : {ID3v2::v3, ID3v2::v4}) {
+      ScopedFileCopy copy("xing", ".mp3");
+      string newname = copy.fileName();
+
+      {
+        MPEG::File f(newname.c_str());
+        auto frame = new ID3v2::AttachedPictureFrame;
+        frame->setMimeType("image/png");
+        frame->setDescription("Cover");
+        frame->setPicture(pictureData);
+        f.ID3v2Tag(true)->addFrame(frame);
+        f.ID3v2Tag()->setTitle("Title");
+        f.save(MPEG::File::ID3v2, File::StripOthers, version);
+      }
+      saveWithDeferredPayloads<MPEG::File>(newname, 1024,
+        [&](MPEG::File &f, FileStream &stream) {
+          CPPUNIT_ASSERT_EQUAL(String("Title"), f.ID3v2Tag()->title());
+          const ID3v2::FrameList frames = f.ID3v2Tag()->frameListMap()["APIC"];
+          CPPUNIT_ASSERT_EQUAL(1U, frames.size());
+          auto frame = dynamic_cast<ID3v2::AttachedPictureFrame *>(frames.front());
+          CPPUNIT_ASSERT(frame);
+          CPPUNIT_ASSERT(frame->isDataDeferred());
+          CPPUNIT_ASSERT_EQUAL(String("image/png"), frame->mimeType());
+          CPPUNIT_ASSERT_EQUAL(String("Cover"), frame->description());
+          CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(5000), frame->deferredDataSize());
+
+          stream.seek(frame->deferredDataOffset());
+          CPPUNIT_ASSERT_EQUAL(pictureData, stream.readBlock(5000));
+        },
+        [&](MPEG::File &f) {
+          const ID3v2::FrameList frames = f.ID3v2Tag()->frameListMap()["APIC"];
+          CPPUNIT_ASSERT_EQUAL(1U, frames.size());
+          auto frame = dynamic_cast<ID3v2::AttachedPictureFrame *>(frames.front());
+          CPPUNIT_ASSERT(!frame->isDataDeferred());
+          CPPUNIT_ASSERT_EQUAL(pictureData, frame->picture());
+        },
+        [version](MPEG::File &f) { f.save(MPEG::File::ID3v2, File::StripOthers, version); });
+      {
+        FileStream stream(newname.c_str());
+        stream.setReadBudget(2048);
+        MPEG::File f(&stream);
+        const ID3v2::FrameList frames = f.ID3v2Tag()->frameListMap()["APIC"];
+        auto frame = dynamic_cast<ID3v2::AttachedPictureFrame *>(frames.front());
+        CPPUNIT_ASSERT(frame->isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(String("Deferred"), f.ID3v2Tag()->title());
+        const offset_t position = stream.tell();
+        CPPUNIT_ASSERT_EQUAL(pictureData, frame->picture());
+        CPPUNIT_ASSERT(!frame->isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(position, stream.tell());
+      }
+    }
+  }
+
+  void testDeferredCompressedPicture()
+  {
+    if(!zlib::isAvailable())
+      return;
+
+    ByteVector pictureData;
+    {
+      MPEG::File f(TEST_FILE_PATH_C("compressed_id3_frame.mp3"), false);
+      const ID3v2::FrameList frames = f.ID3v2Tag()->frameListMap()["APIC"];
+      CPPUNIT_ASSERT_EQUAL(1U, frames.size());
+      pictureData = dynamic_cast<ID3v2::AttachedPictureFrame *>(frames.front())->picture();
+      CPPUNIT_ASSERT_EQUAL(86414U, pictureData.size());
+    }
+
+    FileStream stream(TEST_FILE_PATH_C("compressed_id3_frame.mp3"), true);
+    stream.setMaxPayloadSize(1024);
+    MPEG::File f(&stream, false);
+    const ID3v2::FrameList frames = f.ID3v2Tag()->frameListMap()["APIC"];
+    CPPUNIT_ASSERT_EQUAL(1U, frames.size());
+    auto frame = dynamic_cast<ID3v2::AttachedPictureFrame *>(frames.front());
+    CPPUNIT_ASSERT(frame);
+    CPPUNIT_ASSERT(frame->isDataDeferred());
+    CPPUNIT_ASSERT_EQUAL(String("image/bmp"), frame->mimeType());
+
+    // Streaming the data does not load it.
+    ByteVectorStream sink((ByteVector()));
+    CPPUNIT_ASSERT(frame->writePicture(&sink));
+    CPPUNIT_ASSERT_EQUAL(pictureData, *sink.data());
+    CPPUNIT_ASSERT(frame->isDataDeferred());
+
+    CPPUNIT_ASSERT_EQUAL(pictureData, frame->picture());
+    CPPUNIT_ASSERT(!frame->isDataDeferred());
+
+    // The data length indicator limits the decompressed data.
+    PlainFile file(TEST_FILE_PATH_C("compressed_id3_frame.mp3"));
+    ByteVector fileData = file.readAll();
+    CPPUNIT_ASSERT_EQUAL(86427U, ID3v2::SynchData::toUInt(fileData.mid(20, 4)));
+    const ByteVector decodedSize = ID3v2::SynchData::fromUInt(40000);
+    for(unsigned int i = 0; i < 4; ++i)
+      fileData[20 + i] = decodedSize[i];
+    ByteVectorStream truncatedStream(fileData);
+    truncatedStream.setMaxPayloadSize(1024);
+    MPEG::File truncated(&truncatedStream, false);
+    auto truncatedFrame = dynamic_cast<ID3v2::AttachedPictureFrame *>(
+      truncated.ID3v2Tag()->frameListMap()["APIC"].front());
+    CPPUNIT_ASSERT(truncatedFrame);
+    CPPUNIT_ASSERT(truncatedFrame->isDataDeferred());
+    ByteVectorStream truncatedSink((ByteVector()));
+    CPPUNIT_ASSERT(!truncatedFrame->writePicture(&truncatedSink));
+    // The fields in front of the picture take 13 bytes.
+    CPPUNIT_ASSERT_EQUAL(pictureData.mid(0, 40000 - 13), truncatedFrame->picture());
+  }
+
+  void testDeferredUnsynchronisedPicture()
+  {
+    ByteVector pictureData;
+    for(int i = 0; i < 5000; ++i)
+      pictureData.append(static_cast<char>(i % 3 == 0 ? 0xff : i % 3 == 1 ? 0x00 : i));
+
+    ByteVector fields("\x00image/png\x00\x03" "Cover\x00", 18);
+    ByteVector encoded;
+    for(const char c : fields + pictureData) {
+      encoded.append(c);
+      if(c == '\xff')
+        encoded.append('\x00');
+    }
+
+    PlainFile audio(TEST_FILE_PATH_C("xing.mp3"));
+    const ByteVector audioData = audio.readAll();
+
+    // Unsynchronisation of the frame and of the whole ID3v2.4 tag.
+    for(const bool tagUnsynchronised : {false, true}) {
+      ByteVector frame = ByteVector("APIC") + ID3v2::SynchData::fromUInt(encoded.size());
+      frame.append(ByteVector(tagUnsynchronised ? "\x00\x00" : "\x00\x02", 2));
+      frame.append(encoded);
+
+      ByteVector tag("ID3\x04\x00", 5);
+      tag.append(static_cast<char>(tagUnsynchronised ? 0x80 : 0x00));
+      tag.append(ID3v2::SynchData::fromUInt(frame.size()));
+      tag.append(frame);
+
+      ByteVector fileData = tag + audioData;
+      ByteVectorStream stream(fileData);
+      stream.setMaxPayloadSize(1024);
+      MPEG::File f(&stream, false);
+      const ID3v2::FrameList frames = f.ID3v2Tag()->frameListMap()["APIC"];
+      CPPUNIT_ASSERT_EQUAL(1U, frames.size());
+      auto picture = dynamic_cast<ID3v2::AttachedPictureFrame *>(frames.front());
+      CPPUNIT_ASSERT(picture);
+      CPPUNIT_ASSERT(picture->isDataDeferred());
+      CPPUNIT_ASSERT_EQUAL(String("image/png"), picture->mimeType());
+      CPPUNIT_ASSERT_EQUAL(String("Cover"), picture->description());
+
+      ByteVectorStream sink((ByteVector()));
+      CPPUNIT_ASSERT(picture->writePicture(&sink));
+      CPPUNIT_ASSERT_EQUAL(pictureData, *sink.data());
+      CPPUNIT_ASSERT_EQUAL(pictureData, picture->picture());
+    }
+  }
+
+  void testArena()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string newname = copy.fileName();
+
+    {
+      MPEG::File f(newname.c_str());
+      f.ID3v2Tag(true)->setTitle("Title");
+      f.ID3v2Tag()->setArtist("Artist");
+      for(int i = 0; i < 100; ++i) {
+        auto frame = new ID3v2::TextIdentificationFrame("TXXX");
+        frame->setText(StringList{"Key" + String::number(i), "Value"});
+        f.ID3v2Tag()->addFrame(frame);
+      }
+      f.save(MPEG::File::ID3v2, File::StripOthers);
+    }
+
+    String title;
+    ID3v2::Frame *detached = nullptr;
+    {
+      FileStream stream(newname.c_str());
+      stream.setArenaBlockSize(1);
+      CPPUNIT_ASSERT_EQUAL(4096U, stream.arenaBlockSize());
+      MPEG::File f(&stream);
+      CPPUNIT_ASSERT_EQUAL(String("Artist"), f.ID3v2Tag()->artist());
+      CPPUNIT_ASSERT_EQUAL(100U, f.ID3v2Tag()->frameListMap()["TXXX"].size());
+      title = f.ID3v2Tag()->title();
+
+      detached = f.ID3v2Tag()->frameListMap()["TPE1"].front();
+      f.ID3v2Tag()->removeFrame(detached, false);
+      f.ID3v2Tag()->removeFrames("TXXX");
+      f.ID3v2Tag()->setAlbum("Album");
+      f.save();
+    }
+
+    // Values and frames taken from the arena may outlive the file.
+    CPPUNIT_ASSERT_EQUAL(String("Title"), title);
+    CPPUNIT_ASSERT_EQUAL(String("Artist"), detached->toString());
+    delete detached;
+
+    {
+      MPEG::File f(newname.c_str());
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.ID3v2Tag()->title());
+      CPPUNIT_ASSERT_EQUAL(String("Album"), f.ID3v2Tag()->album());
+      CPPUNIT_ASSERT(f.ID3v2Tag()->artist().isEmpty());
+      CPPUNIT_ASSERT(f.ID3v2Tag()->frameListMap()["TXXX"].isEmpty());
+    }
+  }
+
+  void testLazyFrameParsing()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    string newname = copy.fileName();
+
+    const ByteVector pictureData(5000, 'x');
+    {
+      MPEG::File f(newname.c_str());
+      auto picture = new ID3v2::AttachedPictureFrame;
+      picture->setPicture(pictureData);
+      picture->setDescription("Front");
+      f.ID3v2Tag(true)->addFrame(picture);
+      f.ID3v2Tag()->setTitle("Title");
+      f.ID3v2Tag()->setArtist("Artist");
+      for(int i = 0; i < 10; ++i) {
+        auto frame = new ID3v2::TextIdentificationFrame("TXXX");
+        frame->setText(StringList{"Key" + String::number(i), "Value"});
+        f.ID3v2Tag()->addFrame(frame);
+      }
+      picture = new ID3v2::AttachedPictureFrame;
+      picture->setPicture(ByteVector(100, 'y'));
+      picture->setDescription("Back");
+      f.ID3v2Tag()->addFrame(picture);
+      f.save(MPEG::File::ID3v2, File::StripOthers);
+    }
+
+    ByteVector rendered;
+    ByteVectorList frameIDs;
+    {
+      MPEG::File f(newname.c_str());
+      rendered = f.ID3v2Tag()->render();
+      for(const auto &frame : f.ID3v2Tag()->frameList())
+        frameIDs.append(frame->frameID());
+    }
+
+    for(offset_t maxPayloadSize : {0, 1024}) {
+      FileStream stream(newname.c_str());
+      stream.setMaxPayloadSize(maxPayloadSize);
+      stream.setLazyFrameParsing(true);
+      CPPUNIT_ASSERT(stream.lazyFrameParsing());
+      MPEG::File f(&stream);
+      CPPUNIT_ASSERT_EQUAL(String("Artist"), f.ID3v2Tag()->artist());
+      CPPUNIT_ASSERT_EQUAL(1U, f.ID3v2Tag()->frameList("TPE1").size());
+
+      const ID3v2::FrameList pictures = f.ID3v2Tag()->frameList("APIC");
+      CPPUNIT_ASSERT_EQUAL(2U, pictures.size());
+      auto front = dynamic_cast<ID3v2::AttachedPictureFrame *>(pictures.front());
+      auto back = dynamic_cast<ID3v2::AttachedPictureFrame *>(pictures.back());
+      CPPUNIT_ASSERT(front);
+      CPPUNIT_ASSERT(back);
+      CPPUNIT_ASSERT_EQUAL(String("Front"), front->description());
+      CPPUNIT_ASSERT_EQUAL(maxPayloadSize > 0, front->isDataDeferred());
+      CPPUNIT_ASSERT_EQUAL(String("Back"), back->description());
+      CPPUNIT_ASSERT_EQUAL(pictureData, front->picture());
+
+      // The frames created later are inserted at their position in the tag.
+      CPPUNIT_ASSERT_EQUAL(String("Title"), f.ID3v2Tag()->title());
+      ByteVectorList lazyFrameIDs;
+      for(const auto &frame : f.ID3v2Tag()->frameList())
+        lazyFrameIDs.append(frame->frameID());
+      CPPUNIT_ASSERT_EQUAL(frameIDs, lazyFrameIDs);
+      CPPUNIT_ASSERT_EQUAL(pictures.front(), f.ID3v2Tag()->frameList()[0]);
+      const ID3v2::FrameList &userFrames = f.ID3v2Tag()->frameList("TXXX");
+      CPPUNIT_ASSERT_EQUAL(10U, userFrames.size());
+      for(unsigned int i = 0; i < userFrames.size(); ++i)
+        CPPUNIT_ASSERT_EQUAL(f.ID3v2Tag()->frameList()[i + 3], userFrames[i]);
+      CPPUNIT_ASSERT_EQUAL(rendered, f.ID3v2Tag()->render());
+    }
+
+    {
+      FileStream stream(newname.c_str());
+      stream.setLazyFrameParsing(true);
+      MPEG::File f(&stream);
+      f.ID3v2Tag()->setAlbum("Album");
+      f.ID3v2Tag()->removeFrames("TXXX");
+      f.save();
+    }
+    {
+      MPEG::File f(newname.c_str());
+      const ID3v2::FrameList &frames = f.ID3v2Tag()->frameList();
+      CPPUNIT_ASSERT_EQUAL(5U, frames.size());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("APIC"), frames[0]->frameID());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("TIT2"), frames[1]->frameID());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("TPE1"), frames[2]->frameID());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("APIC"), frames[3]->frameID());
+      CPPUNIT_ASSERT_EQUAL(ByteVector("TALB"), frames[4]->frameID());
+    }
+  }
+
+  void testLazyFrameParsingMatchesEager()
+  {
+    for(const auto &fileName : {
+          "rare_frames.mp3", "invalid-frames1.mp3", "invalid-frames2.mp3",
+          "invalid-frames3.mp3", "compressed_id3_frame.mp3", "extended-header.mp3",
+          "toc_many_children.mp3", "w000.mp3", "itunes10.mp3", "duplicate_id3v2.mp3",
+          "unsynch24.id3"}) {
+      MPEG::File eager(TEST_FILE_PATH_C(fileName), false);
+      FileStream stream(TEST_FILE_PATH_C(fileName), true);
+      stream.setLazyFrameParsing(true);
+      MPEG::File lazy(&stream, false);
+      CPPUNIT_ASSERT_EQUAL(eager.hasID3v2Tag(), lazy.hasID3v2Tag());
+      if(!eager.hasID3v2Tag())
+        continue;
+
+      CPPUNIT_ASSERT_EQUAL(eager.ID3v2Tag()->header()->unsynchronisation(),
+                           lazy.ID3v2Tag()->header()->unsynchronisation());
+      CPPUNIT_ASSERT_EQUAL(eager.ID3v2Tag()->title(), lazy.ID3v2Tag()->title());
+      CPPUNIT_ASSERT_EQUAL(eager.ID3v2Tag()->frameList().size(),
+                           lazy.ID3v2Tag()->frameList().size());
+      CPPUNIT_ASSERT(eager.ID3v2Tag()->properties() == lazy.ID3v2Tag()->properties());
+      CPPUNIT_ASSERT_EQUAL(eager.ID3v2Tag()->render(), lazy.ID3v2Tag()->render());
+    }
+
+    // The frames of an unsynchronised ID3v2.4 tag are decoded when they are
+    // created.
+    ByteVector tag("ID3\x04\x00\x80\x00\x00\x00\x13"
+                   "TIT2\x00\x00\x00\x09\x00\x00\x01\xff\x00\xfeH\x00i\x00", 29);
+    ByteVectorStream stream(tag);
+    stream.setLazyFrameParsing(true);
+    MPEG::File f(&stream, false);
+    CPPUNIT_ASSERT(f.ID3v2Tag()->header()->unsynchronisation());
+    CPPUNIT_ASSERT_EQUAL(String("Hi"), f.ID3v2Tag()->title());
+  }
+
+
+  void testRenderUnmodifiedFrames()
+  {
+    // A picture with a big-endian description, which TagLib would render
+    // little-endian, and a private frame.
+    const ByteVector apic = ByteVector("APIC\x00\x00\x00\x19\x00\x00", 10) +
+      ByteVector("\x01image/png\x00\x03\xfe\xff\x00" "A\x00\x00" "PNGDATA", 25);
+    const ByteVector priv = ByteVector("PRIV\x00\x00\x00\x08\x00\x00", 10) +
+      ByteVector("owner\x00\x01\x02", 8);
+    const ByteVector tit2 = ByteVector("TIT2\x00\x00\x00\x06\x00\x00", 10) +
+      ByteVector("\x00Title", 6);
+    const ByteVector frames = apic + priv + tit2;
+    ByteVector tagData("ID3\x04\x00\x00", 6);
+    tagData.append(ID3v2::SynchData::fromUInt(frames.size() + 100));
+    tagData.append(frames);
+    tagData.append(ByteVector(100, '\0'));
+
+    // A factory of its own, so that a default text encoding set on the
+    // shared instance does not convert the frames.
+    class PlainFrameFactory : public ID3v2::FrameFactory {};
+    PlainFrameFactory factory;
+
+    ByteVectorStream stream(tagData);
+    MPEG::File f(&stream, false, MPEG::Properties::Average, &factory);
+    ID3v2::Tag *tag = f.ID3v2Tag();
+    auto picture = dynamic_cast<ID3v2::AttachedPictureFrame *>(tag->frameList("APIC").front());
+    CPPUNIT_ASSERT(picture);
+    CPPUNIT_ASSERT_EQUAL(String("A"), picture->description());
+
+    // The unmodified frames are written as they were read.
+    tag->setTitle("Another title");
+    ByteVector rendered = tag->render();
+    CPPUNIT_ASSERT_EQUAL(10, rendered.find(apic));
+    CPPUNIT_ASSERT_EQUAL(45, rendered.find(priv));
+    CPPUNIT_ASSERT_EQUAL(-1, rendered.find(tit2));
+
+    // Converting to ID3v2.3 renders them again.
+    rendered = tag->render(ID3v2::v3);
+    CPPUNIT_ASSERT_EQUAL(-1, rendered.find(apic));
+    CPPUNIT_ASSERT(rendered.find(priv.mid(10)) > 0);
+
+    // So does modifying them.
+    picture->setType(ID3v2::AttachedPictureFrame::BackCover);
+    rendered = tag->render();
+    CPPUNIT_ASSERT_EQUAL(-1, rendered.find(apic));
+    CPPUNIT_ASSERT(rendered.find(ByteVector("\x01image/png\x00\x04\xff\xfe" "A\x00\x00\x00" "PNGDATA", 25)) > 0);
+    CPPUNIT_ASSERT_EQUAL(45, rendered.find(priv));
+  }
+
+
+  void testFrameListLookup()
+  {
+    ID3v2::Tag tag;
+    tag.setTitle("Title");
+    const ID3v2::FrameList &titles = tag.frameList("TIT2");
+
+    // Looking up a missing frame ID must neither add it to the map nor
+    // invalidate the lists returned before.
+    CPPUNIT_ASSERT(tag.frameList("AAAX").isEmpty());
+    CPPUNIT_ASSERT(!tag.frameListMap().contains("AAAX"));
+    CPPUNIT_ASSERT_EQUAL(1U, titles.size());
+
+    tag.setArtist("Artist");
+    tag.setAlbum("Album");
+    CPPUNIT_ASSERT_EQUAL(1U, titles.size());
+    CPPUNIT_ASSERT_EQUAL(String("Title"), titles.front()->toString());
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestID3v2);
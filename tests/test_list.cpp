@@ -23,7 +23,10 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <utility>
+
 #include "tlist.h"
+#include "tstring.h"
 #include <cppunit/extensions/HelperMacros.h>
 
 using namespace std;
@@ -36,6 +39,7 @@ class TestList : public CppUnit::TestFixture
   CPPUNIT_TEST(testDetach);
   CPPUNIT_TEST(bracedInit);
   CPPUNIT_TEST(testSort);
+  CPPUNIT_TEST(testAppendSelf);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -163,6 +167,39 @@ public:
     CPPUNIT_ASSERT_EQUAL(list2[0], 3);
     CPPUNIT_ASSERT_EQUAL(list2[1], 2);
     CPPUNIT_ASSERT_EQUAL(list2[2], 1);
+
+    // Equal items keep their order.
+    List<std::pair<int, int>> list3 {
+      {2, 0},
+      {1, 1},
+      {2, 2},
+      {1, 3}
+    };
+    list3.sort([](const auto &a, const auto &b) { return a.first < b.first; });
+    CPPUNIT_ASSERT_EQUAL(list3[0].second, 1);
+    CPPUNIT_ASSERT_EQUAL(list3[1].second, 3);
+    CPPUNIT_ASSERT_EQUAL(list3[2].second, 0);
+    CPPUNIT_ASSERT_EQUAL(list3[3].second, 2);
+  }
+
+  void testAppendSelf()
+  {
+    List<String> l1 {"a", "b"};
+    l1.append(l1);
+    CPPUNIT_ASSERT_EQUAL(4U, l1.size());
+    CPPUNIT_ASSERT_EQUAL(String("b"), l1[3]);
+
+    List<String> l2 {"a", "b"};
+    l2.prepend(l2);
+    CPPUNIT_ASSERT_EQUAL(4U, l2.size());
+    CPPUNIT_ASSERT_EQUAL(String("a"), l2[2]);
+
+    // Appending an item of the list itself.
+    List<String> l3 {"a"};
+    for(int i = 0; i < 20; ++i)
+      l3.append(l3.front());
+    CPPUNIT_ASSERT_EQUAL(21U, l3.size());
+    CPPUNIT_ASSERT_EQUAL(String("a"), l3.back());
   }
 
 };
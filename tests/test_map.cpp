@@ -25,6 +25,7 @@
 
 #include "tstring.h"
 #include "tmap.h"
+#include "tstringlist.h"
 #include <cppunit/extensions/HelperMacros.h>
 
 using namespace std;
@@ -36,6 +37,8 @@ class TestMap : public CppUnit::TestFixture
   CPPUNIT_TEST(testInsert);
   CPPUNIT_TEST(testDetach);
   CPPUNIT_TEST(testBracedInit);
+  CPPUNIT_TEST(testOrder);
+  CPPUNIT_TEST(testStableReferences);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -89,6 +92,53 @@ public:
     CPPUNIT_ASSERT(m2.contains("FOUR") && m2["FOUR"] == 4);
     CPPUNIT_ASSERT(m2.contains("FIVE") && m2["FIVE"] == 5);
     CPPUNIT_ASSERT(m2.contains("SIX") && m2["SIX"] == 6);
+
+    Map<String, int> m3 {
+      {"ONE", 1},
+      {"ONE", 2}
+    };
+    CPPUNIT_ASSERT_EQUAL(1U, m3.size());
+    CPPUNIT_ASSERT_EQUAL(1, m3["ONE"]);
+  }
+
+  void testOrder()
+  {
+    Map<String, String> m1;
+    m1.insert("carol", "c");
+    m1.insert("alice", "a");
+    m1.insert("bob", "b");
+    m1.insert("dave", m1["alice"]);
+    m1.erase("bob");
+    m1.erase("eve");
+    CPPUNIT_ASSERT_EQUAL(3U, m1.size());
+
+    auto it = m1.cbegin();
+    CPPUNIT_ASSERT_EQUAL(String("alice"), it->first);
+    CPPUNIT_ASSERT_EQUAL(String("carol"), (++it)->first);
+    CPPUNIT_ASSERT_EQUAL(String("dave"), (++it)->first);
+    CPPUNIT_ASSERT_EQUAL(String("a"), it->second);
+    CPPUNIT_ASSERT(++it == m1.cend());
+  }
+
+  void testStableReferences()
+  {
+    Map<String, StringList> m1;
+    const StringList &values = m1["middle"];
+    const StringList *address = &values;
+    for(int i = 0; i < 100; ++i) {
+      m1.insert(String::number(i), StringList("x"));
+      m1["~" + String::number(i)].append("y");
+    }
+    m1.erase("0");
+    CPPUNIT_ASSERT_EQUAL(200U, m1.size());
+    CPPUNIT_ASSERT(values.isEmpty());
+    m1["middle"].append("value");
+    CPPUNIT_ASSERT(address == &m1["middle"]);
+    CPPUNIT_ASSERT_EQUAL(String("value"), values.front());
+
+    Map<String, StringList>::ConstIterator it = m1.find("middle");
+    CPPUNIT_ASSERT(it != m1.end());
+    CPPUNIT_ASSERT(address == &it->second);
   }
 
 };
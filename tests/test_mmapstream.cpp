@@ -0,0 +1,160 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License version   *
+ *   2.1 as published by the Free Software Foundation.                     *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful, but   *
+ *   WITHOUT ANY WARRANTY; without even the implied warranty of            *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU Lesser General Public      *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA         *
+ *   02110-1301  USA                                                       *
+ *                                                                         *
+ *   Alternatively, this file is available under the Mozilla Public        *
+ *   License Version 1.1.  You may obtain a copy of the License at         *
+ *   http://www.mozilla.org/MPL/                                           *
+ ***************************************************************************/
+
+#include "tmmapstream.h"
+#include "tfilestream.h"
+#include "tpropertymap.h"
+#include "tag.h"
+#include "fileref.h"
+#include "mpegfile.h"
+#include <cppunit/extensions/HelperMacros.h>
+#include "utils.h"
+
+using namespace std;
+using namespace TagLib;
+
+class TestMmapStream : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TestMmapStream);
+  CPPUNIT_TEST(testReadBlock);
+  CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testReadView);
+  CPPUNIT_TEST(testReadOnly);
+  CPPUNIT_TEST(testEmptyFile);
+  CPPUNIT_TEST(testMissingFile);
+  CPPUNIT_TEST(testFileRef);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void testReadBlock()
+  {
+    MmapStream stream(TEST_FILE_PATH_C("xing.mp3"));
+    FileStream reference(TEST_FILE_PATH_C("xing.mp3"), true);
+    CPPUNIT_ASSERT(stream.isOpen());
+    CPPUNIT_ASSERT_EQUAL(reference.length(), stream.length());
+
+    CPPUNIT_ASSERT_EQUAL(reference.readBlock(4), stream.readBlock(4));
+    CPPUNIT_ASSERT_EQUAL(reference.readBlock(1000), stream.readBlock(1000));
+    CPPUNIT_ASSERT_EQUAL(reference.tell(), stream.tell());
+
+    stream.seek(-10, IOStream::End);
+    reference.seek(-10, IOStream::End);
+    CPPUNIT_ASSERT_EQUAL(reference.readBlock(100), stream.readBlock(100));
+    CPPUNIT_ASSERT_EQUAL(stream.length(), stream.tell());
+    CPPUNIT_ASSERT(stream.readBlock(10).isEmpty());
+  }
+
+  void testSeek()
+  {
+    MmapStream stream(TEST_FILE_PATH_C("xing.mp3"));
+    FileStream reference(TEST_FILE_PATH_C("xing.mp3"), true);
+
+    stream.seek(100);
+    reference.seek(100);
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(100), stream.tell());
+    stream.seek(20, IOStream::Current);
+    reference.seek(20, IOStream::Current);
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(120), stream.tell());
+    CPPUNIT_ASSERT_EQUAL(reference.readBlock(8), stream.readBlock(8));
+
+    stream.seek(stream.length() + 10);
+    CPPUNIT_ASSERT(stream.readBlock(1).isEmpty());
+  }
+
+  void testReadView()
+  {
+    MmapStream stream(TEST_FILE_PATH_C("xing.mp3"));
+    const ByteVector block = stream.readBlock(2000);
+
+    stream.seek(0);
+    CPPUNIT_ASSERT_EQUAL(block.mid(0, 4), stream.readView(4));
+    CPPUNIT_ASSERT_EQUAL(block.mid(4, 10), stream.readView(10));
+    stream.seek(1020);
+    CPPUNIT_ASSERT_EQUAL(block.mid(1020, 8), stream.readView(8));
+    CPPUNIT_ASSERT_EQUAL(block.mid(1028, 972), stream.readView(972));
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(2000), stream.tell());
+    stream.seek(1500);
+    CPPUNIT_ASSERT_EQUAL(block.mid(1500, 100), stream.readView(100));
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(1600), stream.tell());
+
+    stream.seek(-3, IOStream::End);
+    CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(3), stream.readView(8).size());
+    CPPUNIT_ASSERT(stream.readView(8).isEmpty());
+  }
+
+  void testReadOnly()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    const ByteVector original = FileStream(copy.fileName().c_str(), true).readBlock(16);
+
+    MmapStream stream(copy.fileName().c_str());
+    CPPUNIT_ASSERT(stream.readOnly());
+    stream.writeBlock("abcd");
+    stream.insert("abcd", 0, 0);
+    stream.removeBlock(0, 4);
+    stream.truncate(10);
+    CPPUNIT_ASSERT_EQUAL(original, stream.readBlock(16));
+
+    MPEG::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT(f.readOnly());
+    CPPUNIT_ASSERT(!f.save());
+  }
+
+  void testEmptyFile()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+    {
+      FileStream file(copy.fileName().c_str());
+      file.truncate(0);
+    }
+
+    MmapStream stream(copy.fileName().c_str());
+    CPPUNIT_ASSERT(stream.isOpen());
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(0), stream.length());
+    CPPUNIT_ASSERT(stream.readBlock(10).isEmpty());
+  }
+
+  void testMissingFile()
+  {
+    MmapStream stream("does-not-exist.mp3");
+    CPPUNIT_ASSERT(!stream.isOpen());
+    CPPUNIT_ASSERT(stream.readBlock(10).isEmpty());
+  }
+
+  void testFileRef()
+  {
+    FileRef ref(TEST_FILE_PATH_C("xing.mp3"));
+    FileRef mmapRef(TEST_FILE_PATH_C("xing.mp3"), true, AudioProperties::Average,
+                    FileRef::StreamType::Mmap);
+    CPPUNIT_ASSERT(!mmapRef.isNull());
+    CPPUNIT_ASSERT(dynamic_cast<MPEG::File *>(mmapRef.file()));
+    CPPUNIT_ASSERT(mmapRef.file()->readOnly());
+    CPPUNIT_ASSERT_EQUAL(ref.audioProperties()->lengthInMilliseconds(),
+                         mmapRef.audioProperties()->lengthInMilliseconds());
+    CPPUNIT_ASSERT_EQUAL(ref.audioProperties()->bitrate(),
+                         mmapRef.audioProperties()->bitrate());
+    CPPUNIT_ASSERT(ref.properties() == mmapRef.properties());
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestMmapStream);
@@ -28,6 +28,7 @@
 
 #include "tbytevectorlist.h"
 #include "tbytevectorstream.h"
+#include "tfilestream.h"
 #include "tpropertymap.h"
 #include "tag.h"
 #include "mp4tag.h"
@@ -146,6 +147,7 @@ class TestMP4 : public CppUnit::TestFixture
   CPPUNIT_TEST(testGnre);
   CPPUNIT_TEST(testCovrRead);
   CPPUNIT_TEST(testCovrWrite);
+  CPPUNIT_TEST(testCovrDeferred);
   CPPUNIT_TEST(testCovrRead2);
   CPPUNIT_TEST(testProperties);
   CPPUNIT_TEST(testPropertiesAllSupported);
@@ -563,6 +565,59 @@ public:
     }
   }
 
+  void testCovrDeferred()
+  {
+    ScopedFileCopy copy("has-tags", ".m4a");
+    string filename = copy.fileName();
+
+    ByteVector pngData, jpegData;
+    {
+      MP4::File f(filename.c_str());
+      MP4::CoverArtList l = f.tag()->item("covr").toCoverArtList();
+      pngData = l[0].data();
+      jpegData = l[1].data();
+    }
+    saveWithDeferredPayloads<MP4::File>(filename, 100,
+      [&](MP4::File &f, FileStream &stream) {
+        MP4::CoverArtList l = f.tag()->item("covr").toCoverArtList();
+        CPPUNIT_ASSERT_EQUAL(2U, l.size());
+        CPPUNIT_ASSERT(l[0].isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(MP4::CoverArt::PNG, l[0].format());
+        CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(79), l[0].deferredDataSize());
+        CPPUNIT_ASSERT(l[1].isDataDeferred());
+        CPPUNIT_ASSERT_EQUAL(MP4::CoverArt::JPEG, l[1].format());
+        CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(287), l[1].deferredDataSize());
+
+        stream.seek(l[1].deferredDataOffset());
+        CPPUNIT_ASSERT_EQUAL(jpegData, stream.readBlock(287));
+
+        ByteVectorStream sink((ByteVector()));
+        CPPUNIT_ASSERT(l[1].writeData(&sink));
+        CPPUNIT_ASSERT_EQUAL(jpegData, *sink.data());
+        CPPUNIT_ASSERT(l[1].isDataDeferred());
+      },
+      [&](MP4::File &f) {
+        MP4::CoverArtList l = f.tag()->item("covr").toCoverArtList();
+        CPPUNIT_ASSERT_EQUAL(2U, l.size());
+        CPPUNIT_ASSERT_EQUAL(pngData, l[0].data());
+        CPPUNIT_ASSERT_EQUAL(jpegData, l[1].data());
+      },
+      [](MP4::File &f) { f.save(); });
+    MP4::CoverArtList l;
+    {
+      FileStream stream(filename.c_str());
+      stream.setMaxPayloadSize(100);
+      MP4::File f(&stream);
+      l = f.tag()->item("covr").toCoverArtList();
+      CPPUNIT_ASSERT_EQUAL(jpegData, l[1].data());
+      CPPUNIT_ASSERT(!l[1].isDataDeferred());
+    }
+    // The data which was not requested cannot be read without the file.
+    CPPUNIT_ASSERT(l[0].isDataDeferred());
+    CPPUNIT_ASSERT(l[0].data().isEmpty());
+    CPPUNIT_ASSERT_EQUAL(jpegData, l[1].data());
+  }
+
   void testCovrRead2()
   {
     MP4::File f(TEST_FILE_PATH_C("covr-junk.m4a"));
@@ -40,7 +40,9 @@
 #include "xingheader.h"
 #include "mpegheader.h"
 #include "id3v2extendedheader.h"
+#include "tbytevectorstream.h"
 #include <cppunit/extensions/HelperMacros.h>
+#include "plainfile.h"
 #include "utils.h"
 
 using namespace std;
@@ -63,6 +65,8 @@ class TestMPEG : public CppUnit::TestFixture
   CPPUNIT_TEST(testDuplicateID3v2);
   CPPUNIT_TEST(testFuzzedFile);
   CPPUNIT_TEST(testFrameOffset);
+  CPPUNIT_TEST(testFrameOffsetAfterJunk);
+  CPPUNIT_TEST(testFrameIndex);
   CPPUNIT_TEST(testStripAndProperties);
   CPPUNIT_TEST(testProperties);
   CPPUNIT_TEST(testRepeatedSave1);
@@ -72,6 +76,8 @@ class TestMPEG : public CppUnit::TestFixture
   CPPUNIT_TEST(testEmptyID3v1);
 #ifdef TAGLIB_WITH_APE
   CPPUNIT_TEST(testEmptyAPE);
+  CPPUNIT_TEST(testSaveAPEThenStripID3v1);
+  CPPUNIT_TEST(testSaveAtomically);
 #endif
   CPPUNIT_TEST(testIgnoreGarbage);
   CPPUNIT_TEST(testExtendedHeader);
@@ -151,7 +157,10 @@ public:
       CPPUNIT_ASSERT(f.audioProperties());
       CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 : 1,
         f.audioProperties()->lengthInSeconds());
-      CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 : 1176,
+      // The accurate length is counted from the frames, the average one is
+      // estimated from the bitrate.
+      CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 :
+                           readStyle == MPEG::Properties::Average ? 1176 : 1115,
         f.audioProperties()->lengthInMilliseconds());
       CPPUNIT_ASSERT_EQUAL(readStyle == MPEG::Properties::Fast ? 0 : 1,
         f.audioProperties()->bitrate());
@@ -302,6 +311,102 @@ public:
     }
   }
 
+  void testFrameOffsetAfterJunk()
+  {
+    // Junk full of frame sync candidates with reserved header values, which
+    // spans several scan buffers.
+
+    ByteVector data;
+    for(int i = 0; i < 20000; ++i) {
+      data.append(ByteVector("\xFF\xFB\xF0\x00", 4));  // bitrate index 15
+      data.append(ByteVector("\xFF\xEA\x90\x00", 4));  // MPEG version 1 reserved
+      data.append(ByteVector("\xFF\xFF\xFF", 3));
+    }
+    const auto junkLength = static_cast<offset_t>(data.size());
+
+    data.append(PlainFile(TEST_FILE_PATH_C("ape.mp3")).readAll());
+
+    ByteVectorStream stream(data);
+    MPEG::File f(&stream);
+    CPPUNIT_ASSERT(f.isValid());
+    CPPUNIT_ASSERT_EQUAL(junkLength, f.firstFrameOffset());
+    CPPUNIT_ASSERT_EQUAL(junkLength + 0x1FD6, f.lastFrameOffset());
+    CPPUNIT_ASSERT_EQUAL(junkLength, f.nextFrameOffset(0));
+    CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(-1), f.previousFrameOffset(junkLength));
+  }
+
+  void testFrameIndex()
+  {
+    ScopedFileCopy copy("bladeenc", ".mp3");
+
+    {
+      MPEG::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT(!f.frameIndex());
+    }
+    {
+      MPEG::File f(copy.fileName().c_str(), true, MPEG::Properties::Accurate);
+      CPPUNIT_ASSERT_EQUAL(3553, f.audioProperties()->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(64, f.audioProperties()->bitrate());
+
+      const MPEG::FrameIndex *index = f.frameIndex();
+      CPPUNIT_ASSERT(index);
+      CPPUNIT_ASSERT_EQUAL(136ULL, index->frameCount());
+      CPPUNIT_ASSERT_EQUAL(156672ULL, index->sampleCount());
+      CPPUNIT_ASSERT_EQUAL(44100, index->sampleRate());
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(28422), index->streamLength());
+      CPPUNIT_ASSERT_EQUAL(3553, index->lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(1U, index->bitrateHistogram().size());
+      CPPUNIT_ASSERT_EQUAL(136U, index->bitrateHistogram()[64]);
+      CPPUNIT_ASSERT_EQUAL(38U, index->framesPerSeekPoint());
+      CPPUNIT_ASSERT_EQUAL(4U, index->seekPointCount());
+      CPPUNIT_ASSERT_EQUAL(f.firstFrameOffset(), index->seekPoint(0).offset);
+
+      index = f.buildFrameIndex(10);
+      CPPUNIT_ASSERT_EQUAL(10U, index->framesPerSeekPoint());
+      CPPUNIT_ASSERT_EQUAL(14U, index->seekPointCount());
+      CPPUNIT_ASSERT_EQUAL(136ULL, index->frameCount());
+
+      MPEG::FrameIndex::SeekPoint point = index->findSeekPoint(0);
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(0), point.offset);
+      CPPUNIT_ASSERT_EQUAL(0ULL, point.sample);
+      point = index->findSeekPoint(11519);
+      CPPUNIT_ASSERT_EQUAL(0ULL, point.sample);
+      point = index->findSeekPoint(11520);
+      CPPUNIT_ASSERT_EQUAL(11520ULL, point.sample);
+      CPPUNIT_ASSERT_EQUAL(static_cast<offset_t>(2090), point.offset);
+      point = index->findSeekPoint(1000000);
+      CPPUNIT_ASSERT_EQUAL(149760ULL, point.sample);
+
+      const ByteVector data = index->render();
+      const MPEG::FrameIndex parsed = MPEG::FrameIndex::parse(data);
+      CPPUNIT_ASSERT_EQUAL(data, parsed.render());
+      CPPUNIT_ASSERT_EQUAL(136ULL, parsed.frameCount());
+      CPPUNIT_ASSERT_EQUAL(14U, parsed.seekPointCount());
+      CPPUNIT_ASSERT(MPEG::FrameIndex::parse(data.mid(0, data.size() - 1)).isEmpty());
+      CPPUNIT_ASSERT(MPEG::FrameIndex::parse(ByteVector("TLFI")).isEmpty());
+
+      // A length or bitrate which does not fit into int is rejected.
+      ByteVector corrupted = data.mid(0, 17) + ByteVector::fromULongLong(1ULL << 60) +
+                             data.mid(25);
+      CPPUNIT_ASSERT_EQUAL(0, MPEG::FrameIndex::parse(corrupted).lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(0, MPEG::FrameIndex::parse(corrupted).bitrate());
+      corrupted = data.mid(0, 29) + ByteVector::fromLongLong(1LL << 60) + data.mid(37);
+      CPPUNIT_ASSERT_EQUAL(3553, MPEG::FrameIndex::parse(corrupted).lengthInMilliseconds());
+      CPPUNIT_ASSERT_EQUAL(0, MPEG::FrameIndex::parse(corrupted).bitrate());
+
+      f.setFrameIndex(MPEG::FrameIndex());
+      CPPUNIT_ASSERT(!f.frameIndex());
+      f.setFrameIndex(parsed);
+      CPPUNIT_ASSERT(f.frameIndex());
+
+      // Saving may move the audio data.
+
+      f.ID3v2Tag(true)->setTitle("Title");
+      f.save();
+      CPPUNIT_ASSERT(!f.frameIndex());
+    }
+  }
+
   void testStripAndProperties()
   {
     ScopedFileCopy copy("xing", ".mp3");
@@ -554,6 +659,62 @@ public:
       CPPUNIT_ASSERT(!f.hasAPETag());
     }
   }
+
+  void testSaveAPEThenStripID3v1()
+  {
+    ScopedFileCopy copy("xing", ".mp3");
+
+    {
+      MPEG::File f(copy.fileName().c_str());
+      f.ID3v1Tag(true)->setTitle("ID3v1");
+      f.save(MPEG::File::ID3v1);
+    }
+    {
+      // The new APE tag is inserted in front of the ID3v1 tag, which must
+      // still be found there when it is stripped afterwards.
+
+      MPEG::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT(f.hasID3v1Tag());
+      f.APETag(true)->setTitle("APE");
+      f.save(MPEG::File::APE, File::StripNone);
+      f.strip(MPEG::File::ID3v1);
+    }
+    {
+      MPEG::File f(copy.fileName().c_str());
+      CPPUNIT_ASSERT(!f.hasID3v1Tag());
+      CPPUNIT_ASSERT(f.hasAPETag());
+      CPPUNIT_ASSERT_EQUAL(String("APE"), f.APETag()->title());
+    }
+  }
+
+  void testSaveAtomically()
+  {
+    // All three tags are written by a single plan, which is recorded by the
+    // stream and written to the new file in one pass.
+
+    ScopedFileCopy copy1("ape-id3v1", ".mp3");
+    ScopedFileCopy copy2("ape-id3v1", ".mp3");
+
+    const auto modify = [](MPEG::File &f) {
+      f.ID3v2Tag(true)->setTitle(String(std::string(5000, 'x')));
+      f.APETag(true)->setTitle(String(std::string(300, 'y')));
+      f.ID3v1Tag(true)->setTitle("ID3v1");
+    };
+    {
+      MPEG::File f(copy1.fileName().c_str());
+      modify(f);
+      CPPUNIT_ASSERT(f.save());
+    }
+    {
+      MPEG::File f(copy2.fileName().c_str());
+      modify(f);
+      CPPUNIT_ASSERT(f.saveAtomically());
+      CPPUNIT_ASSERT_EQUAL(String(std::string(300, 'y')), f.APETag()->title());
+    }
+
+    const ByteVector expected = PlainFile(copy1.fileName().c_str()).readAll();
+    CPPUNIT_ASSERT_EQUAL(expected, PlainFile(copy2.fileName().c_str()).readAll());
+  }
 #endif
 
   void testIgnoreGarbage()
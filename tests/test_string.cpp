@@ -58,6 +58,9 @@ class TestString : public CppUnit::TestFixture
   CPPUNIT_TEST(testIterator);
   CPPUNIT_TEST(testInvalidUTF8);
   CPPUNIT_TEST(testEmpty);
+  CPPUNIT_TEST(testDefaultConstructedDetach);
+  CPPUNIT_TEST(testUTF8Storage);
+  CPPUNIT_TEST(testLongText);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -448,6 +451,125 @@ public:
     CPPUNIT_ASSERT_EQUAL(empty + static_cast<const char *>(nullptr), empty);
   }
 
+  void testDefaultConstructedDetach()
+  {
+    // Default constructed strings share their data until they are modified.
+    String s1;
+    String s2;
+    s1 += "abc";
+    s2.append(String("def"));
+    CPPUNIT_ASSERT_EQUAL(String("abc"), s1);
+    CPPUNIT_ASSERT_EQUAL(String("def"), s2);
+    CPPUNIT_ASSERT(String().isEmpty());
+    CPPUNIT_ASSERT_EQUAL(String("ABC"), s1.upper());
+    CPPUNIT_ASSERT(String().upper().isEmpty());
+    CPPUNIT_ASSERT_EQUAL(std::string("abc"), std::string(s1.toCString()));
+    CPPUNIT_ASSERT_EQUAL(std::string(), std::string(String().toCString(true)));
+  }
+
+  void testUTF8Storage()
+  {
+    // "\xc3\xa9", U+E000 and U+1F600 take 1, 1 and 2 UTF-16 code units.
+    const ByteVector utf8("a\xc3\xa9\xee\x80\x80\xf0\x9f\x98\x80");
+    const String s1(utf8, String::UTF8);
+    const String s2(s1.toWString());
+    CPPUNIT_ASSERT_EQUAL(5U, String(utf8, String::UTF8).size());
+    CPPUNIT_ASSERT_EQUAL(utf8, String(utf8, String::UTF8).data(String::UTF8));
+    CPPUNIT_ASSERT_EQUAL(std::string(utf8.data(), utf8.size()),
+                         std::string(String(utf8, String::UTF8).toCString(true)));
+    CPPUNIT_ASSERT_EQUAL(s1, s2);
+    CPPUNIT_ASSERT_EQUAL(s2, s1);
+    CPPUNIT_ASSERT_EQUAL(utf8, s2.data(String::UTF8));
+    CPPUNIT_ASSERT_EQUAL(static_cast<wchar_t>(0xe9), s1[1]);
+
+    // UTF-8 and UTF-16 strings are ordered by their UTF-16 code units.
+    const String bmp(ByteVector("\xee\x80\x80"), String::UTF8);
+    const String nonBmp(ByteVector("\xf0\x9f\x98\x80"), String::UTF8);
+    CPPUNIT_ASSERT(nonBmp < bmp);
+    CPPUNIT_ASSERT(String(nonBmp.toWString()) < bmp);
+    CPPUNIT_ASSERT(nonBmp < String(bmp.toWString()));
+    CPPUNIT_ASSERT(!(bmp < String(nonBmp.toWString())));
+    CPPUNIT_ASSERT(String("ab") < s1 && !(s1 < String("ab")));
+
+    String s3(s1);
+    s3 += "bc";
+    s3 += String(L"d");
+    s3.append(String("\xc3\xa9", String::UTF8));
+    CPPUNIT_ASSERT_EQUAL(9U, s3.size());
+    CPPUNIT_ASSERT_EQUAL(String(utf8, String::UTF8), s1);
+    CPPUNIT_ASSERT_EQUAL(String(s2.toWString() + L"bcd\x00e9"), s3);
+    CPPUNIT_ASSERT_EQUAL(5, s3.find("bc"));
+
+    String s4(" abc \t", String::UTF8);
+    CPPUNIT_ASSERT_EQUAL(String("abc"), s4.stripWhiteSpace());
+    CPPUNIT_ASSERT_EQUAL(String("bc"), s4.substr(2, 2));
+    CPPUNIT_ASSERT(s4 == " abc \t");
+    s4[1] = L'x';
+    CPPUNIT_ASSERT_EQUAL(String(" xbc \t"), s4);
+    CPPUNIT_ASSERT(String("\xe9") == "\xe9");
+    CPPUNIT_ASSERT(String("\xc3\xa9", String::UTF8) == "\xe9");
+    CPPUNIT_ASSERT(String("\xc3\xa9", String::UTF8).isLatin1());
+    CPPUNIT_ASSERT(!String("\xc3\xa9", String::UTF8).isAscii());
+  }
+
+  void testLongText()
+  {
+    // Long enough for the vectorized conversions, with non-ASCII characters
+    // at random positions.
+
+    unsigned int seed = 12345;
+    const auto next = [&seed] {
+      seed = seed * 1103515245 + 12345;
+      return (seed >> 16) & 0x7fff;
+    };
+
+    for(int round = 0; round < 200; ++round) {
+      std::string utf8;
+      std::string latin1;
+      std::wstring utf16;
+      const unsigned int length = next() % 100;
+      const unsigned int rarity = 1 + next() % 40;
+      for(unsigned int i = 0; i < length; ++i) {
+        if(next() % rarity != 0) {
+          const char c = static_cast<char>(' ' + next() % 95);
+          utf8 += c;
+          latin1 += c;
+          utf16 += static_cast<wchar_t>(c);
+        }
+        else if(next() % 3 == 0) {
+          utf8 += "\xc3\xa9";
+          latin1 += '\xe9';
+          utf16 += static_cast<wchar_t>(0xe9);
+        }
+        else if(next() % 2 == 0) {
+          utf8 += "\xe2\x82\xac";
+          utf16 += static_cast<wchar_t>(0x20ac);
+        }
+        else {
+          utf8 += "\xf0\x9f\x98\x80";
+          utf16 += static_cast<wchar_t>(0xd83d);
+          utf16 += static_cast<wchar_t>(0xde00);
+        }
+      }
+
+      const ByteVector utf8Data(utf8.data(), static_cast<unsigned int>(utf8.size()));
+      CPPUNIT_ASSERT(utf16 == String(utf8Data, String::UTF8).toWString());
+      CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(utf16.size()),
+                           String(utf8Data, String::UTF8).size());
+      CPPUNIT_ASSERT_EQUAL(utf8Data, String(utf16).data(String::UTF8));
+
+      const ByteVector latin1Data(latin1.data(), static_cast<unsigned int>(latin1.size()));
+      const String fromLatin1(latin1Data, String::Latin1);
+      CPPUNIT_ASSERT_EQUAL(latin1Data, fromLatin1.data(String::Latin1));
+      CPPUNIT_ASSERT_EQUAL(fromLatin1, String(fromLatin1.toWString()));
+      CPPUNIT_ASSERT_EQUAL(latin1.find('\xe9') == std::string::npos, fromLatin1.isAscii());
+    }
+
+    // Unpaired surrogates cannot be converted.
+    CPPUNIT_ASSERT(String(std::wstring(20, L'a') + wchar_t(0xdc00)).data(String::UTF8).isEmpty());
+    CPPUNIT_ASSERT(String(std::wstring(20, L'a') + wchar_t(0xd800)).data(String::UTF8).isEmpty());
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestString);
@@ -23,6 +23,8 @@
  *   http://www.mozilla.org/MPL/                                           *
  ***************************************************************************/
 
+#include <utility>
+
 #include "id3v2synchdata.h"
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -41,6 +43,8 @@ class TestID3v2SynchData : public CppUnit::TestFixture
   CPPUNIT_TEST(testDecode2);
   CPPUNIT_TEST(testDecode3);
   CPPUNIT_TEST(testDecode4);
+  CPPUNIT_TEST(testDecodeInPlace);
+  CPPUNIT_TEST(testEncode);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -121,6 +125,64 @@ public:
     CPPUNIT_ASSERT_EQUAL(ByteVector("\xff\xff\xff", 3), a);
   }
 
+
+  void testDecodeInPlace()
+  {
+    // Not shared and nothing to remove: the data is used as it is.
+    ByteVector a(100, '\xff');
+    const char *data = std::as_const(a).data();
+    ID3v2::SynchData::decodeInPlace(a);
+    CPPUNIT_ASSERT_EQUAL(ByteVector(100, '\xff'), a);
+    CPPUNIT_ASSERT(std::as_const(a).data() == data);
+
+    // The pairs are removed after the offset only.
+    ByteVector b("\xff\x00" "ab\xff\x00\x00" "cd", 8);
+    ID3v2::SynchData::decodeInPlace(b, 2);
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\xff\x00" "ab\xff\x00" "cd", 7), b);
+
+    // A copy sharing the data is not changed.
+    ByteVector c(1000, 'x');
+    for(unsigned int i = 0; i + 1 < c.size(); i += 37) {
+      c[i] = '\xff';
+      c[i + 1] = '\x00';
+    }
+    const ByteVector original = c;
+    ID3v2::SynchData::decodeInPlace(c);
+    CPPUNIT_ASSERT_EQUAL(1000U - 27U, c.size());
+    CPPUNIT_ASSERT_EQUAL(1000U, original.size());
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\xff" "xxx", 4), c.mid(36, 4));
+  }
+
+  void testEncode()
+  {
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\xff\x00\x00", 3),
+                         ID3v2::SynchData::encode(ByteVector("\xff\x00", 2)));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("\xff\x00\xe0\xff\x44", 5),
+                         ID3v2::SynchData::encode(ByteVector("\xff\xe0\xff\x44", 4)));
+    CPPUNIT_ASSERT_EQUAL(ByteVector("a\xff\x00\xff\x00", 5),
+                         ID3v2::SynchData::encode(ByteVector("a\xff\xff", 3)));
+    CPPUNIT_ASSERT_EQUAL(ByteVector(), ID3v2::SynchData::encode(ByteVector()));
+
+    // The encoded data contains no false syncs and decodes to the original.
+    unsigned int seed = 1;
+    for(unsigned int size = 1; size < 300; size += 7) {
+      ByteVector data(size);
+      for(auto &c : data) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned int r = (seed >> 16) % 4;
+        c = static_cast<char>(r == 0 ? 0xff : r == 1 ? 0x00 : r == 2 ? 0xe5 : seed >> 8);
+      }
+      const ByteVector encoded = ID3v2::SynchData::encode(data);
+      for(unsigned int i = 0; i + 1 < encoded.size(); ++i) {
+        if(encoded[i] == '\xff') {
+          CPPUNIT_ASSERT((static_cast<unsigned char>(encoded[i + 1]) & 0xe0) != 0xe0);
+        }
+      }
+      CPPUNIT_ASSERT(!encoded.endsWith("\xff"));
+      CPPUNIT_ASSERT_EQUAL(data, ID3v2::SynchData::decode(encoded));
+    }
+  }
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestID3v2SynchData);
@@ -34,12 +34,14 @@
 
 #include "taglib_config.h"
 
+#include "fileref.h"
 #include "id3v2framefactory.h"
 #include "id3v2synchdata.h"
 #include "id3v2tag.h"
 #include "mpegfile.h"
 #include "tbytevector.h"
 #include "tbytevectorstream.h"
+#include "tdebuglistener.h"
 #include "tstringlist.h"
 #include "textidentificationframe.h"
 #include "tpropertymap.h"
@@ -65,6 +67,10 @@ class TestThreadSafety : public CppUnit::TestFixture
 {
   CPPUNIT_TEST_SUITE(TestThreadSafety);
   CPPUNIT_TEST(testConcurrentLazyInitialization);
+  CPPUNIT_TEST(testReadMany);
+  CPPUNIT_TEST(testReadManyStreams);
+  CPPUNIT_TEST(testConcurrentSharedSettings);
+  CPPUNIT_TEST(testConcurrentResolverRegistration);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -147,6 +153,15 @@ public:
   {
     const ByteVector id3v23Data = id3v23TagWithIpls();
 
+    // A shared string held in UTF-8 is converted to UTF-16 only once.
+    const String utf8String(ByteVector("Ma\xc3\xb1" "ana"), String::UTF8);
+    CPPUNIT_ASSERT_EQUAL(threadCount, runConcurrently([utf8String] {
+      if(std::wstring(utf8String.toCWString()) != L"Ma\x00f1" L"ana" ||
+         utf8String[2] != 0xf1) {
+        throw std::runtime_error("UTF-8 string was not converted");
+      }
+    }));
+
     CPPUNIT_ASSERT_EQUAL(threadCount, runConcurrently([] {
       if(ID3v2::TextIdentificationFrame::involvedPeopleMap().size() != 5) {
         throw std::runtime_error("unexpected involvedPeopleMap() contents");
@@ -203,6 +218,169 @@ public:
     CPPUNIT_ASSERT(file.hasID3v2Tag());
     CPPUNIT_ASSERT_EQUAL(1u, file.ID3v2Tag()->frameList("TMCL").size());
   }
+
+  void testReadMany()
+  {
+    const std::vector<std::string> paths {
+      testFilePath("xing.mp3"),
+      testFilePath("missing-file.mp3"),
+      testFilePath("bladeenc.mp3"),
+      testFilePath("unsupported-extension.xx"),
+      testFilePath("empty1s.aac"),
+      testFilePath("has-tags.m4a"),
+    };
+
+    List<FileName> fileNames;
+    for(const auto &path : paths)
+      fileNames.append(path.c_str());
+
+    const List<FileRef::ReadResult> results = FileRef::readMany(fileNames, true, AudioProperties::Average, 4);
+    CPPUNIT_ASSERT_EQUAL(fileNames.size(), results.size());
+
+    for(unsigned int i = 0; i < results.size(); ++i) {
+      const FileRef::ReadResult &result = results[i];
+      const FileRef ref(fileNames[i]);
+      CPPUNIT_ASSERT_EQUAL(!ref.isNull(), result.isValid);
+      CPPUNIT_ASSERT_EQUAL(result.isValid, result.error.isEmpty());
+      if(!result.isValid)
+        continue;
+
+      CPPUNIT_ASSERT(ref.properties() == result.properties);
+      CPPUNIT_ASSERT_EQUAL(ref.complexPropertyKeys().size(), result.complexProperties.size());
+      CPPUNIT_ASSERT(result.hasAudioProperties);
+      CPPUNIT_ASSERT_EQUAL(ref.audioProperties()->lengthInMilliseconds(), result.lengthInMilliseconds);
+      CPPUNIT_ASSERT_EQUAL(ref.audioProperties()->bitrate(), result.bitrate);
+      CPPUNIT_ASSERT_EQUAL(ref.audioProperties()->sampleRate(), result.sampleRate);
+      CPPUNIT_ASSERT_EQUAL(ref.audioProperties()->channels(), result.channels);
+    }
+
+    CPPUNIT_ASSERT(!results[1].isValid);
+    CPPUNIT_ASSERT(!results[3].isValid);
+#ifdef TAGLIB_WITH_MP4
+    CPPUNIT_ASSERT(results[5].complexProperties.contains("PICTURE"));
+#endif
+
+    CPPUNIT_ASSERT(FileRef::readMany(List<FileName>()).isEmpty());
+  }
+
+  void testReadManyStreams()
+  {
+    const ByteVector data = PlainFile(TEST_FILE_PATH_C("xing.mp3")).readAll();
+
+    std::vector<std::unique_ptr<ByteVectorStream>> streams;
+    List<IOStream *> streamList;
+    for(int i = 0; i < 32; ++i) {
+      streams.push_back(std::make_unique<ByteVectorStream>(data));
+      streamList.append(streams.back().get());
+    }
+
+    const List<FileRef::ReadResult> results = FileRef::readMany(streamList, true, AudioProperties::Fast);
+    CPPUNIT_ASSERT_EQUAL(32U, results.size());
+    for(const auto &result : results) {
+      CPPUNIT_ASSERT(result.isValid);
+      CPPUNIT_ASSERT_EQUAL(44100, result.sampleRate);
+    }
+  }
+
+  void testConcurrentSharedSettings()
+  {
+    class CountingListener : public DebugListener
+    {
+    public:
+      void printMessage(const String &) override { ++count; }
+      std::atomic<int> count { 0 };
+    };
+
+    class NullResolver : public FileRef::StreamTypeResolver
+    {
+    public:
+      File *createFile(FileName, bool, AudioProperties::ReadStyle) const override
+      {
+        return nullptr;
+      }
+      File *createFileFromStream(IOStream *, bool, AudioProperties::ReadStyle) const override
+      {
+        return nullptr;
+      }
+    };
+
+    // A private factory, so that the default one is not changed for the
+    // other tests.
+
+    class Factory : public ID3v2::FrameFactory
+    {
+    };
+
+    CountingListener listener;
+    NullResolver resolver;
+    Factory factory;
+    const ByteVector data = PlainFile(TEST_FILE_PATH_C("xing.mp3")).readAll();
+    std::atomic<int> round { 0 };
+
+    // The resolvers, the debug listener and the default text encoding are
+    // changed while files are opened in the other threads.
+
+    CPPUNIT_ASSERT_EQUAL(threadCount, runConcurrently([&] {
+      if(round++ % threadCount == 0) {
+        FileRef::addFileTypeResolver(&resolver);
+        setDebugListener(&listener);
+        factory.setDefaultTextEncoding(String::UTF8);
+        FileRef::clearFileTypeResolvers();
+        setDebugListener(nullptr);
+      }
+      ByteVectorStream stream(data);
+      if(FileRef(&stream).isNull())
+        throw std::runtime_error("file was not opened");
+      if(!MPEG::File(&stream, true, MPEG::Properties::Average, &factory).isValid())
+        throw std::runtime_error("file was not opened");
+    }));
+
+    FileRef::clearFileTypeResolvers();
+    setDebugListener(nullptr);
+  }
+
+  void testConcurrentResolverRegistration()
+  {
+    class CountingResolver : public FileRef::StreamTypeResolver
+    {
+    public:
+      File *createFile(FileName, bool, AudioProperties::ReadStyle) const override
+      {
+        return nullptr;
+      }
+      File *createFileFromStream(IOStream *, bool, AudioProperties::ReadStyle) const override
+      {
+        ++count;
+        return nullptr;
+      }
+      mutable std::atomic<int> count { 0 };
+    };
+
+    constexpr int resolversPerThread = 25;
+    std::vector<CountingResolver> resolvers(threadCount * resolversPerThread);
+    std::atomic<int> nextResolver { 0 };
+    const ByteVector data = PlainFile(TEST_FILE_PATH_C("xing.mp3")).readAll();
+
+    // Resolvers are added from all threads while files are opened, none of
+    // the additions may be lost.
+
+    CPPUNIT_ASSERT_EQUAL(threadCount, runConcurrently([&] {
+      FileRef::addFileTypeResolver(&resolvers[nextResolver++]);
+      ByteVectorStream stream(data);
+      if(FileRef(&stream).isNull())
+        throw std::runtime_error("file was not opened");
+    }));
+
+    for(auto &resolver : resolvers)
+      resolver.count = 0;
+
+    ByteVectorStream stream(data);
+    CPPUNIT_ASSERT(!FileRef(&stream).isNull());
+    for(const auto &resolver : resolvers)
+      CPPUNIT_ASSERT_EQUAL(1, resolver.count.load());
+
+    FileRef::clearFileTypeResolvers();
+  }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestThreadSafety);
@@ -130,6 +130,56 @@ namespace TagLib {
 
 #endif
 
+#ifdef TAGLIB_FILESTREAM_H
+
+namespace TagLib {
+
+  // Data for a payload which is deferred by saveWithDeferredPayloads().
+
+  inline ByteVector deferredPayload()
+  {
+    ByteVector data;
+    for(int i = 0; i < 5000; ++i)
+      data.append(static_cast<char>(i % 251));
+    return data;
+  }
+
+  // Opens fileName with the payloads of more than maxPayloadSize bytes
+  // deferred and passes it to checkDeferred().  The title is changed and the
+  // file is saved with save() before the payloads are loaded, then it is
+  // opened again and passed to checkSaved().
+
+  template <class FileT, class CheckDeferred, class CheckSaved, class Save>
+  void saveWithDeferredPayloads(const string &fileName, offset_t maxPayloadSize,
+                                const CheckDeferred &checkDeferred,
+                                const CheckSaved &checkSaved, const Save &save)
+  {
+    {
+      FileStream stream(fileName.c_str());
+      stream.setMaxPayloadSize(maxPayloadSize);
+      FileT f(&stream);
+      checkDeferred(f, stream);
+      f.tag()->setTitle("Deferred");
+      save(f);
+    }
+    {
+      FileT f(fileName.c_str());
+      CPPUNIT_ASSERT_EQUAL(String("Deferred"), f.tag()->title());
+      checkSaved(f);
+    }
+  }
+
+  template <class FileT, class CheckDeferred, class CheckSaved>
+  void saveWithDeferredPayloads(const string &fileName, const CheckDeferred &checkDeferred,
+                                const CheckSaved &checkSaved)
+  {
+    saveWithDeferredPayloads<FileT>(fileName, 1024, checkDeferred, checkSaved,
+                                    [](FileT &f) { f.save(); });
+  }
+} // namespace TagLib
+
+#endif
+
 class ScopedFileCopy
 {
 public: